@@ -8,6 +8,67 @@
 #include "float.h"
 #include <bitset>
 #include <iostream>
+#include <cstdio>
+#include <algorithm>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <climits>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <new>
+#include <cstdlib>
+#include <chrono>
+#include <cctype>
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #define NOGDI // keep windows.h from clashing with raylib's Rectangle, CloseWindow, DrawText, LoadImage...
+    #define NOUSER
+    #define NOMINMAX
+    #include <windows.h> // for mapping project files
+    #include <io.h>
+    #include <fcntl.h>
+    #undef near
+    #undef far
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// the upload ring's gl calls. rlgl doesnt wrap pixel buffer objects or fences, so they are loaded through glfw, which raylib is built on
+#if defined(_WIN32)
+    #define GLAPIENTRY __stdcall
+#else
+    #define GLAPIENTRY
+#endif
+
+#ifndef GL_PIXEL_UNPACK_BUFFER
+    #define GL_PIXEL_UNPACK_BUFFER          0x88EC
+    #define GL_COPY_READ_BUFFER             0x8F36
+    #define GL_COPY_WRITE_BUFFER            0x8F37
+    #define GL_STREAM_DRAW                  0x88E0
+    #define GL_MAP_WRITE_BIT                0x0002
+    #define GL_MAP_INVALIDATE_BUFFER_BIT    0x0008
+    #define GL_MAP_UNSYNCHRONIZED_BIT       0x0020
+    #define GL_SYNC_GPU_COMMANDS_COMPLETE   0x9117
+    #define GL_SYNC_FLUSH_COMMANDS_BIT      0x0001
+    #define GL_ALREADY_SIGNALED             0x911A
+    #define GL_TIMEOUT_EXPIRED              0x911B
+    #define GL_CONDITION_SATISFIED          0x911C
+    #define GL_TEXTURE_2D                   0x0DE1
+    #define GL_RED                          0x1903
+    #define GL_RGBA                         0x1908
+    #define GL_UNSIGNED_BYTE                0x1401
+    #define GL_FLOAT                        0x1406
+#endif
+
+typedef void (*GLFWglproc)(void);
+extern "C" GLFWglproc glfwGetProcAddress(const char* procname);
 
 
 
@@ -67,6 +128,19 @@ enum class HeightMapMode
     RAINBOW
 };
 
+enum class HeightmapFormat // file formats a heightmap can be saved and loaded as
+{
+    GRAYSCALE, // 8 bit grayscale png
+    SPLIT, // the 32 bit value split across all 4 channels of a png
+    PNG16, // 16 bit grayscale png
+    R16, // raw 16 bit unsigned ints, little endian, square
+    R32F, // raw 32 bit floats, little endian, square. the heights as they are, not scaled to 0 to 1
+    PROJECT, // .pangea project. keeps the canvas layout, settings, selection and history
+    OBJ, // decimated mesh, wavefront obj. save only
+    GLB, // decimated mesh, binary gltf. save only
+    TILES // 16 bit png chunks with mip levels and a .json manifest. save only
+};
+
 // Camera move modes (first person and third person cameras)
 typedef enum 
 { 
@@ -110,6 +184,509 @@ struct HistoryStep
     std::vector<Vector2> modelCoords; // list of the model coordinates recorded by this step, sorted left to right, top to bottom
 };
 
+struct PngStream // a png being written one row at a time, deflated as it goes
+{
+    FILE* file;
+    unsigned int adler; // running adler32 of the uncompressed image data
+    bool zlibStarted; // whether the zlib header has been written yet
+    int pixelSize; // bytes per pixel, how far back the sub filter looks
+    std::vector<unsigned char> buffer; // the chunk being assembled, holds at most one row
+    std::vector<unsigned char> window; // filtered rows already written, as far back as deflate can match, then the current row
+    long long windowStart; // stream position of window[0]
+    std::vector<long long> hashHead; // latest stream position each 3 byte hash was seen at, -1 for none
+    std::vector<long long> hashPrevious; // the position before it with the same hash, by position modulo the window
+    unsigned int bitBuffer; // deflate bits not yet making a whole byte, carried on to the next row's chunk
+    int bitCount;
+};
+
+struct TileChunk // one chunk of a tiled export, as listed in its manifest
+{
+    int width; // in vertices. chunks on the far edges of the map can be smaller
+    int height;
+    float minY;
+    float maxY;
+    bool written;
+};
+
+struct MappedFile // a file mapped read only into memory
+{
+    unsigned char* data;
+    unsigned long long size;
+#if defined(_WIN32)
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#endif
+};
+
+#define PROJECT_MAGIC "PANGEA\0\0"
+#define PROJECT_VERSION 2 // 2 allows compressed model heights
+#define PROJECT_ALIGNMENT 4096 // model height blocks start on page boundaries
+#define PROJECT_HEADER_SIZE 56 // bytes the header is written as
+#define PROJECT_TILE_ENTRY_SIZE 24
+
+// .pangea layout: header, tile index (one entry per model, column by column), one block of modelVertexWidth*modelVertexHeight floats per model, then the trailer with the settings, selection and history
+// everything is written a field at a time, little endian, in the order the structs list them. the sizes and the two padding bytes after ProjectSettings' bools are the layout earlier versions got from writing the structs whole
+struct ProjectHeader
+{
+    char magic[8];
+    unsigned int version;
+    int canvasWidth; // in number of models
+    int canvasHeight;
+    int modelVertexWidth;
+    int modelVertexHeight;
+    unsigned int tileBlockSize; // bytes reserved for each model's heights
+    unsigned long long tileIndexOffset;
+    unsigned long long trailerOffset;
+    unsigned long long trailerSize;
+};
+
+struct ProjectTileEntry
+{
+    unsigned long long offset; // where this model's heights start in the file
+    unsigned int size; // size of the heights in bytes
+    float minY; // lowest height in this model
+    float maxY; // highest height in this model
+    unsigned int compressed; // 1 if the heights are zlib compressed, size is then the compressed size. always 0 in version 1
+};
+
+struct ProjectSettings // editor state saved in a project
+{
+    float selectRadius;
+    float toolStrength;
+    float stampAngle;
+    float stampHeight;
+    float innerRadius;
+    float stampStretchLength;
+    float stampRotationAngle;
+    float stampSlope;
+    float stampOffset;
+    int brush;
+    int heightMapMode;
+    bool raiseOnly;
+    bool lowerOnly;
+    bool stampFlip;
+    bool stampInvert;
+    bool stampStretch;
+    bool rayCollision2d;
+    Vector3 cameraPosition;
+    Vector3 cameraTarget;
+};
+
+struct Project // the .pangea file last saved or opened
+{
+    std::string fileName;
+    int canvasWidth = 0; // canvas size when it was last saved or opened. if it changes the whole file is rewritten
+    int canvasHeight = 0;
+    int modelVertexWidth = 0; // model size then too, for the same reason
+    int modelVertexHeight = 0;
+    std::vector<std::vector<unsigned int>> savedRevisions; // model revisions as of the last save or open. models whose revision has changed since are the ones written on save
+};
+
+struct PagedModel // residency of one model
+{
+    long long slot = -1; // where its heights are kept in the page file, -1 until it is first paged out
+    long long block = -1; // its entry in the pager's project index if it came from an opened project. read from there while slot is still -1
+    unsigned long long lastUsed = 0; // pager tick it was last needed on. the least recently used models are paged out first
+    float minY = 0; // height range as of when it was paged out, for picking and texture ranges while it isnt loaded
+    float maxY = 0;
+    bool loading = false; // waiting on the background thread
+};
+
+struct PageLoad // a model being loaded in the background
+{
+    int x;
+    int y;
+    long long slot;
+    long long block;
+    unsigned int generation; // pager generation it was requested in. loads from before the canvas was replaced are thrown away
+    Mesh mesh; // built on the background thread, not uploaded yet
+};
+
+struct ModelPager // keeps only the models near the camera or being edited loaded. the rest wait in a page file on disk
+{
+    std::vector<std::vector<Model>>* models = NULL;
+    std::vector<std::vector<PagedModel>> pages;
+    float* highestY = NULL; // used to texture models as they come back
+    float* lowestY = NULL;
+    HeightMapMode* heightMapMode = NULL;
+    int modelVertexWidth = 0;
+    int modelVertexHeight = 0;
+    int modelWidth = 0;
+    int modelHeight = 0;
+    unsigned long long tick = 1; // advanced once per frame
+    long long slotCount = 0; // slots handed out in the page file
+    unsigned int generation = 0;
+    std::string fileName;
+    FILE* file = NULL;
+    FILE* projectFile = NULL; // the .pangea last opened, models that havent been loaded since are read from their blocks in it
+    std::vector<ProjectTileEntry> projectIndex; // its blocks as of when it was opened. saves only ever append to the file or replace it whole, so they stay readable
+    std::mutex fileMutex; // the page file and project file are read from the background thread
+    
+    std::thread worker;
+    std::mutex mutex; // guards everything below
+    std::condition_variable wake; // the worker waits on this for requests
+    std::condition_variable done; // RequireModel waits on this for the load in flight
+    std::deque<PageLoad> requests;
+    std::vector<PageLoad> results;
+    PageLoad current; // the load in flight
+    bool busy = false; // whether current is in flight
+    bool quit = false;
+};
+
+enum class SnapshotState : unsigned char
+{
+    NONE, // not part of the autosave
+    PENDING, // still the same as when the snapshot was taken, the writer reads it straight from the model
+    COPIED, // about to change, so its heights were copied for the writer first
+    WRITTEN
+};
+
+struct SnapshotModel
+{
+    SnapshotState state = SnapshotState::NONE;
+    long long slot = -1; // page file slot if it was paged out when the snapshot was taken
+    long long block = -1; // or its project block, if it hadnt been loaded since the project was opened
+    std::vector<float> heights; // the copy, for COPIED
+};
+
+struct Autosave // periodic save of the canvas to its own project file, written on a background thread
+{
+    Project project; // the autosave file, kept apart from the user's so each autosave only writes what changed since the last one
+    std::string fileName;
+    float timer = 0; // seconds since the last autosave
+    std::thread writer;
+    std::atomic<bool> running{false}; // a snapshot is being written
+    std::mutex mutex; // guards models while running
+    std::vector<std::vector<unsigned int>> revisions; // model revisions the snapshot was taken at
+    std::vector<std::vector<SnapshotModel>> models;
+    std::vector<unsigned char> trailer;
+};
+
+template<int N>
+struct FixedTileGeometry // a model size known at compile time, so the index math in the hot loops folds into constants. N is the vertices along each side
+{
+    static constexpr int width = N;
+    static constexpr int height = N;
+};
+
+struct TileGeometry // any model size, known only at run time
+{
+    int width;
+    int height;
+};
+
+struct DecimatedCell // a leaf of a model's decimation quadtree. in vertices from the model's top left, width and height in quads
+{
+    int x;
+    int z;
+    int width;
+    int height;
+};
+
+struct DecimatedModel // one model's part of a mesh export
+{
+    int x; // model coordinates
+    int y;
+    std::vector<float> heights; // full resolution, row by row
+    std::vector<DecimatedCell> cells;
+    std::vector<unsigned char> used; // vertices that are a corner of a cell here or, on the border, in the neighbouring model
+    std::vector<float> vertices; // 3 per vertex, in place on the canvas
+    std::vector<int> vertexGrid; // grid index each vertex came from, -1 for the vertices added in the middle of cells
+    std::vector<unsigned int> indices;
+};
+
+struct VertexLattice // every vertex of a square model, indexed both by lattice point and by vertex. built once per model size and never changed after
+{
+    int width;
+    std::vector<int> offsets; // where each lattice point's vertices start in indices, read left right, top down. has one extra entry at the end
+    std::vector<int> indices; // index in Mesh::vertices of every vertex, grouped by lattice point
+    std::vector<Vector2> coords; // lattice point of every vertex, by its index in Mesh::vertices / 3
+};
+
+struct VertexIndexSpan // the vertices at one lattice point. points into a VertexLattice so it doesnt own or allocate anything
+{
+    const int* first;
+    int count;
+    
+    int operator[](int i) const { return first[i]; }
+    int size() const { return count; }
+    const int* begin() const { return first; }
+    const int* end() const { return first + count; }
+};
+
+struct LatticeCopy // one model's copy of a lattice point. models repeat the row and column on the edges they share, so a point can be in up to four
+{
+    int modelX;
+    int modelY;
+    int x;
+    int z;
+};
+
+struct FrameArena // memory for containers that only last one tick. allocating just moves an offset along, and it is all given back at once when the tick ends
+{
+    unsigned char* memory = NULL;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t peak = 0; // most asked for in one tick, including what didnt fit
+    int allocations = 0; // allocations made this tick
+    std::vector<void*> overflow; // heap blocks for what didnt fit. freed at the reset, and the arena grows so they arent needed next tick
+};
+
+void* FrameAllocate(size_t size, size_t alignment); // memory from the calling thread's frame arena, valid until the end of the tick, or the edit on the simulation thread
+
+template<class T>
+struct FrameAllocator // lets std containers take their memory from the frame arena. nothing is freed until the arena is reset, so the containers cant outlive the tick
+{
+    typedef T value_type;
+    
+    FrameAllocator() {}
+    template<class U> FrameAllocator(const FrameAllocator<U>&) {}
+    
+    T* allocate(size_t count) { return (T*)FrameAllocate(count * sizeof(T), alignof(T)); }
+    void deallocate(T*, size_t) {}
+    
+    template<class U> bool operator==(const FrameAllocator<U>&) const { return true; }
+    template<class U> bool operator!=(const FrameAllocator<U>&) const { return false; }
+};
+
+template<class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+struct BatchCanvas // the map a batch run works on. one height grid for the whole map, models are only built from it to export
+{
+    std::vector<float> heights;
+    int width = 0;
+    int height = 0;
+    int tileResolution = 0; // vertices along each side of the models built for exports
+};
+
+struct StampParams
+{
+    float influenceRadius; // select radius expanded by inner radius
+    float innerRadius; // radius of the flat top (or bottom when flipped) of the stamp
+    float slopeRatio; // rise to run ratio of the stamp's sides, determined by the stamp angle
+    float heightCap; // max height that can be produced by the select radius and stamp angle
+    float offset; // amount to raise or lower the stamp
+    float baseY; // height the stamp is placed on. the hit position y when the cursor mode is 3d, 0 otherwise
+    float cutOff; // vertices wont be raised above this height. 0 for no cut off
+    bool flip; // whether the stamp is upside down
+    bool invert; // whether the stamp is mirrored vertically
+    bool raiseOnly; // only allow vertices to be raised
+    bool lowerOnly; // only allow vertices to be lowered
+};
+
+enum class JournalCommandType : unsigned char
+{
+    DAB, // one tick of a brush
+    STROKE_END, // the mouse was released, closing the history step the dabs went into
+    UNDO,
+    REDO,
+    DESELECT, // the vertex selection was cleared
+    TRAIL, // the trail tool was run on the vertex selection
+    SMOOTH_MODELS // every vertex of a rectangle of models was smoothed
+};
+
+struct JournalCommand // one recorded edit, with everything it needs already worked out so replaying it doesnt depend on the ui. a journal is its header then these, each written a field at a time, little endian, in the order they are listed here
+{
+    float time; // seconds since recording started
+    JournalCommandType type;
+    unsigned char brush; // BrushTool of a dab
+    unsigned char flags; // JOURNAL_ bits
+    Vector3 position; // where the brush hit
+    float modelRadius; // the models a dab edits are found within this of position
+    float vertexRadius; // the vertices a dab edits are found within this of position
+    float strength; // elevation tool strength
+    StampParams stamp; // the stamp as it was worked out for this dab, after dragging and slope
+    Vector2 stampPoints[2]; // ends of a stretched stamp
+    Vector2 topLeft; // the models a SMOOTH_MODELS works on
+    Vector2 bottomRight;
+};
+
+struct JournalHeader
+{
+    char magic[8];
+    int version;
+    int canvasWidth; // the canvas the journal was recorded on, in models. it only replays onto one the same size
+    int canvasHeight;
+    int modelVertexWidth;
+    int modelVertexHeight;
+    int maxSteps; // history length when it was recorded, undo and redo depend on it
+    unsigned long long checksum; // CanvasChecksum of the canvas when recording started. it only replays onto one with the same heights, not one that already has the edits
+};
+
+struct TaskGroup;
+
+struct Task
+{
+    std::function<void()> run;
+    TaskGroup* group; // told when it is done
+};
+
+struct TaskGroup // tasks waited for together. tasks can also be held back until every task in another group is done
+{
+    std::atomic<int> pending{0}; // submitted and not done yet, including held back ones
+    std::mutex mutex; // guards continuations
+    std::vector<Task> continuations; // held back until pending is 0
+};
+
+struct TaskQueue // one per pool thread. its thread takes from the back, the newest and likely still in cache, other threads steal from the front
+{
+    std::mutex mutex;
+    std::deque<Task> tasks;
+};
+
+struct TaskPool // threads shared by every part of the editor and batch that has work to spread across cores. never makes gl calls, those stay on the main thread
+{
+    std::vector<std::thread> threads;
+    std::deque<TaskQueue> queues; // one per pool thread, at least one so tasks have somewhere to go when there are no pool threads. a deque because the mutexes cant move
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> queued{0}; // tasks in the queues
+    std::atomic<unsigned int> nextQueue{0}; // round robin for tasks from threads outside the pool
+    bool quit = false;
+    
+    std::atomic<long long> busyTime{0}; // nanoseconds spent running tasks, on any thread, since the stats were last taken
+    std::atomic<int> tasksRun{0};
+    std::atomic<int> tasksStolen{0}; // run by a pool thread other than the one whose queue they were in
+    std::chrono::steady_clock::time_point statsStart;
+};
+
+struct TaskPoolStats
+{
+    int threads; // counting the main thread, which runs tasks while it waits on them
+    float busy; // fraction of those threads' time spent in tasks
+    int tasks;
+    int stolen;
+};
+
+struct HeightmapShader // colors the canvas on the gpu from each vertex's height and normal, in the palettes GenHeightmap bakes into textures. the range and mode are uniforms, so changing them costs nothing
+{
+    bool enabled = false;
+    Shader shader;
+    Material material; // shared by every model while the shader is on
+    int highestYLoc;
+    int lowestYLoc;
+    int slopeToleranceLoc;
+    int modeLoc;
+};
+
+struct DisplacementGrid // draws every tile from one flat grid mesh, moved up in the vertex shader by the tile's float height texture. tiles keep no vertex buffers, and edits only update texels
+{
+    bool enabled = false;
+    HeightmapShader palette; // the heightmap shader's colors on the displacement vertex shader
+    int spacingLoc;
+    Mesh grid = { 0 }; // shared by every tile, built for the canvas resolution
+    int gridWidth = 0;
+    int gridHeight = 0;
+    Vector2 spacing; // distance between grid points
+};
+
+struct StagingBuffer // memory an upload is made from. with gl, a pixel buffer object mapped while it is written, so the upload is a copy the gpu makes on its own time
+{
+    unsigned char* memory = NULL; // NULL while a pixel buffer object is unmapped
+    size_t capacity = 0;
+    unsigned int pbo = 0; // 0 without pixel buffer objects, memory is malloced then
+    void* fence = NULL; // GLsync set after the last upload from it. it isnt written again until the gpu has passed it
+    bool pending = false; // handed out and not uploaded from yet
+};
+
+struct StagingGl // the gl 3.3 entry points the upload ring needs
+{
+    void (GLAPIENTRY *genBuffers)(int n, unsigned int* buffers);
+    void (GLAPIENTRY *bindBuffer)(unsigned int target, unsigned int buffer);
+    void (GLAPIENTRY *bufferData)(unsigned int target, ptrdiff_t size, const void* data, unsigned int usage);
+    void* (GLAPIENTRY *mapBufferRange)(unsigned int target, ptrdiff_t offset, ptrdiff_t length, unsigned int access);
+    unsigned char (GLAPIENTRY *unmapBuffer)(unsigned int target);
+    void (GLAPIENTRY *copyBufferSubData)(unsigned int readTarget, unsigned int writeTarget, ptrdiff_t readOffset, ptrdiff_t writeOffset, ptrdiff_t size);
+    void (GLAPIENTRY *bindTexture)(unsigned int target, unsigned int texture);
+    void (GLAPIENTRY *texSubImage2D)(unsigned int target, int level, int xoffset, int yoffset, int width, int height, unsigned int format, unsigned int type, const void* pixels);
+    void* (GLAPIENTRY *fenceSync)(unsigned int condition, unsigned int flags);
+    unsigned int (GLAPIENTRY *clientWaitSync)(void* sync, unsigned int flags, unsigned long long timeout);
+    void (GLAPIENTRY *deleteSync)(void* sync);
+};
+
+struct UploadStats
+{
+    int uploads;
+    long long bytes;
+    int stalls; // staging buffers waited for, the gpu hadnt passed their fences or they hadnt been uploaded from
+};
+
+struct UploadRing // staging buffers for uploads, handed out in turn so the cpu writes straight into memory the upload is made from, instead of allocating for each one
+{
+    std::deque<StagingBuffer> buffers; // a deque so growing it doesnt move the buffers handed out
+    int next = 0;
+    bool pbo = false; // pixel buffer objects and fences are in use
+    StagingGl gl;
+    
+    void (*uploadBuffer)(StagingBuffer& staging, unsigned int bufferId, int size) = NULL; // the gl calls. swapped for stubs to run the cpu side without a context
+    void (*uploadTexture)(StagingBuffer* staging, Texture2D texture, const void* pixels) = NULL; // staging is NULL if the pixels arent from the ring
+    
+    UploadStats stats = {}; // this frame so far
+};
+
+struct TileJob // work put off for one model
+{
+    int x;
+    int y;
+    unsigned char work; // TILE_JOB_ bits, done in the order they are listed
+    unsigned int deadline; // the frame it has to be done by, however busy the frame is
+};
+
+struct TileScheduler // per model work spread over frames, a few milliseconds a frame, nearest the camera first
+{
+    std::vector<TileJob> jobs; // at most one per model, scheduling more work for a model adds to its job
+    unsigned int frame = 0;
+    bool enabled = false; // only the editor draws anything. without it there is nothing to catch up and jobs are dropped
+};
+
+struct Journal // the journal being recorded. commands are only ever appended
+{
+    FILE* file = NULL;
+    std::chrono::steady_clock::time_point start;
+    int commandCount = 0;
+};
+
+struct SimulationCommand // an edit handed to the simulation thread, with the models and vertices the main thread found for it
+{
+    JournalCommand command;
+    ModelSelection editSelection;
+    std::vector<VertexState> vertexIndices;
+    int maxSteps;
+    int modelVertexWidth;
+    int modelVertexHeight;
+    int modelWidth;
+    int modelHeight;
+    bool findSelection; // picked while the canvas was busy, so the models and vertices are found when it is applied
+};
+
+struct TileCommit // a model a committed edit changed, and the tile jobs left to do for it
+{
+    int x;
+    int y;
+    unsigned char work;
+};
+
+struct Simulation // edits are applied on their own thread, so a long one doesnt hold up the camera and drawing
+{
+    std::thread thread;
+    std::mutex mutex; // guards commands, committed, loads and quit
+    std::condition_variable wake;
+    std::condition_variable loaded;
+    std::deque<SimulationCommand> commands; // the front one is being applied. a deque so it stays put while more are queued
+    std::vector<TileCommit> committed; // not taken by the main thread yet
+    std::vector<Vector2> loads; // paged out models the simulation thread is waiting on. the main thread loads them, it has the gl context
+    bool quit = false;
+    
+    std::mutex canvasMutex; // the meshes, history and vertex selection belong to whichever thread holds this
+    std::unique_lock<std::mutex> canvasLock{canvasMutex, std::defer_lock}; // the main thread's hold on it, for a tick at a time
+    
+    std::vector<std::vector<Model>>* models = NULL;
+    std::vector<VertexState>* vertexSelection = NULL;
+    std::vector<HistoryStep>* history = NULL;
+    int* stepIndex = NULL;
+};
+
 
 float xzDistance(Vector2 p1, Vector2 p2); // get the distance between two points on the x and z plane
 
@@ -119,30 +696,106 @@ Color* GenHeightmapSelection(const std::vector<std::vector<Model>>& models, cons
 
 Color* GenHeightmap(const Model& model, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode, float slopeTolerance = 59.0); // memory should be freed. generates a heightmap for a single model. used for the model texture, cuts last row and column so pixels and polys are 1:1. will update global highest and lowest Y
 
-Color* GenHeightmap(const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, float maxHeight, float minHeight, bool grayscale); // memory should be freed. generates a heightmap from the whole map. used for export
+void GenHeightmap(const Model& model, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode, Color* pixels, float slopeTolerance = 59.0); // the same into pixels, (modelVertexWidth - 1) * (modelVertexHeight - 1) of them. for writing straight into staging memory. the reference the heightmap shader matches
+
+void WidenHeightRange(const Model& model, float& highestY, float& lowestY); // takes the model's heights into the range
+
+void InitHeightmapShader(bool enabled, bool displaced); // compiles the shader, and the displacement one if displaced. if they dont compile the textures and the tiles' own meshes are used
+
+bool LoadHeightmapShader(HeightmapShader& palette, const char* vertexCode, const char* fragmentCode); // compiles and finds the uniforms. false if it didnt compile
+
+void SetHeightmapUniforms(const HeightmapShader& palette, float highestY, float lowestY, HeightMapMode mode);
+
+void TextureTile(Model& model, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode); // a new tile's heightmap texture, or displaced only its height texture. widens the range either way
+
+void DisplaceTile(Model& model, int modelVertexWidth, int modelVertexHeight); // when drawn displaced, gives the model a height texture from its vertices and lets go of its vertex buffers. does nothing otherwise
+
+void GetTileHeights(const Mesh& mesh, int modelVertexWidth, int modelVertexHeight, float* heights); // a height per vertex, row by row, out of the mesh's triangle soup
+
+void UploadTile(const Model& model); // after an edit. the vertices to the model's buffers, or its heights to its height texture when drawn displaced
+
+void SetHeightmapShader(bool enabled, std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode); // switches between the shader and the textures, bringing the textures up to date when they are switched back to
+
+void DrawCanvas(const std::vector<std::vector<Model>>& models, float highestY, float lowestY, HeightMapMode mode); // every loaded model, colored by the shader or its texture
+
 
 RayHitInfo GetCollisionRayModel2(Ray ray, const Model *model); // having a copy of GetCollisionRayModel increases performance for some reason
 
-void UpdateHeightmap(const Model& model, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode);
+void UpdateHeightmap(const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode); // with the heightmap shader on only the range is updated, the shader does the rest
 
-void UpdateHeightmap(const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode);
+VertexIndexSpan GetVertexIndices(int x, int y, int width); // get the Indices (x value) of all vertices at a particular location in the square mesh. x y start at 0 and read left right, top down
 
-std::vector<int> GetVertexIndices(int x, int y, int width); // get the Indices (x value) of all vertices at a particular location in the square mesh. x y start at 0 and read left right, top down
+const VertexLattice& GetVertexLattice(int width); // the lookup tables for a square model of this width, building them the first time it is asked for
+
+void BuildVertexLattice(VertexLattice& lattice, int width); // fill in the lookup tables for a square model of this width
+
+void ResetFrameArena(FrameArena& arena); // give back everything allocated this tick, growing the arena if the tick needed more than it had
+
+void RewindFrameArena(FrameArena& arena, size_t used, int overflowCount); // give back everything allocated since used and the overflow count were read off the arena. none of it can still be in use
 
 Vector2 GetVertexCoords(int index, int width); // get the coordindates of a vertex on a square mesh given its index. x y start at 0
 
 std::vector<Vector2> GetModelCoordsSelection(const std::vector<VertexState>& vsList); // get the coords of each unique model in a list of VertexState
 
-void ModelStitch(std::vector<std::vector<Model>>& models, const ModelSelection &modelSelection, int modelVertexWidth, int modelVertexHeight); // merges the overlapping vertices on the edges of adjacent models (no longer used)
+int GetLatticeCopies(int modelX, int modelY, int x, int z, int modelVertexWidth, int modelVertexHeight, int canvasWidth, int canvasHeight, LatticeCopy* copies); // every model's copy of the lattice point x, z of a model, that model first. copies needs room for 4. returns how many there are
+
+bool LatticeCopiesInSelection(const LatticeCopy* copies, int count, const ModelSelection& modelSelection); // true if every copy is in the selection's rectangle of models
+
+void SetLatticeHeight(std::vector<std::vector<Model>>& models, const LatticeCopy* copies, int count, float y, int modelVertexWidth); // the one way edits write a height. every copy of the point gets the same value, so the edges of adjacent models cant come apart
+
+void SetVertexHeight(std::vector<std::vector<Model>>& models, const VertexState& vertex, float y, int modelVertexWidth, int modelVertexHeight); // SetLatticeHeight for the lattice point a vertex is on
 
 void SetExSelection(ModelSelection& modelSelection, int canvasWidth, int canvasHeight); // populates a model selection's expanded selection, which is selection plus the adjacent models
 
-void FillTerrainCells(ModelSelection& modelSelection, const std::vector<std::vector<Model>>& models); // for model selections being used to track player collision. takes selection[0] and attempts to fill selection with the indices of the surrounding models 
 
-void UpdateCharacterCamera(Camera* camera, const std::vector<std::vector<Model>>& models, ModelSelection& terrainCells); // custom update camera function for character camera
+void UpdateCharacterCamera(Camera* camera, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, bool grounded); // custom update camera function for character camera. grounded false while an edit is being applied, it moves without reading the heights
+
+void PlaceCharacter(Vector3 position); // puts the player's feet at position and resets the character simulation. call when entering character mode
+
+bool StepCharacter(const std::vector<std::vector<Model>>& models, Vector3& position, Vector2 move, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, bool grounded); // tries to move the player on the x and z plane, snapped to the ground. returns false if the ground there is too steep or off the mesh. grounded false moves it level, only keeping it on the canvas
 
 void UpdateFreeCamera(Camera* camera); // camera update function for perspective mode
 
+void ScheduleTileJob(int x, int y, unsigned char work); // queues work for model x, y. it is done within TILE_JOB_MAX_DELAY frames
+
+void InitUploadRing(bool gl); // sizes the ring. gl false stubs the upload calls out, to run and time the cpu side on its own. with gl and no pixel buffer objects the uploads are made straight from the staging memory
+
+bool LoadStagingGl(StagingGl& gl); // false if any of them is missing
+
+StagingBuffer& AcquireStaging(size_t size); // the next staging buffer the gpu is done with, big enough for size. never one handed out and not uploaded from yet, the ring grows instead. main thread only, it maps gl buffers. the memory can be written from any thread until it is uploaded from or the frame ends
+
+bool StagingFencePassed(StagingBuffer& staging, bool wait); // true once the gpu is done with the last upload from it. wait blocks until it is
+
+void MapStaging(StagingBuffer& staging, size_t size);
+
+StagingBuffer* FindStaging(const void* memory); // the staging buffer memory is from, or NULL
+
+void UploadBuffer(unsigned int bufferId, const void* data, int size); // copied into staging memory and uploaded from there
+
+void UploadVertices(const Mesh& mesh); // the mesh's vertices and normals to its buffers
+
+void UploadTexture(Texture2D texture, const void* pixels); // pixels from staging memory, or anywhere else. 4 bytes each, colors or float heights
+
+UploadStats AdvanceUploadRing(); // once per frame. returns the stats for the frame that ended. buffers handed out and never uploaded from are taken back
+
+void UploadBufferGl(StagingBuffer& staging, unsigned int bufferId, int size);
+
+void UploadTextureGl(StagingBuffer* staging, Texture2D texture, const void* pixels);
+
+void UploadBufferStub(StagingBuffer& staging, unsigned int bufferId, int size);
+
+void UploadTextureStub(StagingBuffer* staging, Texture2D texture, const void* pixels);
+
+void ColorTiles(const std::vector<const Model*>& tiles, const std::vector<Texture2D>& textures, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode); // every tile's heightmap into staging memory on the pool and uploaded to its texture, half the ring at a time so the gpu copies one half while the other is filled
+
+bool ParseHeightMapMode(const char* name, HeightMapMode& mode); // mode from its name in a batch, grayscale slope or rainbow
+
+bool RunTileJobs(std::vector<std::vector<Model>>& models, Vector3 cameraPosition, int modelVertexWidth, int modelVertexHeight, int modelWidth, float& highestY, float& lowestY, HeightMapMode mode); // once per frame. does jobs nearest the camera first until TILE_JOB_BUDGET is used up, then any that cant wait any longer. returns true if it did anything or there are jobs left
+
+bool InputPressed(); // true if any key or mouse button was pressed, or a mouse button was released, this tick. the input ui actions and the ends of strokes happen on
+
+bool InputActive(); // true if the mouse moved or scrolled, or any key or mouse button is down or was released this tick. the camera only moves on input, so this covers it too
+
 void UpdateOrthographicCamera(Camera* camera); // camera update function for orthographic mode
 
 void PrintBoxInfo(Rectangle box, InputFocus currentFocus, InputFocus matchingFocus, const std::string& s, float info); // print into box using default text params
@@ -151,118 +804,494 @@ void PrintBoxInfo(Rectangle box, InputFocus currentFocus, InputFocus matchingFoc
 
 void ProcessInput(int key, std::string& s, float& input, InputFocus& inputFocus, int maxSize); // modify string with input and store input as a float. changes input focus as necessary
 
-std::vector<VertexState> FindVertexSelection(const std::vector<std::vector<Model>>& models, const ModelSelection& modelSelection, RayHitInfo hitPosition, float selectRadius); // find the vertices within the selection radius of the ray hit position 
+FrameVector<VertexState> FindVertexSelection(const std::vector<std::vector<Model>>& models, const ModelSelection& modelSelection, RayHitInfo hitPosition, float selectRadius, int modelVertexWidth, int modelVertexHeight); // find the lattice points within the selection radius of the ray hit position, one vertex for each. the result only lasts until the end of the tick
 
 void FindStampPoints(float stampRotationAngle, float stampStretchLength, Vector2& outVec1, Vector2& outVec2, Vector2 stampAnchor); // finds the ends of the stamp tool when stretch is active
 
 float PointSegmentDistance(Vector2 point, Vector2 segmentPoint1, Vector2 segmentPoint2); // shortest distance from a point to a line segment
 
+bool SampleHeight(const std::vector<std::vector<Model>>& models, float x, float z, float& outY, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, Vector2 topLeft = Vector2{0, 0}); // height of the mesh surface at x, z, exact to the triangle it lands on. topLeft is the model coords of models[0][0] when models is a copy of a selection (ghost mesh). returns false if x, z is off the mesh
+
+float StampVertexHeight(float distance, float vertexY, const StampParams& stamp); // the stamp kernel. new height of a vertex given its distance from the stamp center (or center segment when stretched) and its current height
+
+bool CapsuleRowSpan(Vector2 segmentPoint1, Vector2 segmentPoint2, float radius, float rowZ, float& outStart, float& outEnd); // finds the x range where a row at rowZ crosses a capsule. returns false if it doesnt
+
+void StampCapsule(std::vector<std::vector<Model>>& models, const ModelSelection& modelSelection, Vector2 segmentPoint1, Vector2 segmentPoint2, const StampParams& stamp, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight); // stamps a capsule onto the selected models, visiting only the vertex rows and columns inside its bounds
+
 Mesh CopyMesh(const Mesh& mesh); // do a deep copy of a mesh
 
-void Smooth(std::vector<std::vector<Model>>& models, const std::vector<VertexState>& vertices, int modelVertexWidth, int modelVertexHeight, int canvasWidth, int canvasHeight); // do a smooth operation on the vertices
+void Smooth(std::vector<std::vector<Model>>& models, const FrameVector<VertexState>& vertices, int modelVertexWidth, int modelVertexHeight, int canvasWidth, int canvasHeight); // do a smooth operation on the vertices
 
-unsigned long PixelToHeight(Color pixel); // takes the bits from each of the 4 png channels and arranges them into one int
+// split png codec. the 31 bit height is stored little endian across the channels, red holds the lowest 8 bits and alpha the highest. whole rows are done with shifts and masks, in loops simple enough for the compiler to vectorize
 
-Mesh GenMeshHeightmap32bit(Image heightmap, Vector3 size); // version of GenMeshHeightmap that handles split channel heightmaps
+void EncodeSplitRow(const float* values, int count, unsigned char* pixels); // values from 0 to 1 into count rgba pixels
 
-void UpdateTopDownCamera(Camera* camera);
+void DecodeSplitRow(const unsigned char* pixels, int count, float* values); // count rgba pixels into values from 0 to 1
 
-RayHitInfo FindHit2D(const Ray& ray, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight);
+unsigned long PixelToHeight(Color pixel); // takes the bits from each of the 4 png channels and arranges them into one int. the codec as it was before the row functions, a bit at a time, kept as the reference the batch selftest and bench check them against
 
-RayHitInfo FindHit3D(const Ray& ray, const std::vector<std::vector<Model>>& models, Vector2& modelCoords, int length = 0, int direction = 1, int loop = 0, int total = 0);
+Color HeightToPixel(unsigned long height); // PixelToHeight's inverse, a bit at a time the same way
 
-ModelSelection FindModelSelection(int canvasWidth, int canvasHeight, int modelWidth, Vector2 modelCoords, float selectRadius);
+int LatticeVertexIndex(int x, int z, int modelVertexWidth, int modelVertexHeight); // index in Mesh::vertices of one of the vertices at x, z in a model, worked out directly rather than looked up like GetVertexIndices
 
-void ExtendHistoryStep(HistoryStep& historyStep, const std::vector<std::vector<Model>>& models, const ModelSelection& modelCoords); // add vertex info to the history step when it's edit range increases mid edit
+template<class Geometry>
+int LatticeVertexIndex(int x, int z, const Geometry& geometry); // LatticeVertexIndex for a FixedTileGeometry or TileGeometry
 
-void FinalizeHistoryStep(HistoryStep& historyStep, const std::vector<std::vector<Model>>& models); // record the ending state of all vertices in this history step's range when the edit is complete
+template<class Kernel>
+void DispatchTileGeometry(int modelVertexWidth, int modelVertexHeight, Kernel kernel); // calls kernel with a FixedTileGeometry for the tile resolutions the editor offers, and a TileGeometry for anything else
 
-void UpdateNormals(Model& model, int modelVertexWidth, int modelVertexHeight); // update a model's normals
+const char* HeightmapExtension(HeightmapFormat format); // file extension used for a heightmap format
 
-int BinarySearchVec2(Vector2 vec2, const std::vector<Vector2>&v, int &i); // binary search for vector2. returns the index where vec2 was found, -1 if not found. i will be changed to the index where vec2 should be inserted
+unsigned int UpdateCrc32(unsigned int crc, const unsigned char* data, int length); // continues a crc32. start with 0xFFFFFFFF and invert the result
 
-template<class T, class T2>
-int BinarySearch(T var, const std::vector<T2>&v, int &i); // returns the index where var was found, -1 if not found. i will be changed to the index where var should be inserted
+unsigned int UpdateAdler32(unsigned int adler, const unsigned char* data, int length); // continues an adler32. start with 1
 
-template<class T, class T2>
-int BinarySearch(T var, const std::vector<T2>&v); // returns the index where var was found, -1 if not found
+void WritePngChunk(FILE* file, const char* type, const unsigned char* data, int length);
 
+bool BeginPngStream(PngStream& png, const char* fileName, int width, int height, int bitDepth, int colorType); // opens the file and writes the png header. returns false if the file couldnt be opened
 
+void WritePngRow(PngStream& png, const unsigned char* row, int length); // writes one row of pixels, without the filter byte
 
+void PutPngBits(PngStream& png, unsigned int bits, int count); // deflate bits, least significant first
 
-// internal variables from camera.h for custom camera to use
-static Vector2 cameraAngle = { 0.0f, 0.0f };          // Camera angle in plane XZ
-static float cameraTargetDistance = 0.0f;             // Camera distance from position to target 
-static float playerEyesHeight = 0.185f;              // Default player eyes position from ground
-static int cameraMoveControl[6]  = { 'W', 'S', 'D', 'A', 'E', 'Q' };
+void PutPngCode(PngStream& png, unsigned int code, int length); // a huffman code, most significant bit first
 
-// Camera mouse movement sensitivity
-#define CAMERA_MOUSE_MOVE_SENSITIVITY                   0.003f
-#define CAMERA_MOUSE_SCROLL_SENSITIVITY                 1.5f
-// FIRST_PERSON
-#define CAMERA_FIRST_PERSON_FOCUS_DISTANCE              25.0f
-#define CAMERA_FIRST_PERSON_MIN_CLAMP                   85.0f
-#define CAMERA_FIRST_PERSON_MAX_CLAMP                  -85.0f
+void PutPngSymbol(PngStream& png, int symbol); // a literal, end of block or length symbol in the fixed huffman codes
 
-// PLAYER (used by camera)
-#define PLAYER_MOVEMENT_SENSITIVITY                     65.0f
+void PutPngMatch(PngStream& png, int length, int distance); // a copy of length bytes from distance back
 
+bool EndPngStream(PngStream& png); // finishes and closes the png. returns false if writing failed
 
+bool ExportHeightmap(const char* fileName, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, float maxHeight, float minHeight, HeightmapFormat format, int cropWidth = 0, int cropHeight = 0); // streams the whole map to a file one row at a time, holding one row of models' heights, so memory use doesnt grow with the map. paged out models are read from the page file. pixels match 1:1 with vertices. cropWidth and cropHeight cut the map down to that many vertices from the top left, for maps padded out to whole models, 0 keeps all of it. returns false if it couldnt be written
 
+bool ExportTiles(const char* fileName, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, int modelWidth, float maxHeight, float minHeight, int chunkSize, int cropWidth = 0, int cropHeight = 0); // cropped like ExportHeightmap. writes the map as 16 bit png chunks chunkSize vertices wide (one per model if 0), then again at half the resolution until the map fits in one chunk, and a json manifest at fileName with each chunk's bounds and height range. chunks are encoded on every core. returns false if anything couldnt be written
 
-int main()
-{
-    const int windowWidth = 1800;
-    const int windowHeight = 900;
-    const int maxSteps = 10;   // number of changes to keep track of for the history
-    const int modelVertexWidth = 120; // 360x360 aprox max before fps <60 with raycollision
-    const int modelVertexHeight = 120;  
-    const int modelWidth = 12;
-    const int modelHeight = 12;
-    int stepIndex = 0; // the current location in history
-    int canvasWidth = 0; // in number of models
-    int canvasHeight = 0; // in number of models
-    float timeCounter = 0; // used to track number of frames passed
-    float selectRadius = 1.5f;
-    float toolStrength = 0.1f; 
-    float highestY = 0.0f; // highest y value on the mesh
-    float lowestY = 0.0f; // lowest y value on the mesh
-    float stampAngle = 60.0f; // how steep the stamp shape is
-    float stampHeight = 0; // optional height cap of the stamp tool
-    float innerRadius = 0;
-    float stampStretchLength = 0.5f;
-    float stampRotationAngle = 0.0f;
-    float stampSlope = 0.0f;
-    float stampOffset = 0.0f;
-    bool updateFlag = false; // true when mouse left click has not been released since an edit operation has been done (aka true when painting)
-    bool selectionMask = false;
-    bool characterDrag = false; // true when the character camera placement is being held
-    bool rayCollision2d = true; // if true, ray collision will be tested against the ground plane instead of the actual mesh 
-    bool raiseOnly = true; // if true, brush will check if the vertex is higher than what it's attempting to change it to and if so, not alter it
-    bool showSaveWindow = false; // whether or not to display the save window with the export options
-    bool showLoadWindow = false; // true if the load window should be shown
-    bool showDirWindow = false; // if directory change window is shown
-    bool lowerOnly = false; // if true, brush will only lower vertices
-    bool editQueue = false; // if true, each tick has the ability to produce more than one edit operation. if more than one is produced, theyre pushing into a queue and are completed asap
-    bool stampFlip = false; // whether the stamp is upside down or right side up
-    bool stampInvert = false; // whether the stamp is normal or mirrored vertically
-    bool stampStretch = false; // if true, the stamp will become two connected copies of itself equally spaced from the middle that rotate depending on mouse drag movement
-    bool useGhostMesh = false; // when set to true, a copy of the model selection is made which is then tested against for ray collision rather than the current mesh. setting to false clears the mesh
-    bool stampDrag = false; // set to true after the first stamp edit with stampStretch on, and off when the left mouse is released
-    bool saveGrayscale = true; // true to save the heightmap as grayscale, false to save using all png channels (looks weird, saves more height resolution)
-    bool loadGrayscale = true; // should be set to true when loading grayscale image
-    
-    Vector2 lastRayHitLoc = {0, 0}; // coordinates of the model the mouse ray last hit
-    
-    std::vector<HistoryStep> history;
-    std::vector<VertexState> vertexSelection;
-    std::vector<std::vector<Model>> models;      // 2d vector of all models
-    
-    std::vector<std::vector<Model>> ghostMesh;  // copy of a selection of models used for collision detection
-    
-    std::string xMeshString; // models on the x axis
-    std::string zMeshString; // models on the z axis
-    std::string xMeshSelectString; // width of the selection in models 
+bool WritePng16(const char* fileName, const unsigned short* pixels, int width, int height); // writes a whole 16 bit grayscale png held in memory, compressed. returns false if it couldnt be written
+
+bool ExportMesh(const char* fileName, const std::vector<std::vector<Model>>& models, const std::vector<Vector2>& modelCoords, int modelVertexWidth, int modelVertexHeight, int modelWidth, int triangleBudget, float maxError, HeightmapFormat format); // writes the models in modelCoords (the whole canvas if it is empty) as one indexed obj or glb mesh, decimated to about triangleBudget triangles, or to within maxError of the heights if triangleBudget is 0. models are decimated on every core and their borders are shared so there are no cracks. returns false if it couldnt be written
+
+float DecimateCell(const float* heights, int modelVertexWidth, int x, int z, int width, int height, float threshold, std::vector<DecimatedCell>& cells, std::vector<std::pair<float, int>>* splits); // quadtree decimation. adds the leaves to cells, splitting until every leaf is within threshold of the heights under it. returns the saturated error, the highest error in the cell or under it, so a cell is only ever split if its parent is. splits gets the saturated error of each split and how many cells it adds
+
+void TriangulateDecimatedModel(DecimatedModel& model, int modelVertexWidth, int modelVertexHeight, float spacing); // turns a model's cells into triangles, fanning cells that border smaller ones from their middle so there are no t junctions
+
+bool WriteObj(const char* fileName, const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<unsigned int>& indices);
+
+bool WriteGlb(const char* fileName, const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<unsigned int>& indices);
+
+void ParallelFor(int count, const std::function<void(int)>& body); // runs body(0) to body(count - 1) spread across the task pool. returns once they are all done
+
+void InitTaskPool(int threadCount); // starts the pool threads. 0 for one per core besides the calling thread
+
+void ShutdownTaskPool(); // finishes the queued tasks and joins the threads
+
+void SubmitTask(TaskGroup& group, std::function<void()> run, TaskGroup* after = NULL); // queues run as part of group. with after it is held back until every task in after is done. after cant be group
+
+void WaitTaskGroup(TaskGroup& group); // runs queued tasks, from any group, until every task in group is done
+
+void PushTask(Task task); // onto the calling pool thread's own queue, or round robin from outside the pool
+
+bool RunPoolTask(int queueIndex); // runs one task, from queueIndex's back or stolen from another queue's front. -1 for threads outside the pool. returns false if there were none
+
+void FinishTask(TaskGroup* group); // counts a task as done, releasing group's held back tasks if it was the last
+
+void TaskWorker(int queueIndex);
+
+TaskPoolStats TakeTaskPoolStats(); // since the last call
+
+int RunBatch(int argc, char** argv); // runs the operations given as arguments, or read from a script with -f, with no window or gl context. prints how long each step took. returns the exit code
+
+bool IsBatchArgument(const char* argument); // whether a first argument asks for a batch run, --batch, an option or an operation
+
+int BatchOperationIndex(const std::string& name); // index into batchOperations, -1 if it isnt one
+
+bool RunBatchStep(BatchCanvas& canvas, const std::vector<std::string>& step); // one batch operation, its name followed by its arguments. prints why and returns false if it failed
+
+bool ParseHeightmapFormat(const char* name, HeightmapFormat& format); // format from its name in a batch, like png16 or r32f
+
+void BuildBatchModels(const BatchCanvas& canvas, std::vector<std::vector<Model>>& models); // cpu only models of the canvas for the exporters, built on every core. free with UnloadBatchModels
+
+void UnloadBatchModels(std::vector<std::vector<Model>>& models);
+
+bool TestSplitRows(); // checks EncodeSplitRow and DecodeSplitRow against the bitset reference, edge cases and random rows, byte for byte. prints what doesnt match
+
+void BenchSplitRows(int count); // times EncodeSplitRow and DecodeSplitRow against the bitset reference on count pixels each way
+
+void FindDabSelection(const JournalCommand& dab, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, int modelWidth, ModelSelection& editSelection, FrameVector<VertexState>& vertexIndices); // the models and vertices a dab edits, worked out from the dab alone so a replay finds the same ones the editor did
+
+bool ApplyJournalCommand(const JournalCommand& command, std::vector<std::vector<Model>>& models, std::vector<VertexState>& vertexSelection, std::vector<HistoryStep>& history, int& stepIndex, int maxSteps, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, const ModelSelection& editSelection, const FrameVector<VertexState>& vertexIndices); // makes an edit, live or replayed. a dab edits what FindDabSelection found for it. uploads and heightmaps are left to the editor. returns false if there was nothing to do
+
+int ReplayJournal(const std::vector<JournalCommand>& commands, std::vector<std::vector<Model>>& models, std::vector<VertexState>& vertexSelection, std::vector<HistoryStep>& history, int& stepIndex, int maxSteps, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight); // applies the commands in order as fast as they go, ignoring their times. returns how many did something
+
+unsigned long long CanvasChecksum(const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight); // fnv-1a of every model's heights, paged out ones too
+
+std::vector<unsigned char> PackJournalHeader(const JournalHeader& header); // JOURNAL_HEADER_SIZE bytes
+
+JournalHeader UnpackJournalHeader(const unsigned char* data);
+
+void PackJournalCommand(std::vector<unsigned char>& out, const JournalCommand& command); // JOURNAL_COMMAND_SIZE bytes on the end of out
+
+bool UnpackJournalCommand(const unsigned char* data, JournalCommand& command); // false if one of its bools isnt 0 or 1
+
+bool StartJournal(Journal& journal, const char* fileName, int canvasWidth, int canvasHeight, int modelVertexWidth, int modelVertexHeight, int maxSteps, unsigned long long checksum); // starts recording over fileName, from a canvas with checksum. returns false if it couldnt be opened or written
+
+void RecordJournalCommand(Journal& journal, JournalCommand command); // appends the command with its time, if a journal is being recorded. stops recording if it couldnt be written
+
+void StopJournal(Journal& journal);
+
+bool LoadJournal(const char* fileName, JournalHeader& header, std::vector<JournalCommand>& commands); // reads a whole journal. one cut short by a crash loads up to its last whole command. returns false if it isnt a journal, or its header or any command couldnt have been recorded
+
+bool ValidJournalCommand(const JournalCommand& command, const JournalHeader& header); // whether the command could have been recorded on the header's canvas
+
+void BindSimulation(std::vector<std::vector<Model>>& models, std::vector<VertexState>& vertexSelection, std::vector<HistoryStep>& history, int& stepIndex); // starts the simulation thread. call once before the main loop
+
+void ShutdownSimulation(); // applies whatever is queued and stops the thread. call before ShutdownPager
+
+void SubmitEdit(const JournalCommand& command, const ModelSelection& editSelection, const FrameVector<VertexState>& vertexIndices, int maxSteps, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, bool findSelection = false); // records the edit in the journal and queues it for the simulation thread. a dab submitted without the canvas held passes findSelection instead of its selection, the simulation thread finds it
+
+bool HoldCanvas(bool wait); // takes the canvas for the rest of the tick, waiting for the queued edits if wait is true. otherwise returns false if there are any. loads models for the simulation thread either way
+
+void ReleaseCanvas(); // at the end of the tick, so the simulation thread can apply what was queued during it
+
+bool TakeSimulationCommits(std::vector<std::vector<unsigned int>>& modelRevisions); // marks the models committed edits changed and schedules their uploads and heightmaps. returns true if there were any
+
+void ServeSimulationLoads(); // loads the models the simulation thread is waiting on
+
+void LoadForSimulation(int x, int y); // from the simulation thread. waits for the main thread to load the model
+
+void SimulationWorker();
+
+void CollectTileCommits(const JournalCommand& command, const ModelSelection& editSelection, const std::vector<std::vector<Model>>& models, const std::vector<HistoryStep>& history, int stepIndex, std::vector<TileCommit>& commits); // the models an applied command changed and what is left to do for each
+
+float* LoadHeightGrid(const char* fileName, HeightmapFormat format, int& width, int& height); // memory should be freed. reads a heightmap in any of the image formats into heights from 0 to 1, or r32f into the heights it holds. returns NULL if the file couldnt be read
+
+float* DecodePng16(const unsigned char* fileData, unsigned int fileSize, int& width, int& height); // memory should be freed. decodes a non interlaced 16 bit png, using its first channel. returns NULL if it isnt one
+
+void MarkModelChanged(std::vector<std::vector<unsigned int>>& modelRevisions, int x, int y); // call whenever a model's heights change. bumps its revision, growing modelRevisions if needed
+
+unsigned int GetModelRevision(const std::vector<std::vector<unsigned int>>& modelRevisions, int x, int y); // 0 for models that have never been marked
+
+bool MapFile(MappedFile& map, const char* fileName); // maps a whole file read only. returns false if it couldnt be mapped
+
+void UnmapFile(MappedFile& map);
+
+bool SeekFile(FILE* file, unsigned long long offset); // fseek that works past 2GB
+
+void GetModelHeights(const Model& model, float* heights, int modelVertexWidth, int modelVertexHeight); // copies a model's heights into heights, one per vertex row by row
+
+template<class Geometry>
+void GetModelHeights(const Model& model, float* heights, const Geometry& geometry);
+
+void PutLittleEndian(std::vector<unsigned char>& out, unsigned long long value, int size); // the low size bytes of value, the way .pangea fields are stored
+
+void PutFloat(std::vector<unsigned char>& out, float value);
+
+unsigned long long GetLittleEndian(const unsigned char* data, int size);
+
+float GetFloat(const unsigned char* data);
+
+std::vector<unsigned char> PackProjectHeader(const ProjectHeader& header); // PROJECT_HEADER_SIZE bytes
+
+ProjectHeader UnpackProjectHeader(const unsigned char* data);
+
+void PackProjectTileEntry(std::vector<unsigned char>& out, const ProjectTileEntry& entry); // PROJECT_TILE_ENTRY_SIZE bytes on the end of out
+
+ProjectTileEntry UnpackProjectTileEntry(const unsigned char* data);
+
+bool MoveFileOver(const char* fromName, const char* toName); // rename that replaces toName if it exists
+
+FILE* OpenSharedFile(const char* fileName); // opens a file to read that can still be written to or replaced while it is open. once replaced, the open file keeps reading the old one
+
+std::vector<unsigned char> PackProjectTrailer(const ProjectSettings& settings, const ModelSelection& modelSelection, const std::vector<HistoryStep>& history, int stepIndex); // the settings, selection and history as they are stored at the end of a .pangea
+
+bool WriteProject(Project& project, const char* fileName, const std::vector<std::vector<unsigned int>>& revisions, const std::vector<unsigned char>& trailer, const std::function<bool(int, int, float*)>& readHeights, int modelVertexWidth, int modelVertexHeight, bool compress); // writes a .pangea with a canvas the size of revisions. if it is project's file, only the models whose revision differs from its last write are read with readHeights and appended to it, then its index and header are written over. otherwise, or once appends have left too much of it unused, it is written whole to a temporary file moved over fileName
+
+bool SaveProject(Project& project, const char* fileName, const std::vector<std::vector<Model>>& models, const std::vector<std::vector<unsigned int>>& modelRevisions, const ProjectSettings& settings, const ModelSelection& modelSelection, const std::vector<HistoryStep>& history, int stepIndex, int modelVertexWidth, int modelVertexHeight); // saves a .pangea project. if it is the file last saved or opened, only the models that changed since are written
+
+bool OpenProject(Project& project, const char* fileName, std::vector<std::vector<Model>>& models, std::vector<std::vector<unsigned int>>& modelRevisions, ProjectSettings& settings, ModelSelection& modelSelection, std::vector<HistoryStep>& history, int& stepIndex, int& modelVertexWidth, int& modelVertexHeight, int modelWidth, int modelHeight, float& highestY, float& lowestY); // replaces the canvas with a .pangea project, taking on its model size. only the models around the saved camera are loaded, the pager reads the rest from the file as they are needed. returns false and leaves everything alone if the file cant be used
+
+Mesh GenMeshHeightGrid(const float* heights, int gridWidth, int gridHeight, int startX, int startZ, int mapX, int mapZ, Vector3 size, Vector2 offset, bool upload = true); // version of GenMeshHeightmap that builds a model's mesh from its part of a height grid (0 to 1), starting at startX, startZ. vertices are placed at offset. upload false leaves the mesh on the cpu only, for building meshes off the main thread
+
+void BindPager(std::vector<std::vector<Model>>& models, float& highestY, float& lowestY, HeightMapMode& heightMapMode, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight); // starts paging models in and out. call once before the main loop
+
+void ShutdownPager(); // stops the background thread and deletes the page file. call before CloseWindow
+
+void ResetPager(int modelVertexWidth, int modelVertexHeight); // forgets every paged out model. call when the canvas is replaced, with the size of its models
+
+void BindPagerProject(FILE* file, const std::vector<ProjectTileEntry>& index); // models given a block are read from it in file until they are first paged out. the pager closes file when it is reset
+
+bool ModelLoaded(const Model& model); // false if the model is paged out. paged out models are left as an empty Model, so drawing and ray tests skip them
+
+PagedModel& GetPagedModel(int x, int y); // grows the page grid if needed
+
+void RequireModel(int x, int y); // makes sure a model is loaded, loading it right away if it isnt, and keeps it loaded for this frame. for anything about to read or edit its vertices
+
+void RequireModels(const std::vector<Vector2>& modelCoords);
+
+bool ReadPage(long long slot, long long block, float* heights); // reads a model's heights back from the page file, or from its project block if it has no slot. false if it has neither
+
+void PageOutModel(int x, int y); // writes a model's heights to the page file and frees its mesh and texture
+
+void FinishPageLoad(int x, int y, Mesh mesh); // turns a mesh loaded from the page file back into models[x][y]
+
+int FinishPageLoads(int maxLoads); // uploads up to maxLoads meshes the background thread has finished. returns how many it uploaded
+
+void PagerWorker(); // background thread. builds meshes for paged out models
+
+int TrimPager(); // pages out the least recently used models until no more than PAGER_RESIDENT_MODELS are loaded. models used this frame are kept. returns how many it paged out
+
+bool UpdatePager(Vector3 cameraPosition); // once per frame. finishes background loads, requests the models around the camera and trims. returns true if a model came in or went out, so the canvas looks different
+
+bool FaultInRay(const Ray& ray, float maxDistance); // loads the paged out models a picking ray passes through before maxDistance, nearest first. returns true if any were loaded
+
+bool ReadModelHeights(const std::vector<std::vector<Model>>& models, int x, int y, float* heights, int modelVertexWidth, int modelVertexHeight); // GetModelHeights that reads paged out models from the page file or project
+
+void StartAutosave(const std::vector<std::vector<Model>>& models, const std::vector<std::vector<unsigned int>>& modelRevisions, const ProjectSettings& settings, const ModelSelection& modelSelection, const std::vector<HistoryStep>& history, int stepIndex, int modelVertexWidth, int modelVertexHeight); // takes a snapshot of the models that changed since the last autosave and writes it on a background thread. the heights arent copied here, only when a model is about to diverge from the snapshot
+
+void PreserveModel(int x, int y); // call before a model's heights change or it is paged out. copies its heights for the autosave writer if it still needs them
+
+void AutosaveWriter(int modelVertexWidth, int modelVertexHeight); // background thread. writes the snapshot
+
+void FinishAutosave(); // waits for the autosave being written. call before the canvas is replaced or resized
+
+void GetCanvasHeightRange(const std::vector<std::vector<Model>>& models, float& minY, float& maxY); // lowest and highest point on the canvas, using the recorded range of paged out models
+
+void UpdateTopDownCamera(Camera* camera);
+
+RayHitInfo FindHit2D(const Ray& ray, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, float height = 0); // the ray against a flat plane at height, inside the canvas. reads no heights
+
+RayHitInfo FindHit3D(const Ray& ray, const std::vector<std::vector<Model>>& models, Vector2& modelCoords, int length = 0, int direction = 1, int loop = 0, int total = 0);
+
+void FindModelSelection(ModelSelection& modelSelection, int canvasWidth, int canvasHeight, int modelWidth, int modelVertexWidth, Vector2 modelCoords, float selectRadius); // fills in modelSelection, reusing the memory its lists already have
+
+void ExtendHistoryStep(HistoryStep& historyStep, const std::vector<std::vector<Model>>& models, const ModelSelection& modelCoords); // add vertex info to the history step when it's edit range increases mid edit
+
+void FinalizeHistoryStep(HistoryStep& historyStep, const std::vector<std::vector<Model>>& models); // record the ending state of all vertices in this history step's range when the edit is complete
+
+void UpdateNormals(Model& model, int modelVertexWidth, int modelVertexHeight); // update a model's normals
+
+template<class Geometry>
+void UpdateNormals(Model& model, const Geometry& geometry);
+
+int BinarySearchVec2(Vector2 vec2, const std::vector<Vector2>&v, int &i); // binary search for vector2. returns the index where vec2 was found, -1 if not found. i will be changed to the index where vec2 should be inserted
+
+template<class T, class T2>
+int BinarySearch(T var, const std::vector<T2>&v, int &i); // returns the index where var was found, -1 if not found. i will be changed to the index where var should be inserted
+
+template<class T, class T2>
+int BinarySearch(T var, const std::vector<T2>&v); // returns the index where var was found, -1 if not found
+
+
+
+
+// internal variables from camera.h for custom camera to use
+static Vector2 cameraAngle = { 0.0f, 0.0f };          // Camera angle in plane XZ
+static float cameraTargetDistance = 0.0f;             // Camera distance from position to target 
+static float playerEyesHeight = 0.185f;              // Default player eyes position from ground
+static int cameraMoveControl[6]  = { 'W', 'S', 'D', 'A', 'E', 'Q' };
+
+// Camera mouse movement sensitivity
+#define CAMERA_MOUSE_MOVE_SENSITIVITY                   0.003f
+#define CAMERA_MOUSE_SCROLL_SENSITIVITY                 1.5f
+// FIRST_PERSON
+#define CAMERA_FIRST_PERSON_FOCUS_DISTANCE              25.0f
+#define CAMERA_FIRST_PERSON_MIN_CLAMP                   85.0f
+#define CAMERA_FIRST_PERSON_MAX_CLAMP                  -85.0f
+
+// character simulation, runs at a fixed rate no matter the frame rate
+static Vector3 playerPosition = { 0.0f, 0.0f, 0.0f };          // feet position after the latest simulation step
+static Vector3 previousPlayerPosition = { 0.0f, 0.0f, 0.0f };  // feet position after the step before it, the camera is interpolated between the two
+static float playerTimeAccumulator = 0.0f;                     // frame time not yet consumed by simulation steps
+
+// PLAYER (used by camera)
+#define PLAYER_MOVEMENT_SPEED                           0.92f   // units per second
+#define PLAYER_STEP_RATE                                60.0f   // simulation steps per second
+#define PLAYER_MAX_STEPS_PER_FRAME                      8       // steps dropped past this so a long frame doesnt stall the next one
+#define PLAYER_STEP_HEIGHT                              0.03f   // most a single step can rise
+#define PLAYER_MAX_SLOPE                                50.0f   // degrees. steeper ground ahead blocks movement
+#define PLAYER_SLOPE_RUN                                0.25f   // distance ahead the slope is measured over. a single step is too short to tell a slope from a bump
+
+// tile paging, so canvases bigger than ram and vram can be edited
+static ModelPager pager;
+
+#define PAGER_RESIDENT_MODELS                           400     // most models kept loaded (ram and vram) at once. about 5MB each
+#define PAGER_PREFETCH_RADIUS                           6       // models this many away from the camera's model are loaded in the background
+#define PAGER_UPLOADS_PER_FRAME                         4       // background loads uploaded to the gpu per frame
+#define PAGER_RAY_FAULTS                                4       // most models a picking ray loads per frame
+#define PAGER_OPEN_RADIUS                               1       // models this many away from the saved camera are loaded before an opened project is shown
+#define PAGER_FILE_NAME                                 "pangea.pagefile"
+
+// autosave
+static Autosave autosave;
+
+#define AUTOSAVE_INTERVAL                               30.0f   // seconds between autosaves, the most work a crash can lose
+#define AUTOSAVE_FILE_NAME                              "autosave.pangea"
+
+#define MODEL_WORLD_SIZE                                12      // width and height of a model in world units, whatever its resolution
+
+// tile resolution, the vertices along each side of a model. more means fewer draw calls, fewer means cheaper picking and edits
+#define TILE_RESOLUTION_DEFAULT                         120
+#define TILE_RESOLUTION_MAX                             1025    // largest a project can be opened with
+
+// mesh export
+#define MESH_EXPORT_TRIANGLE_BUDGET                     300000  // default triangle count for obj and glb exports
+#define TILE_EXPORT_CHUNK_SIZE                          0       // vertices along each side of a tiled export's chunks. 0 for one chunk per model
+
+// png export
+#define PNG_MATCH_CHAIN                                 32      // earlier matches tried for each byte when deflating. more is smaller and slower, 0 writes every byte as a literal
+#define PNG_WINDOW_SIZE                                 32768   // how far back a match can be, the most deflate allows
+#define PNG_HASH_BITS                                   15
+
+// per tick memory, for brush and picking data that is thrown away every tick
+static thread_local FrameArena frameArena;                     // each thread that edits has its own
+static std::atomic<int> heapAllocationCount;                   // operator new calls from any thread since the last tick ended
+
+#define FRAME_ARENA_INITIAL_SIZE                        (1 << 20)
+#define FRAME_ARENA_MAX_SIZE                            (64 << 20)  // the arena doesnt grow past this. bigger ticks take the rest from the heap
+
+// redrawing. the editor is only drawn when something could have changed, otherwise the last frame is shown again, so an idle editor doesnt keep a core and the gpu busy
+static bool continuousRendering = false; // draw every frame anyway, for benchmarking. toggled with F8
+
+#define ACTIVE_FPS                                      60
+#define IDLE_FPS                                        10      // ticks per second once nothing has changed for IDLE_DELAY. input is still picked up every tick
+#define IDLE_DELAY                                      0.5f    // seconds
+
+// deferred per model work, so the end of a big edit doesnt land in one frame
+static TileScheduler tileScheduler;
+
+#define TILE_JOB_NORMALS                                1
+#define TILE_JOB_UPLOAD                                 2       // vertices to the gpu
+#define TILE_JOB_HEIGHTMAP                              4       // the model's texture
+#define TILE_JOB_BUDGET                                 0.004f  // seconds of jobs per frame
+#define TILE_JOB_MAX_DELAY                              6       // frames a job can wait, the longest a model on screen can be out of date
+
+// heightmap preview on the gpu
+static HeightmapShader heightmapShader;
+static DisplacementGrid displacementGrid;
+
+#define HEIGHTMAP_SHADER                                1       // 0 starts with the cpu heightmap textures. toggled with F7
+#define SLOPE_TOLERANCE                                 59.0f   // degrees, GenHeightmap's default
+#define DISPLACEMENT_RENDERING                          0       // 1 draws the tiles from one shared grid mesh and a height texture each. picked at startup, the tiles are built for one or the other. --displacement or PANGEA_DISPLACEMENT=1 picks it without rebuilding
+
+// staging memory for uploads
+static UploadRing uploadRing;
+
+#define UPLOAD_RING_SIZE                                32      // staging buffers, enough for a frame of tile jobs and a batch of a whole canvas recolor
+#define UPLOAD_STUBS                                    0       // 1 skips the gl upload calls, to time the cpu side on its own
+
+// task pool
+static TaskPool taskPool;
+static thread_local int taskQueueIndex = -1; // the pool thread's own queue, -1 on threads outside the pool
+
+#define TASK_POOL_THREADS                               0       // pool threads besides the main thread. 0 for one per core
+
+// batch runs
+static const char* batchOperations[] = { "import", "resolution", "resize", "smooth", "stamp", "replay", "preview", "export", "selftest", "bench" };
+static const int batchMaxArguments[] = { 3, 1, 2, 1, 6, 1, 1, 3, 0, 1 }; // the words after an operation that can still be its arguments
+
+#define BATCH_BENCH_PIXELS                              (1 << 22)   // pixels bench runs through each codec by default
+
+// edit journal, every edit recorded so it can be replayed in the editor or a batch
+static Journal journal;
+
+#define JOURNAL_FILE_NAME                               "pangea.journal"
+#define JOURNAL_MAGIC                                   "PGJOURN"   // 8 bytes with the terminator
+#define JOURNAL_VERSION                                 2       // 2 is written a field at a time and has the starting canvas' checksum
+#define JOURNAL_HEADER_SIZE                             40      // bytes the header is written as
+#define JOURNAL_COMMAND_SIZE                            95      // and each command
+#define JOURNAL_STROKE_START                            1       // first dab of a stroke, starts a history step
+#define JOURNAL_INVERT                                  2       // left ctrl was held. lowers instead of raising, or deselects
+#define JOURNAL_MASK                                    4       // the selection mask was on, selected vertices are left alone
+#define JOURNAL_STRETCH                                 8       // the stamp was stretched between stampPoints
+
+// simulation thread, edits are applied there while the main thread keeps drawing
+static Simulation simulation;
+
+
+
+
+int main(int argc, char** argv)
+{
+    bool displacementRendering = DISPLACEMENT_RENDERING;
+    const char* displacementVariable = getenv("PANGEA_DISPLACEMENT");
+    
+    if (displacementVariable)
+        displacementRendering = atoi(displacementVariable) != 0;
+    
+    if (argc > 1 && strcmp(argv[1], "--displacement") == 0) // the flag over the environment
+    {
+        displacementRendering = true;
+        argc--;
+        argv++;
+    }
+    
+    if (argc > 1 && !IsBatchArgument(argv[1]))
+    {
+        printf("unknown argument %s. a batch run starts with --batch or an operation, --help lists them\n", argv[1]);
+        return 1;
+    }
+    
+    if (argc > 1) // a batch run, no window is opened
+        return RunBatch(argc - 1, argv + 1);
+    
+    const int windowWidth = 1800;
+    const int windowHeight = 900;
+    const int maxSteps = 10;   // number of changes to keep track of for the history
+    const int tileResolutions[] = { 65, 120, 129, 257 }; // offered in the canvas panel. 360x360 aprox max before fps <60 with raycollision
+    int tileResolution = TILE_RESOLUTION_DEFAULT; // resolution picked for the next new canvas
+    int modelVertexWidth = tileResolution; // resolution of the current canvas. only changes when the canvas is replaced
+    int modelVertexHeight = tileResolution;
+    const int modelWidth = MODEL_WORLD_SIZE;
+    const int modelHeight = MODEL_WORLD_SIZE;
+    int stepIndex = 0; // the current location in history
+    int canvasWidth = 0; // in number of models
+    int canvasHeight = 0; // in number of models
+    float selectRadius = 1.5f;
+    float toolStrength = 0.1f; 
+    float highestY = 0.0f; // highest y value on the mesh
+    float lowestY = 0.0f; // lowest y value on the mesh
+    float stampAngle = 60.0f; // how steep the stamp shape is
+    float stampHeight = 0; // optional height cap of the stamp tool
+    float innerRadius = 0;
+    float stampStretchLength = 0.5f;
+    float stampRotationAngle = 0.0f;
+    float stampSlope = 0.0f;
+    float stampOffset = 0.0f;
+    bool updateFlag = false; // true when mouse left click has not been released since an edit operation has been done (aka true when painting)
+    bool selectionMask = false;
+    bool characterDrag = false; // true when the character camera placement is being held
+    bool rayCollision2d = true; // if true, ray collision will be tested against the ground plane instead of the actual mesh 
+    bool raiseOnly = true; // if true, brush will check if the vertex is higher than what it's attempting to change it to and if so, not alter it
+    bool showSaveWindow = false; // whether or not to display the save window with the export options
+    bool showLoadWindow = false; // true if the load window should be shown
+    bool showDirWindow = false; // if directory change window is shown
+    bool lowerOnly = false; // if true, brush will only lower vertices
+    bool editQueue = false; // if true, each tick has the ability to produce more than one edit operation. if more than one is produced, theyre pushing into a queue and are completed asap
+    bool stampFlip = false; // whether the stamp is upside down or right side up
+    bool stampInvert = false; // whether the stamp is normal or mirrored vertically
+    bool stampStretch = false; // if true, the stamp will become two connected copies of itself equally spaced from the middle that rotate depending on mouse drag movement
+    bool useGhostMesh = false; // when set to true, a copy of the model selection is made which is then tested against for ray collision rather than the current mesh. setting to false clears the mesh
+    bool stampDrag = false; // set to true after the first stamp edit with stampStretch on, and off when the left mouse is released
+    HeightmapFormat saveFormat = HeightmapFormat::GRAYSCALE; // format to save the heightmap in. the split png uses all png channels (looks weird, saves more height resolution)
+    HeightmapFormat loadFormat = HeightmapFormat::GRAYSCALE; // format of the heightmap being loaded
+    
+    Vector2 lastRayHitLoc = {0, 0}; // coordinates of the model the mouse ray last hit
+    float lastRayHitY = 0; // height the mouse ray last hit the mesh at. rays are tested against it while an edit is being applied
+    
+    std::vector<HistoryStep> history;
+    std::vector<std::vector<unsigned int>> modelRevisions; // how many times each model's heights have changed. used to find the models that need saving
+    Project project; // the project last saved or opened
+    std::vector<VertexState> vertexSelection;
+    int frameHeapAllocations = 0; // allocations made last tick, shown under the fps
+    int frameArenaAllocations = 0;
+    TaskPoolStats poolStats = {};
+    UploadStats uploadStats = {};
+    std::vector<std::vector<Model>> models;      // 2d vector of all models
+    
+    std::vector<std::vector<Model>> ghostMesh;  // copy of a selection of models used for collision detection
+    
+    std::string xMeshString; // models on the x axis
+    std::string zMeshString; // models on the z axis
+    std::string xMeshSelectString; // width of the selection in models 
     std::string zMeshSelectString; // height of the selection in models 
     std::string stampAngleString; // angle of the stamp tool 
     std::string stampHeightString; // max height of the stamp tool 
@@ -283,7 +1312,6 @@ int main()
     modelSelection.height = 0;
     modelSelection.width = 0;
     
-    ModelSelection terrainCells; // the models surrounding the player in character mode
     
     // ANCHORS
     Vector2 meshSelectAnchor = {0, 66}; // location to which all mesh selection elements are relative
@@ -301,22 +1329,33 @@ int main()
     Rectangle panel3 = {0, 66, 101, 637};
     
     // SAVE WINDOW
-    Rectangle saveWindow = {saveWindowAnchor.x, saveWindowAnchor.y, 300, 235};
+    Rectangle saveWindow = {saveWindowAnchor.x, saveWindowAnchor.y, 300, 410};
     Rectangle saveWindowSaveButton = {saveWindowAnchor.x + 60, saveWindowAnchor.y + 155, 60, 20};
     Rectangle saveWindowCancelButton = {saveWindowAnchor.x + 180, saveWindowAnchor.y + 155, 60, 20};
     Rectangle saveWindowTextBox = {saveWindowAnchor.x + 30, saveWindowAnchor.y + 40, 240, 30};
     Rectangle saveWindowHeightBox = {saveWindowAnchor.x + 30, saveWindowAnchor.y + 115, 240, 30};
     Rectangle saveWindowGrayscale = {saveWindowAnchor.x + 15, saveWindowAnchor.y + 185, 12, 12};
     Rectangle saveWindow32bit = {saveWindowAnchor.x + 15, saveWindowAnchor.y + 210, 12, 12};
+    Rectangle saveWindow16bit = {saveWindowAnchor.x + 15, saveWindowAnchor.y + 235, 12, 12};
+    Rectangle saveWindowR16 = {saveWindowAnchor.x + 15, saveWindowAnchor.y + 260, 12, 12};
+    Rectangle saveWindowR32f = {saveWindowAnchor.x + 15, saveWindowAnchor.y + 285, 12, 12};
+    Rectangle saveWindowProject = {saveWindowAnchor.x + 15, saveWindowAnchor.y + 310, 12, 12};
+    Rectangle saveWindowObj = {saveWindowAnchor.x + 15, saveWindowAnchor.y + 335, 12, 12};
+    Rectangle saveWindowGlb = {saveWindowAnchor.x + 15, saveWindowAnchor.y + 360, 12, 12};
+    Rectangle saveWindowTiles = {saveWindowAnchor.x + 15, saveWindowAnchor.y + 385, 12, 12};
     
     // LOAD WINDOW
-    Rectangle loadWindow = {loadWindowAnchor.x, loadWindowAnchor.y, 300, 235};
+    Rectangle loadWindow = {loadWindowAnchor.x, loadWindowAnchor.y, 300, 335};
     Rectangle loadWindowLoadButton = {loadWindowAnchor.x + 60, loadWindowAnchor.y + 155, 60, 20};
     Rectangle loadWindowCancelButton = {loadWindowAnchor.x + 180, loadWindowAnchor.y + 155, 60, 20};
     Rectangle loadWindowTextBox = {loadWindowAnchor.x + 30, loadWindowAnchor.y + 40, 240, 30};
     Rectangle loadWindowHeightBox = {loadWindowAnchor.x + 30, loadWindowAnchor.y + 115, 240, 30};
     Rectangle loadWindowGrayscale = {loadWindowAnchor.x + 15, loadWindowAnchor.y + 185, 12, 12};
     Rectangle loadWindow32bit = {loadWindowAnchor.x + 15, loadWindowAnchor.y + 210, 12, 12};
+    Rectangle loadWindow16bit = {loadWindowAnchor.x + 15, loadWindowAnchor.y + 235, 12, 12};
+    Rectangle loadWindowR16 = {loadWindowAnchor.x + 15, loadWindowAnchor.y + 260, 12, 12};
+    Rectangle loadWindowR32f = {loadWindowAnchor.x + 15, loadWindowAnchor.y + 285, 12, 12};
+    Rectangle loadWindowProject = {loadWindowAnchor.x + 15, loadWindowAnchor.y + 310, 12, 12};
     
     // DIRECTORY WINDOW
     Rectangle dirWindow = {dirWindowAnchor.x, dirWindowAnchor.y, 500, 120};
@@ -327,6 +1366,7 @@ int main()
     // CANVAS PANEL
     Rectangle exportButton = {10, 557, 80, 40};
     Rectangle meshGenButton = {10, 80, 80, 40};
+    Rectangle tileResolutionButton = {10, 128, 80, 20};
     Rectangle xMeshBox = {35, 30, 55, 20};
     Rectangle zMeshBox = {35, 55, 55, 20};
     Rectangle updateTextureButton = {10, 457, 80, 40};
@@ -386,6 +1426,9 @@ int main()
     HeightMapMode heightMapMode = HeightMapMode::GRAYSCALE;
     
     InitWindow(windowWidth, windowHeight, "Pangea");
+    InitTaskPool(TASK_POOL_THREADS);
+    InitUploadRing(!UPLOAD_STUBS);
+    InitHeightmapShader(HEIGHTMAP_SHADER, displacementRendering);
     
     Camera3D camera = { 0 };
     camera.position = (Vector3){ 10.0f, 10.0f, 10.0f }; // Camera position
@@ -398,20 +1441,90 @@ int main()
     
     ChangeDirectory("C:/Users/msgs4/Desktop/Pangea");
     
-    SetTargetFPS(60);
+    SetTargetFPS(ACTIVE_FPS);
+    
+    tileScheduler.enabled = true;
+    
+    RenderTexture2D frameCache = LoadRenderTexture(windowWidth, windowHeight); // the editor as it was last drawn
+    bool frameCached = false; // false until frameCache holds a frame
+    float idleTime = 0; // seconds since anything changed
+    
+    auto GetSettings = [&]() -> ProjectSettings // editor state as it is saved in a project
+    {
+        ProjectSettings settings;
+        
+        settings.selectRadius = selectRadius;
+        settings.toolStrength = toolStrength;
+        settings.stampAngle = stampAngle;
+        settings.stampHeight = stampHeight;
+        settings.innerRadius = innerRadius;
+        settings.stampStretchLength = stampStretchLength;
+        settings.stampRotationAngle = stampRotationAngle;
+        settings.stampSlope = stampSlope;
+        settings.stampOffset = stampOffset;
+        settings.brush = (int)brush;
+        settings.heightMapMode = (int)heightMapMode;
+        settings.raiseOnly = raiseOnly;
+        settings.lowerOnly = lowerOnly;
+        settings.stampFlip = stampFlip;
+        settings.stampInvert = stampInvert;
+        settings.stampStretch = stampStretch;
+        settings.rayCollision2d = rayCollision2d;
+        settings.cameraPosition = camera.position;
+        settings.cameraTarget = camera.target;
+        
+        return settings;
+    };
+    
+    BindPager(models, highestY, lowestY, heightMapMode, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
+    BindSimulation(models, vertexSelection, history, stepIndex);
     
     while (!WindowShouldClose())
     {
+        bool canvasHeld = HoldCanvas(InputPressed()); // ticks with a click or key press wait for the edits in flight, most ui actions read or change the canvas. the rest only move the camera and draw until they are done
+        bool changed = false;
+        
+        if (canvasHeld)
+        {
+            changed = TakeSimulationCommits(modelRevisions);
+            changed = UpdatePager(camera.position) || changed; // bring back the models around the camera, page out the least recently used
+            changed = RunTileJobs(models, camera.position, modelVertexWidth, modelVertexHeight, modelWidth, highestY, lowestY, heightMapMode) || changed; // work earlier ticks put off
+        }
+        
+        changed = InputActive() || changed || continuousRendering || cameraSetting == CameraSetting::CHARACTER; // character mode simulates every tick
+        
+        if (changed)
+        {
+            if (idleTime >= IDLE_DELAY)
+                SetTargetFPS(ACTIVE_FPS);
+            
+            idleTime = 0;
+        }
+        else
+        {
+            idleTime += GetFrameTime();
+            
+            if (idleTime >= IDLE_DELAY && idleTime - GetFrameTime() < IDLE_DELAY) // just went idle
+                SetTargetFPS(IDLE_FPS);
+        }
+        
+        autosave.timer += GetFrameTime();
+        
+        if (autosave.timer >= AUTOSAVE_INTERVAL && !updateFlag && canvasHeld) // not in the middle of a stroke, so the history it saves is complete
+        {
+            StartAutosave(models, modelRevisions, GetSettings(), modelSelection, history, stepIndex, modelVertexWidth, modelVertexHeight);
+            autosave.timer = 0;
+        }
+        
         if (cameraSetting == CameraSetting::CHARACTER)
         {
-            UpdateCharacterCamera(&camera, models, terrainCells);
+            UpdateCharacterCamera(&camera, models, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight, canvasHeld);
             
             if (IsKeyPressed(KEY_TAB)) // exit character mode
             {
                 SetCameraMode(camera, CAMERA_FREE);
                 camera.fovy = 45.0f;
                 cameraSetting = CameraSetting::FREE;
-                terrainCells.selection.clear();
                 EnableCursor();
             }
             
@@ -422,15 +1535,7 @@ int main()
                 BeginMode3D(camera);
                 
                     if (!models.empty())
-                    {
-                        for (int i = 0; i < models.size(); i++)
-                        {
-                            for (int j = 0; j < models[i].size(); j++)
-                            {
-                                DrawModel(models[i][j], Vector3{0, 0, 0}, 1.0f, WHITE);
-                            }
-                        }
-                    }
+                        DrawCanvas(models, highestY, lowestY, heightMapMode);
                     
                     DrawGrid(100, 1.0f);
 
@@ -454,9 +1559,11 @@ int main()
             Vector2 stamp1; 
             Vector2 stamp2;
             
-            std::vector<VertexState> vertexIndices;   // information of the vertices within the select radius
-            static ModelSelection lastEditSelection; // models that were last edited. if updateFlag is true and lastEditSelection is different from editSelection while making an edit, the current history step will be updated
-            ModelSelection editSelection; // models that are being edited this tick
+            FrameVector<VertexState> vertexIndices;   // information of the vertices within the select radius
+            JournalCommand dab = {}; // this tick's brush dab, filled in as the cursor is tested against the mesh
+            static ModelSelection editSelection; // models that are being edited this tick. kept between ticks so its lists keep their memory, and emptied here
+            editSelection.selection.clear();
+            editSelection.expandedSelection.clear();
             
             Vector2 mousePosition = GetMousePosition();
             bool mousePressed = IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
@@ -485,27 +1592,34 @@ int main()
                 }
                 else if (CheckCollisionPointRec(mousePosition, saveWindowSaveButton) && mousePressed) // save mesh button
                 {
-                    std::string saveName = saveMeshString + ".png";
+                    std::string saveName = saveMeshString + HeightmapExtension(saveFormat);
                     char text[saveName.size() + 1];
                     strcpy(text, saveName.c_str()); 
                     
-                    Color* pixels;
+                    float maxHeight = highestY;
+                    
+                    if (!saveHeightString.empty())
+                        maxHeight = std::stof(saveHeightString);
                     
-                    if (saveHeightString.empty())
+                    if (saveFormat == HeightmapFormat::PROJECT)
                     {
-                        pixels = GenHeightmap(models, modelVertexWidth, modelVertexHeight, highestY, lowestY, saveGrayscale);
+                        SaveProject(project, text, models, modelRevisions, GetSettings(), modelSelection, history, stepIndex, modelVertexWidth, modelVertexHeight);
                     }
-                    else
+                    else if (saveFormat == HeightmapFormat::OBJ || saveFormat == HeightmapFormat::GLB)
                     {
-                        float maxHeight = std::stof(saveHeightString);
+                        int triangleBudget = MESH_EXPORT_TRIANGLE_BUDGET; // the height box holds the triangle budget for meshes
+                        
+                        if (!saveHeightString.empty())
+                            triangleBudget = std::stof(saveHeightString);
                         
-                        pixels = GenHeightmap(models, modelVertexWidth, modelVertexHeight, maxHeight, lowestY, saveGrayscale);
+                        ExportMesh(text, models, modelSelection.selection, modelVertexWidth, modelVertexHeight, modelWidth, triangleBudget, 0, saveFormat);
                     }
-                    
-                    Image image = LoadImageEx(pixels, canvasWidth * modelVertexWidth - (canvasWidth - 1), canvasHeight * modelVertexHeight - (canvasHeight - 1));
-                    ExportImage(image, text);
-                    RL_FREE(pixels);
-                    UnloadImage(image);
+                    else if (saveFormat == HeightmapFormat::TILES)
+                    {
+                        ExportTiles(text, models, modelVertexWidth, modelVertexHeight, modelWidth, maxHeight, lowestY, TILE_EXPORT_CHUNK_SIZE);
+                    }
+                    else
+                        ExportHeightmap(text, models, modelVertexWidth, modelVertexHeight, maxHeight, lowestY, saveFormat);
                     
                     if (FileExists(text)) // check if the file saved succesfully, and if so close the save window
                     {
@@ -522,11 +1636,39 @@ int main()
                 }
                 else if (CheckCollisionPointRec(mousePosition, saveWindowGrayscale) && mousePressed)
                 {
-                    saveGrayscale = true;
+                    saveFormat = HeightmapFormat::GRAYSCALE;
                 }
                 else if (CheckCollisionPointRec(mousePosition, saveWindow32bit) && mousePressed)
                 {
-                    saveGrayscale = false;
+                    saveFormat = HeightmapFormat::SPLIT;
+                }
+                else if (CheckCollisionPointRec(mousePosition, saveWindow16bit) && mousePressed)
+                {
+                    saveFormat = HeightmapFormat::PNG16;
+                }
+                else if (CheckCollisionPointRec(mousePosition, saveWindowR16) && mousePressed)
+                {
+                    saveFormat = HeightmapFormat::R16;
+                }
+                else if (CheckCollisionPointRec(mousePosition, saveWindowR32f) && mousePressed)
+                {
+                    saveFormat = HeightmapFormat::R32F;
+                }
+                else if (CheckCollisionPointRec(mousePosition, saveWindowProject) && mousePressed)
+                {
+                    saveFormat = HeightmapFormat::PROJECT;
+                }
+                else if (CheckCollisionPointRec(mousePosition, saveWindowObj) && mousePressed)
+                {
+                    saveFormat = HeightmapFormat::OBJ;
+                }
+                else if (CheckCollisionPointRec(mousePosition, saveWindowGlb) && mousePressed)
+                {
+                    saveFormat = HeightmapFormat::GLB;
+                }
+                else if (CheckCollisionPointRec(mousePosition, saveWindowTiles) && mousePressed)
+                {
+                    saveFormat = HeightmapFormat::TILES;
                 }
             }
             else if (showLoadWindow)
@@ -539,114 +1681,161 @@ int main()
                 {
                     inputFocus = InputFocus::LOAD_MESH_HEIGHT;
                 }
-                else if (CheckCollisionPointRec(mousePosition, loadWindowLoadButton) && mousePressed && !loadHeightString.empty())
+                else if (CheckCollisionPointRec(mousePosition, loadWindowLoadButton) && mousePressed && loadFormat == HeightmapFormat::PROJECT)
                 {
-                    std::string loadName = loadMeshString + ".png";
+                    std::string loadName = loadMeshString + HeightmapExtension(loadFormat);
                     char text[loadName.size() + 1];
                     strcpy(text, loadName.c_str()); 
                     
-                    Image import = LoadImage(text); // the image to turn into a mesh
-                    Color* importPixels = GetImageData(import);
+                    ProjectSettings settings;
                     
-                    if (import.width <= modelVertexWidth) // find the new canvas width and height, round up from import width and height
-                        canvasWidth = 1;
-                    else
-                    {
-                        canvasWidth = ceil((float)(import.width - modelVertexWidth) / (float)(modelVertexWidth - 1) + 1);
-                    }
+                    FinishAutosave(); // it reads the models being replaced
+                    StopJournal(journal); // a journal only replays onto the canvas it was started on
                     
-                    if (import.height <= modelVertexHeight)
-                        canvasHeight = 1;
-                    else
+                    if (OpenProject(project, text, models, modelRevisions, settings, modelSelection, history, stepIndex, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight, highestY, lowestY))
                     {
-                        canvasHeight = ceil((float)(import.height - modelVertexHeight) / (float)(modelVertexHeight - 1) + 1);
+                        canvasWidth = models.size();
+                        canvasHeight = models[0].size();
+                        
+                        selectRadius = settings.selectRadius;
+                        toolStrength = settings.toolStrength;
+                        stampAngle = settings.stampAngle;
+                        stampHeight = settings.stampHeight;
+                        innerRadius = settings.innerRadius;
+                        stampStretchLength = settings.stampStretchLength;
+                        stampRotationAngle = settings.stampRotationAngle;
+                        stampSlope = settings.stampSlope;
+                        stampOffset = settings.stampOffset;
+                        brush = (BrushTool)settings.brush;
+                        heightMapMode = (HeightMapMode)settings.heightMapMode;
+                        raiseOnly = settings.raiseOnly;
+                        lowerOnly = settings.lowerOnly;
+                        stampFlip = settings.stampFlip;
+                        stampInvert = settings.stampInvert;
+                        stampStretch = settings.stampStretch;
+                        rayCollision2d = settings.rayCollision2d;
+                        camera.position = settings.cameraPosition;
+                        camera.target = settings.cameraTarget;
+                        
+                        vertexSelection.clear();
+                        
+                        if (useGhostMesh) // the ghost mesh was copied from the old canvas
+                        {
+                            for (int i = 0; i < ghostMesh.size(); i++)
+                            {
+                                for (int j = 0; j < ghostMesh[i].size(); j++)
+                                    UnloadModel(ghostMesh[i][j]);
+                            }
+                            
+                            ghostMesh.clear();
+                            useGhostMesh = false;
+                        }
+                        
+                        loadHeightString.clear();
+                        inputFocus = InputFocus::NONE;
+                        showLoadWindow = false;
                     }
+                }
+                else if (CheckCollisionPointRec(mousePosition, loadWindowLoadButton) && mousePressed && (!loadHeightString.empty() || loadFormat == HeightmapFormat::R32F))
+                {
+                    std::string loadName = loadMeshString + HeightmapExtension(loadFormat);
+                    char text[loadName.size() + 1];
+                    strcpy(text, loadName.c_str()); 
                     
-                    models.clear();
-                    models.resize(canvasWidth);
+                    float heightRef = loadFormat == HeightmapFormat::R32F ? 1 : stof(loadHeightString); // r32f files hold the heights themselves, the height box is only for the 0 to 1 formats
                     
-                    highestY = FLT_MIN; // reset highest and lowest values
-                    lowestY = FLT_MAX;
+                    int importWidth = 0;
+                    int importHeight = 0;
+                    float* importHeights = LoadHeightGrid(text, loadFormat, importWidth, importHeight); // the whole file decoded once, 0 to 1
                     
-                    for (int i = 0; i < canvasWidth; i++) // turn the image into a 3d heightmap one model at a time
+                    if (importHeights)
                     {
-                        for (int j = 0; j < canvasHeight; j++)
+                        if (loadFormat != HeightmapFormat::R32F)
                         {
-                            Color* vertexPixels = (Color*)RL_MALLOC(modelVertexHeight*modelVertexWidth*sizeof(Color)); // pixels corresponding to this model
-                            
-                            int pixelIndex = i * (modelVertexWidth - 1) + j * (modelVertexHeight - 1) * import.width; // index of the pixel to be copied in importPixels
-                            
-                            int xLength = pixelIndex - pixelIndex / import.width * import.width; // number of pixels to the left of the current pixelIndex
-                            int yLength = pixelIndex / import.width; // number of pixels above the current pixelIndex
-                            
-                            for (int k = 0; k < modelVertexHeight*modelVertexWidth; k++) // fill vertexPixels with the matching pixels in importPixels
+                            for (int i = 0; i < importWidth * importHeight; i++) // scale to the pure white height in one pass, the grid is used as is from here
+                                importHeights[i] *= heightRef;
+                        }
+                        
+                        modelVertexWidth = tileResolution; // a new canvas, so it takes the picked resolution
+                        modelVertexHeight = tileResolution;
+                        
+                        if (importWidth <= modelVertexWidth) // find the new canvas width and height, round up from import width and height
+                            canvasWidth = 1;
+                        else
+                        {
+                            canvasWidth = ceil((float)(importWidth - modelVertexWidth) / (float)(modelVertexWidth - 1) + 1);
+                        }
+                        
+                        if (importHeight <= modelVertexHeight)
+                            canvasHeight = 1;
+                        else
+                        {
+                            canvasHeight = ceil((float)(importHeight - modelVertexHeight) / (float)(modelVertexHeight - 1) + 1);
+                        }
+                        
+                        FinishAutosave();
+                        StopJournal(journal); // a journal only replays onto the canvas it was started on
+                        
+                        for (int i = 0; i < models.size(); i++)
+                        {
+                            for (int j = 0; j < models[i].size(); j++)
+                                UnloadModel(models[i][j]);
+                        }
+                        
+                        models.clear();
+                        models.resize(canvasWidth);
+                        
+                        ResetPager(modelVertexWidth, modelVertexHeight);
+                        
+                        highestY = FLT_MIN; // reset highest and lowest values
+                        lowestY = FLT_MAX;
+                        
+                        std::vector<Mesh> column(canvasHeight);
+                        
+                        for (int i = 0; i < canvasWidth; i++) // turn the image into a 3d heightmap a column of models at a time
+                        {
+                            ParallelFor(canvasHeight, [&](int j) // built straight from the grid, already in place, on the pool and uploaded below
                             {
-                                if (k > 0 && k % modelVertexWidth == 0)
-                                    pixelIndex += import.width - modelVertexWidth; // iterate pixelIndex each time a row of pixels is completed
+                                float xOffset = (float)i * (modelWidth - (1 / (float)modelVertexWidth) * modelWidth);
+                                float zOffset = (float)j * (modelHeight - (1 / (float)modelVertexHeight) * modelHeight);
                                 
-                                // since the size of the canvas is in multiples of model width and height, it may have more vertices than the image has pixels. if the vertex is out of the image boundary, make its pixel black
-                                if (import.width < xLength + (k - (k / modelVertexWidth * modelVertexWidth) + 1) || import.height < yLength + k / modelVertexWidth + 1)
-                                {
-                                    vertexPixels[k].r = 0;
-                                    vertexPixels[k].g = 0;
-                                    vertexPixels[k].b = 0;
-                                    vertexPixels[k].a = 255;
-                                }
-                                else
-                                {
-                                    vertexPixels[k] = importPixels[pixelIndex + k];
-                                }
-                            }
-                            
-                            float heightRef = stof(loadHeightString);
+                                column[j] = GenMeshHeightGrid(importHeights, importWidth, importHeight, i * (modelVertexWidth - 1), j * (modelVertexHeight - 1), modelVertexWidth, modelVertexHeight, (Vector3){ modelWidth, 1, modelHeight }, Vector2{xOffset, zOffset}, false);
+                            });
                             
-                            Image tempImage = LoadImageEx(vertexPixels, modelVertexWidth, modelVertexHeight);
-                            //Mesh mesh = GenMeshHeightmap(tempImage, (Vector3){ modelWidth, heightRef, modelHeight });    // Generate heightmap mesh (RAM and VRAM)
-                            Model model;
-                            
-                            if (loadGrayscale)
-                                model = LoadModelFromMesh(GenMeshHeightmap(tempImage, (Vector3){ modelWidth, heightRef, modelHeight }));  
-                            else
-                                model = LoadModelFromMesh(GenMeshHeightmap32bit(tempImage, (Vector3){ modelWidth, heightRef, modelHeight })); 
-                            
-                            UnloadImage(tempImage);
-                            RL_FREE(vertexPixels);
-                            
-                            Color* pixels = GenHeightmap(model, modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);
-                            Image image = LoadImageEx(pixels, modelVertexWidth - 1, modelVertexHeight - 1);
-                            Texture2D tex = LoadTextureFromImage(image); // create a texture from the heightmap. height and width -1 so that pixels and polys are 1:1
-                            RL_FREE(pixels);
-                            UnloadImage(image);
-                            
-                            model.materials[0].maps[MAP_DIFFUSE].texture = tex;
-                            
-                            float xOffset = (float)i * (modelWidth - (1 / (float)modelVertexWidth) * modelWidth);
-                            float zOffset = (float)j * (modelHeight - (1 / (float)modelVertexHeight) * modelHeight);
-                            
-                            for (int i = 0; i < (model.meshes[0].vertexCount * 3) - 2; i += 3) // adjust vertex locations. (probably more sophisticated to do something with the transform but w/e)
+                            for (int j = 0; j < canvasHeight; j++)
                             {
-                                model.meshes[0].vertices[i] += xOffset;
-                                model.meshes[0].vertices[i + 2] += zOffset;
+                                if (!displacementGrid.enabled)
+                                    rlLoadMesh(&column[j], false);
+                                
+                                Model model = LoadModelFromMesh(column[j]);
+                                TextureTile(model, modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);
+                                
+                                models[i].push_back(model);
+                                
+                                TrimPager(); // page models out as it goes so a huge import doesnt have to fit in memory
                             }
-                            
-                            models[i].push_back(model);
                         }
                     }
                     
-                    UnloadImage(import);
-                    RL_FREE(importPixels);
+                    if (importHeights)
+                        RL_FREE(importHeights);
                     
                     history.clear(); // clear history if the canvas is shrunk so that undo operations dont go out of bounds
                     stepIndex = 0;
                     
+                    vertexSelection.clear(); // the models may not be the same size anymore
                     modelSelection.selection.clear();
                     
                     for (int i = 0; i < models.size(); i++)
                     {
                         for (int j = 0; j < models[i].size(); j++)
                         {
-                            rlUpdateBuffer(models[i][j].meshes[0].vboId[0], models[i][j].meshes[0].vertices, models[i][j].meshes[0].vertexCount*3*sizeof(float));    // Update vertex position 
-                            rlUpdateBuffer(models[i][j].meshes[0].vboId[2], models[i][j].meshes[0].vertices, models[i][j].meshes[0].vertexCount*3*sizeof(float));    // Update vertex normals 
+                            MarkModelChanged(modelRevisions, i, j);
+                            
+                            if (!ModelLoaded(models[i][j])) // paged out models are written to the page file as they are
+                                continue;
+                            
+                            UploadTile(models[i][j]);
                         }
                     }
                     
@@ -662,11 +1851,27 @@ int main()
                 }
                 else if (CheckCollisionPointRec(mousePosition, loadWindowGrayscale) && mousePressed)
                 {
-                    loadGrayscale = true;
+                    loadFormat = HeightmapFormat::GRAYSCALE;
                 }
                 else if (CheckCollisionPointRec(mousePosition, loadWindow32bit) && mousePressed)
                 {
-                    loadGrayscale = false;
+                    loadFormat = HeightmapFormat::SPLIT;
+                }
+                else if (CheckCollisionPointRec(mousePosition, loadWindow16bit) && mousePressed)
+                {
+                    loadFormat = HeightmapFormat::PNG16;
+                }
+                else if (CheckCollisionPointRec(mousePosition, loadWindowR16) && mousePressed)
+                {
+                    loadFormat = HeightmapFormat::R16;
+                }
+                else if (CheckCollisionPointRec(mousePosition, loadWindowR32f) && mousePressed)
+                {
+                    loadFormat = HeightmapFormat::R32F;
+                }
+                else if (CheckCollisionPointRec(mousePosition, loadWindowProject) && mousePressed)
+                {
+                    loadFormat = HeightmapFormat::PROJECT;
                 }
             }// check if the mouse is over a 2d element
             else if (showDirWindow)
@@ -763,23 +1968,7 @@ int main()
                                 
                                 showSaveWindow = true;
                                 
-                                highestY = FLT_MIN; // reset highest and lowest values
-                                lowestY = FLT_MAX;
-                                
-                                for (int i = 0; i < models.size(); i++) // find the highest and lowest values to display them in the save window
-                                {
-                                    for (int j = 0; j < models[i].size(); j++)
-                                    {
-                                        for (int k = 0; k < (models[i][j].meshes[0].vertexCount * 3) - 2; k += 3) 
-                                        {
-                                            if (models[i][j].meshes[0].vertices[k+1] > highestY)
-                                                highestY = models[i][j].meshes[0].vertices[k+1];
-                                                
-                                            if (models[i][j].meshes[0].vertices[k+1] < lowestY)
-                                                lowestY = models[i][j].meshes[0].vertices[k+1];
-                                        }
-                                    }
-                                }
+                                GetCanvasHeightRange(models, lowestY, highestY); // find the highest and lowest values to display them in the save window
                             }
                             else if (CheckCollisionPointRec(mousePosition, meshGenButton) && (!xMeshString.empty() || canvasWidth > 0) && (!zMeshString.empty() || canvasHeight > 0)) // add or remove models
                             {
@@ -797,8 +1986,19 @@ int main()
                                     zInput = canvasHeight;
                                 
                                 int xDifference = -(canvasWidth - xInput); // negate the difference so that positive is how many to add, negative to subtract
+                                
+                                FinishAutosave(); // models are about to move around in memory
+                                StopJournal(journal); // a journal only replays onto the canvas it was started on
                                 int zDifference = -(canvasHeight - zInput);
                                 
+                                if (models.empty() && modelVertexWidth != tileResolution) // a new canvas, so it takes the picked resolution
+                                {
+                                    modelVertexWidth = tileResolution;
+                                    modelVertexHeight = tileResolution;
+                                    ResetPager(modelVertexWidth, modelVertexHeight);
+                                    vertexSelection.clear();
+                                }
+                                
                                 if (xDifference > 0) 
                                 {
                                     models.reserve(xInput);
@@ -851,28 +2051,16 @@ int main()
                                             {
                                                 int j = models[i].size();
                                                 
-                                                Image tempImage = GenImageColor(modelVertexWidth, modelVertexHeight, BLACK);
-                                                Model model = LoadModelFromMesh(GenMeshHeightmap(tempImage, (Vector3){ modelWidth, 0, modelHeight }));  
-                                                UnloadImage(tempImage);
-                                                
-                                                Color* pixels = GenHeightmap(model, modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);
-                                                Image image = LoadImageEx(pixels, modelVertexWidth - 1, modelVertexHeight - 1);
-                                                Texture2D tex = LoadTextureFromImage(image); // create a texture from the heightmap. height and width -1 so that pixels and polys are 1:1
-                                                RL_FREE(pixels);
-                                                UnloadImage(image);
-                                                
-                                                model.materials[0].maps[MAP_DIFFUSE].texture = tex;
-                                                
-                                                float xOffset = (float)i * (modelWidth - (1 / (float)modelVertexWidth) * modelWidth); // adjust x and y values by multiples of modelWidth/Height minus the width/height of one poly in the mesh
+                                                float xOffset = (float)i * (modelWidth - (1 / (float)modelVertexWidth) * modelWidth); // multiples of modelWidth/Height minus the width/height of one poly in the mesh
                                                 float zOffset = (float)j * (modelHeight - (1 / (float)modelVertexHeight) * modelHeight);
                                                 
-                                                for (int i = 0; i < (model.meshes[0].vertexCount * 3) - 2; i += 3) // adjust vertex locations. (probably more sophisticated to do something with the transform but w/e)
-                                                {
-                                                    model.meshes[0].vertices[i] += xOffset;
-                                                    model.meshes[0].vertices[i + 2] += zOffset;
-                                                }
+                                                std::vector<float> flat(modelVertexWidth * modelVertexHeight, 0.0f);
+                                                Model model = LoadModelFromMesh(GenMeshHeightGrid(flat.data(), modelVertexWidth, modelVertexHeight, 0, 0, modelVertexWidth, modelVertexHeight, (Vector3){ (float)modelWidth, 1, (float)modelHeight }, Vector2{xOffset, zOffset}, !displacementGrid.enabled)); // already in place, and left on the cpu when displaced
+                                                TextureTile(model, modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);
 
                                                 models[i].push_back(model);
+                                                
+                                                TrimPager();
                                             }                             
                                         }   
                                     }
@@ -884,14 +2072,28 @@ int main()
                                 {
                                     for (int j = 0; j < models[i].size(); j++)
                                     {
-                                        rlUpdateBuffer(models[i][j].meshes[0].vboId[0], models[i][j].meshes[0].vertices, models[i][j].meshes[0].vertexCount*3*sizeof(float));    // Update vertex position 
-                                        rlUpdateBuffer(models[i][j].meshes[0].vboId[2], models[i][j].meshes[0].vertices, models[i][j].meshes[0].vertexCount*3*sizeof(float));    // Update vertex normals 
+                                        MarkModelChanged(modelRevisions, i, j);
+                                        
+                                        if (!ModelLoaded(models[i][j]))
+                                            continue;
+                                        
+                                        UploadTile(models[i][j]);
                                     }
                                 }
                                 
                                 xMeshString.clear();
                                 zMeshString.clear();
                             }
+                            else if (CheckCollisionPointRec(mousePosition, tileResolutionButton)) // cycle through the tile resolutions. takes effect on the next new canvas
+                            {
+                                int count = sizeof(tileResolutions) / sizeof(tileResolutions[0]);
+                                int i = 0;
+                                
+                                while (i < count && tileResolutions[i] != tileResolution)
+                                    i++;
+                                
+                                tileResolution = tileResolutions[(i + 1) % count];
+                            }
                             else if (CheckCollisionPointRec(mousePosition, xMeshBox))
                             {
                                 inputFocus = InputFocus::X_MESH;
@@ -902,26 +2104,7 @@ int main()
                             }
                             else if (CheckCollisionPointRec(mousePosition, updateTextureButton) && !models.empty()) // find the lowest and highest point on the mesh
                             {
-                                float maxY = models[0][0].meshes[0].vertices[1]; // start with the first y value;
-                                float minY = models[0][0].meshes[0].vertices[1];
-                                
-                                for (int i = 0; i < models.size(); i++)
-                                {
-                                    for (int j = 0; j < models[i].size(); j++)
-                                    {
-                                        for (int k = 0; k < (models[i][j].meshes[0].vertexCount * 3) - 2; k += 3) // check this models vertices
-                                        {
-                                            if (models[i][j].meshes[0].vertices[k + 1] > maxY)
-                                                maxY = models[i][j].meshes[0].vertices[k + 1];
-                                            
-                                            if (models[i][j].meshes[0].vertices[k + 1] < minY)
-                                                minY = models[i][j].meshes[0].vertices[k + 1];
-                                        }
-                                    }
-                                }
-                                
-                                highestY = maxY;
-                                lowestY = minY;
+                                GetCanvasHeightRange(models, lowestY, highestY);
                                 
                                 UpdateHeightmap(models, modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode); 
                             }
@@ -1081,56 +2264,17 @@ int main()
                             }
                             else if (brush == BrushTool::SELECT && CheckCollisionPointRec(mousePosition, deselectButton))
                             {
-                                vertexSelection.clear();
+                                JournalCommand deselect = {};
+                                deselect.type = JournalCommandType::DESELECT;
+                                
+                                SubmitEdit(deselect, editSelection, vertexIndices, maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
                             }
                             else if (brush == BrushTool::SELECT && CheckCollisionPointRec(mousePosition, trailToolButton) && !vertexSelection.empty() && vertexSelection[vertexSelection.size() - 1].y > 1) // use trail tool
                             {
-                                ModelSelection ms; // list of the models found in vertexSelection
-                                
-                                for (int i = 0; i < vertexSelection.size(); i++) // fill ms with all unique model coords
-                                {
-                                    int index; // insertion index
-                                    
-                                    if (BinarySearchVec2(vertexSelection[i].coords, ms.selection, index) == -1) // if these coords arent found, add them
-                                    {
-                                        ms.selection.insert(ms.selection.begin() + index, vertexSelection[i].coords);
-                                    }
-                                }
+                                JournalCommand trail = {};
+                                trail.type = JournalCommandType::TRAIL;
                                 
-                                NewHistoryStep(history, models, ms.selection, stepIndex, maxSteps);
-                                
-                                float top = models[vertexSelection[0].coords.x][vertexSelection[0].coords.y].meshes[0].vertices[vertexSelection[0].index + 1];
-                                float bottom = models[vertexSelection[(int)vertexSelection.size() - 1].coords.x][vertexSelection[(int)vertexSelection.size() - 1].coords.y].meshes[0].vertices[vertexSelection[(int)vertexSelection.size() - 1].index + 1];
-                                
-                                if (top < bottom) // swap values if selection was made bottom to top
-                                {
-                                    float temp = top;
-                                    top = bottom;
-                                    bottom = temp;
-                                }
-                                
-                                float increment = (top - bottom) / (vertexSelection[vertexSelection.size() - 1].y); // difference in height between layers on the slope
-                                
-                                for (int i = 0; i < vertexSelection.size(); i++)
-                                {
-                                    if (vertexSelection[i].y == 1) // flatten out the highest portion with the highest value
-                                        models[vertexSelection[i].coords.x][vertexSelection[i].coords.y].meshes[0].vertices[vertexSelection[i].index + 1] = top;
-                                    
-                                    models[vertexSelection[i].coords.x][vertexSelection[i].coords.y].meshes[0].vertices[vertexSelection[i].index + 1] = top - (increment * (vertexSelection[i].y - 1));
-                                } 
-                                
-                                FinalizeHistoryStep(history[stepIndex - 1], models);
-                                
-                                for (int i = 0; i < models.size(); i++)
-                                {
-                                    for (int j = 0; j < models[i].size(); j++)
-                                    {
-                                        rlUpdateBuffer(models[i][j].meshes[0].vboId[0], models[i][j].meshes[0].vertices, models[i][j].meshes[0].vertexCount*3*sizeof(float));    // Update vertex position 
-                                        rlUpdateBuffer(models[i][j].meshes[0].vboId[2], models[i][j].meshes[0].vertices, models[i][j].meshes[0].vertexCount*3*sizeof(float));    // Update vertex normals 
-                                            
-                                        UpdateHeightmap(models[i][j], modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);  
-                                    }                                    
-                                }
+                                SubmitEdit(trail, editSelection, vertexIndices, maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
                             }
                             else if (brush == BrushTool::SELECT && CheckCollisionPointRec(mousePosition, selectionMaskButton))
                             {
@@ -1510,6 +2654,8 @@ int main()
                                 }
                                 else
                                 {
+                                    RequireModels(modelSelection.selection);
+                                    
                                     ghostMesh.resize(modelSelection.width);
                                     
                                     for (int i = 0; i < modelSelection.width; i++)
@@ -1527,39 +2673,12 @@ int main()
                             }
                             else if (brush == BrushTool::SMOOTH && CheckCollisionPointRec(mousePosition, smoothMeshesButton) && !modelSelection.selection.empty()) // smooth all selected models
                             {
-                                NewHistoryStep(history, models, modelSelection.expandedSelection, stepIndex, maxSteps);
-                                
-                                std::vector<VertexState> vertices; // vertices to pass to smooth
-                                
-                                for (int i = 0; i < modelSelection.selection.size(); i++) // loop through all selected models
-                                {
-                                    for (int j = 0; j < models[modelSelection.selection[i].x][modelSelection.selection[i].y].meshes[0].vertexCount; j++) // loop through vertices
-                                    {
-                                        VertexState vs;
-                                        
-                                        vs.coords = modelSelection.selection[i];
-                                        vs.index = j * 3;
-                                        
-                                        vertices.push_back(vs); // add this vertex's info 
-                                    }
-                                }
-                                
-                                Smooth(models, vertices, modelVertexWidth, modelVertexHeight, canvasWidth, canvasHeight);
-                                
-                                ModelStitch(models, modelSelection, modelVertexWidth, modelVertexHeight); // overlapping vertices of adjacent models need to be changed as well
+                                JournalCommand smooth = {};
+                                smooth.type = JournalCommandType::SMOOTH_MODELS;
+                                smooth.topLeft = modelSelection.topLeft;
+                                smooth.bottomRight = modelSelection.bottomRight;
                                 
-                                FinalizeHistoryStep(history[stepIndex - 1], models);
-                                
-                                for (int i = 0; i < models.size(); i++)
-                                {
-                                    for (int j = 0; j < models[i].size(); j++)
-                                    {
-                                        rlUpdateBuffer(models[i][j].meshes[0].vboId[0], models[i][j].meshes[0].vertices, models[i][j].meshes[0].vertexCount*3*sizeof(float));    // Update vertex position 
-                                        rlUpdateBuffer(models[i][j].meshes[0].vboId[2], models[i][j].meshes[0].vertices, models[i][j].meshes[0].vertexCount*3*sizeof(float));    // Update vertex normals 
-                                            
-                                        UpdateHeightmap(models[i][j], modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);  
-                                    }                                    
-                                }
+                                SubmitEdit(smooth, editSelection, vertexIndices, maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
                             }
                             
                             break;
@@ -1717,18 +2836,35 @@ int main()
                         {
                             hitPosition = FindHit3D(ray, ghostMesh, lastRayHitLoc);
                         }
+                        else if (!canvasHeld) // the simulation thread is changing the mesh, so the stroke carries on at the height it was last on
+                        {
+                            hitPosition = FindHit2D(ray, models, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight, lastRayHitY);
+                            
+                            if (hitPosition.hit)
+                            {
+                                float realModelWidth = modelWidth - (1 / (float)modelVertexWidth) * modelWidth; // modelWidth minus the width of one polygon
+                                lastRayHitLoc.x = (int)(hitPosition.position.x / realModelWidth); // convert to int to truncate decimal
+                                lastRayHitLoc.y = (int)(hitPosition.position.z / realModelWidth); 
+                            }
+                        }
                         else
                         {
                             hitPosition = FindHit3D(ray, models, lastRayHitLoc);
+                            
+                            if (FaultInRay(ray, hitPosition.hit ? hitPosition.distance : FLT_MAX)) // paged out models in front of the hit, or under the cursor if nothing was hit
+                                hitPosition = FindHit3D(ray, models, lastRayHitLoc);
                         }
+                        
+                        if (hitPosition.hit)
+                            lastRayHitY = hitPosition.position.y;
                     }
                     else if (!IsMouseButtonDown(MOUSE_RIGHT_BUTTON) && rayCollision2d)
                     {
-                        hitPosition = FindHit2D(ray, models, modelVertexWidth, modelVertexHeight);
+                        hitPosition = FindHit2D(ray, models, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
                         
                         if (hitPosition.hit)
                         {
-                            float realModelWidth = modelWidth - (1 / 120.f) * modelWidth; // modelWidth minus the width of one polygon. ASSUMES MODELVERTEXWIDTH = 120
+                            float realModelWidth = modelWidth - (1 / (float)modelVertexWidth) * modelWidth; // modelWidth minus the width of one polygon
                             lastRayHitLoc.x = (int)(hitPosition.position.x / realModelWidth); // convert to int to truncate decimal
                             lastRayHitLoc.y = (int)(hitPosition.position.z / realModelWidth); 
                         }
@@ -1736,336 +2872,86 @@ int main()
                     
                     if (hitPosition.hit)
                     {
-                        if (stampStretch && brush == BrushTool::STAMP) // if stampStretch is on, this affects the range FindModelSelection uses
-                        {
-                            editSelection = FindModelSelection(canvasWidth, canvasHeight, modelWidth, lastRayHitLoc, selectRadius + stampStretchLength/2);
-                        }
+                        dab.position = hitPosition.position;
+                        dab.brush = (unsigned char)brush;
+                        dab.modelRadius = stampStretch && brush == BrushTool::STAMP ? selectRadius + stampStretchLength/2 : selectRadius; // if stampStretch is on, this affects the range the models are found in
+                        
+                        if (stampStretch && brush == BrushTool::STAMP)
+                            dab.vertexRadius = stampStretchLength/2+selectRadius+innerRadius; // this info will be used to find the height of the cylinders drawn around hit position
+                        else if (innerRadius > 0 && brush == BrushTool::STAMP)
+                            dab.vertexRadius = selectRadius+innerRadius;
                         else
-                        {
-                            editSelection = FindModelSelection(canvasWidth, canvasHeight, modelWidth, lastRayHitLoc, selectRadius);
-                        }
+                            dab.vertexRadius = selectRadius;
+                        
+                        if (canvasHeld)
+                            FindDabSelection(dab, models, modelVertexWidth, modelVertexHeight, modelWidth, editSelection, vertexIndices);
+                        else // left to the simulation thread, after the edits ahead of it
+                            vertexIndices.clear();
+                        
+                        if (stampStretch && brush == BrushTool::STAMP)
+                            FindStampPoints(stampRotationAngle, stampStretchLength, stamp1, stamp2, Vector2{hitPosition.position.x, hitPosition.position.z});
                     }
                     else
                     {
                         lastRayHitLoc = prevRayHitLoc; // if the cursor isnt over a model, reverse changes made to lastRayHitLoc
                     }
-                    
-                    if (hitPosition.hit && stampStretch && brush == BrushTool::STAMP)
-                    {
-                        vertexIndices = FindVertexSelection(models, editSelection, hitPosition, stampStretchLength/2+selectRadius+innerRadius); // this info will be used to find the height of the cylinders drawn around hit position
-                        
-                        FindStampPoints(stampRotationAngle, stampStretchLength, stamp1, stamp2, Vector2{hitPosition.position.x, hitPosition.position.z});
-                    }
-                    else if (hitPosition.hit && innerRadius > 0 && brush == BrushTool::STAMP)
-                    {
-                        vertexIndices = FindVertexSelection(models, editSelection, hitPosition, selectRadius+innerRadius);
-                    }
-                    else if (hitPosition.hit)
-                    {
-                        vertexIndices = FindVertexSelection(models, editSelection, hitPosition, selectRadius);
-                    }
                 }
                 
-                if (mouseDown && hitPosition.hit && brush == BrushTool::ELEVATION)
+                if (mouseDown && hitPosition.hit && (brush == BrushTool::ELEVATION || brush == BrushTool::FLATTEN || brush == BrushTool::SMOOTH || brush == BrushTool::SELECT))
                 {
-                    if (!updateFlag) // update the history before executing if this is the first tick of the operation
-                    {
-                        NewHistoryStep(history, models, editSelection.selection, stepIndex, maxSteps);
-                    }
-                    else if (editSelection != lastEditSelection)
-                    {
-                        ExtendHistoryStep(history[stepIndex - 1], models, editSelection);
-                    }
+                    dab.type = JournalCommandType::DAB;
+                    dab.strength = toolStrength;
                     
-                    if (IsKeyDown(KEY_LEFT_CONTROL)) // do the inverse if left ctrl is held
-                    {
-                        if (selectionMask) // if selection mask is on, dont modify selected vertices
-                        {
-                            for (int i = 0; i < vertexIndices.size(); ++i) // TODO change to a better search once vertexSelection is sorted
-                            {
-                                bool match = false;
-                                
-                                for (int j = 0; j < vertexSelection.size(); j++)
-                                {
-                                    if (vertexIndices[i] == vertexSelection[j])
-                                    {
-                                        match = true;
-                                        break;
-                                    }
-                                }
-                                
-                                if (!match)
-                                    models[vertexIndices[i].coords.x][vertexIndices[i].coords.y].meshes[0].vertices[vertexIndices[i].index+1] -= toolStrength;
-                            }
-                        }
-                        else
-                        {
-                            for (int i = 0; i < vertexIndices.size(); ++i)
-                                models[vertexIndices[i].coords.x][vertexIndices[i].coords.y].meshes[0].vertices[vertexIndices[i].index+1] -= toolStrength;
-                        }
-                    }
-                    else
-                    {
-                        if (selectionMask) // if selection mask is on, dont modify selected vertices
-                        {
-                            for (int i = 0; i < vertexIndices.size(); ++i) // TODO change to a better search once vertexSelection is sorted
-                            {
-                                bool match = false;
-                                
-                                for (int j = 0; j < vertexSelection.size(); j++)
-                                {
-                                    if (vertexIndices[i] == vertexSelection[j])
-                                    {
-                                        match = true;
-                                        break;
-                                    }
-                                }
-                                
-                                if (!match)
-                                    models[vertexIndices[i].coords.x][vertexIndices[i].coords.y].meshes[0].vertices[vertexIndices[i].index+1] += toolStrength;
-                            }
-                        }
-                        else
-                        {
-                            for (int i = 0; i < vertexIndices.size(); ++i)
-                                models[vertexIndices[i].coords.x][vertexIndices[i].coords.y].meshes[0].vertices[vertexIndices[i].index+1] += toolStrength;
-                        }                   
-                    }
+                    if (!updateFlag) // the history is updated before editing if this is the first tick of the operation
+                        dab.flags |= JOURNAL_STROKE_START;
                     
-                    for (int i = 0; i < editSelection.selection.size(); i++)
-                    {
-                        rlUpdateBuffer(models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vboId[0], models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices, models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex position 
-                        rlUpdateBuffer(models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vboId[2], models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices, models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex normals 
-                    }
+                    if (IsKeyDown(KEY_LEFT_CONTROL)) // do the inverse if left ctrl is held
+                        dab.flags |= JOURNAL_INVERT;
                     
-                    timeCounter += GetFrameTime();
+                    if (selectionMask && brush != BrushTool::SELECT) // if selection mask is on, dont modify selected vertices
+                        dab.flags |= JOURNAL_MASK;
                     
-                    if (timeCounter >= 0.1f) // update heightmap every tenth of a second
-                    {
-                        for (int i = 0; i < editSelection.selection.size(); i++)
-                        {
-                            UpdateHeightmap(models[editSelection.selection[i].x][editSelection.selection[i].y], modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode); 
-                        }
-                        
-                        timeCounter = 0;
-                    }
+                    SubmitEdit(dab, editSelection, vertexIndices, maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight, !canvasHeld);
                     
-                    updateFlag = true;
+                    if (brush != BrushTool::SELECT) // selecting doesnt change the mesh
+                        updateFlag = true;
                 }
                 
-                if (mouseDown && hitPosition.hit && brush == BrushTool::FLATTEN)
+                if (mouseDown && hitPosition.hit && brush == BrushTool::STAMP)
                 {
-                    if (!updateFlag) // update the history before executing if this is the first tick of the operation
-                    {
-                        NewHistoryStep(history, models, editSelection.selection, stepIndex, maxSteps);
-                    }
-                    else if (editSelection != lastEditSelection)
-                    {
-                        ExtendHistoryStep(history[stepIndex - 1], models, editSelection);
-                    }
+                    static Vector2 previousLocation; // location of the last hit position
                     
-                    if (selectionMask) // if selection mask is on, dont modify selected vertices
+                    if (stampSlope != 0 && stampDrag && !stampStretch && !IsKeyDown(KEY_F)) // adjust the select radius if there is a slope and the stamp is being dragged. if stamp stretch is true, this is done later. holding F prevents
                     {
-                        for (int i = 0; i < vertexIndices.size(); ++i) // TODO change to a better search once vertexSelection is sorted 
+                        float distance = xzDistance(Vector2{hitPosition.position.x, hitPosition.position.z}, previousLocation); // distance between the current and previous hit position
+                        float angle = 90 - fabs(stampSlope); // right triangle with 90 degrees and stampSlope on top, angle is on bottom
+                        float heightDifference = distance/sinf(angle*DEG2RAD)*sinf(fabs(stampSlope)*DEG2RAD);
+                        
+                        float ratio = sinf((90 - stampAngle)*DEG2RAD) / sinf(stampAngle*DEG2RAD); // rise to run ratio, used to determine how much height difference translates into select radius difference
+                        
+                        if (stampSlope > 0)
+                            selectRadius = selectRadius + ratio * heightDifference;
+                        else
                         {
-                            bool match = false;
-                            
-                            for (int j = 0; j < vertexSelection.size(); j++)
-                            {
-                                if (vertexIndices[i] == vertexSelection[j])
-                                {
-                                    match = true;
-                                    break;
-                                }
-                            }
-                            
-                            if (!match)
-                                models[vertexIndices[i].coords.x][vertexIndices[i].coords.y].meshes[0].vertices[vertexIndices[i].index+1] = hitPosition.position.y;
-                        }
-                    }
-                    else
-                    {
-                        for (int i = 0; i < vertexIndices.size(); ++i)
-                            models[vertexIndices[i].coords.x][vertexIndices[i].coords.y].meshes[0].vertices[vertexIndices[i].index+1] = hitPosition.position.y;
-                    }    
-                    
-                    for (int i = 0; i < editSelection.selection.size(); i++)
-                    {
-                        rlUpdateBuffer(models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vboId[0], models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices, models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex position 
-                        rlUpdateBuffer(models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vboId[2], models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices, models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex normals 
-                    }
-                    
-                    timeCounter += GetFrameTime();
-                    
-                    if (timeCounter >= 0.1f)
-                    {
-                        for (int i = 0; i < editSelection.selection.size(); i++)
-                        {
-                            UpdateHeightmap(models[editSelection.selection[i].x][editSelection.selection[i].y], modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode); 
-                        }
-                        
-                        timeCounter = 0;
-                    }
-                    
-                    updateFlag = true;
-                }
-                
-                if (mouseDown && hitPosition.hit && brush == BrushTool::SELECT)
-                {
-                    if (IsKeyDown(KEY_LEFT_CONTROL)) // if left ctrl is down, do the deselect
-                    {
-                        for (int i = 0; i < vertexIndices.size(); i++)
-                        {
-                            for (int j = 0; j < vertexSelection.size(); j++)
-                            {
-                                if(vertexIndices[i] == vertexSelection[j])
-                                {
-                                    vertexSelection.erase(vertexSelection.begin() + j);
-                                    break;
-                                }
-                            }
-                        }   
-                    }
-                    else
-                    {
-                        // add to vertexselection 
-                        if (vertexSelection.empty()) 
-                        {
-                            for (int i = 0; i < vertexIndices.size(); i++) // TODO sort selection, with timer
-                            {
-                                VertexState temp;
-                                temp.coords = vertexIndices[i].coords;
-                                temp.index = vertexIndices[i].index;
-                                temp.y = 1; // y is used here to represent when this vertex was selected
-                                vertexSelection.push_back(temp);
-                            }
-                        }
-                        else 
-                        {
-                            int selectionStep = vertexSelection[vertexSelection.size() - 1].y;
-                            
-                            for (int i = 0; i < vertexIndices.size(); i++)
-                            {
-                                bool add = true;
-                                
-                                for (int j = 0; j < vertexSelection.size(); j++)
-                                {
-                                    if(vertexIndices[i] == vertexSelection[j])
-                                    {
-                                        add = false;
-                                        break;
-                                    }
-                                }
-                                
-                                if (add) // adding to vector seems to have a big performance cost at larger sizes
-                                {
-                                    VertexState temp;
-                                    temp.coords = vertexIndices[i].coords;
-                                    temp.index = vertexIndices[i].index;
-                                    temp.y = selectionStep + 1; // y is used here to represent when this vertex was selected
-                                    vertexSelection.push_back(temp);
-                                }
-                            }
-                        }                            
-                    }
-                }
-                
-                if (mouseDown && hitPosition.hit && brush == BrushTool::SMOOTH) // smooth by moving each vertex closer to the average y of its neighbors
-                {
-                    if (!updateFlag) // update the history before executing if this is the first tick of the operation
-                    {
-                        NewHistoryStep(history, models, editSelection.selection, stepIndex, maxSteps);
-                    }
-                    else if (editSelection != lastEditSelection)
-                    {
-                        ExtendHistoryStep(history[stepIndex - 1], models, editSelection);
-                    }
-                    
-                    if (selectionMask) // if selection mask is on, dont modify selected vertices
-                    {
-                        std::vector<VertexState> vertices;
-                        
-                        for (int i = 0; i < vertexIndices.size(); ++i) // TODO change to a better search once vertexSelection is sorted
-                        {
-                            bool selected = false;
-                            
-                            for (int j = 0; j < vertexSelection.size(); j++)
-                            {
-                                if (vertexIndices[i] == vertexSelection[j])
-                                {
-                                    selected = true;
-                                    break;
-                                }
-                            }
-                            
-                            if (!selected)
-                            {
-                                vertices.push_back(vertexIndices[i]);
-                            }
-                        }
-                        
-                        Smooth(models, vertices, modelVertexWidth, modelVertexHeight, canvasWidth, canvasHeight);
-                    }
-                    else
-                    {
-                        Smooth(models, vertexIndices, modelVertexWidth, modelVertexHeight, canvasWidth, canvasHeight);
-                    }  
-
-                    for (int i = 0; i < editSelection.selection.size(); i++)
-                    {
-                        rlUpdateBuffer(models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vboId[0], models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices, models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex position 
-                        rlUpdateBuffer(models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vboId[2], models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices, models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex normals 
-                    }
-                    
-                    timeCounter += GetFrameTime();
-                    
-                    if (timeCounter >= 0.1f) // update the heightmap at intervals of .1 seconds while the tool is being used
-                    {
-                        for (int i = 0; i < editSelection.selection.size(); i++)
-                        {
-                            UpdateHeightmap(models[editSelection.selection[i].x][editSelection.selection[i].y], modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);
-                        }
-                        
-                        timeCounter = 0;
-                    }
-                    
-                    updateFlag = true;
-                }
-                
-                if (mouseDown && hitPosition.hit && brush == BrushTool::STAMP)
-                {
-                    if (!updateFlag) // update the history before executing if this is the first tick of the operation
-                    {
-                        NewHistoryStep(history, models, editSelection.selection, stepIndex, maxSteps);
-                    }
-                    else if (editSelection != lastEditSelection)
-                    {
-                        ExtendHistoryStep(history[stepIndex - 1], models, editSelection);
-                    }
-                    
-                    static Vector2 previousLocation; // location of the last hit position
-                    
-                    if (stampSlope != 0 && stampDrag && !stampStretch && !IsKeyDown(KEY_F)) // adjust the select radius if there is a slope and the stamp is being dragged. if stamp stretch is true, this is done later. holding F prevents
-                    {
-                        float distance = xzDistance(Vector2{hitPosition.position.x, hitPosition.position.z}, previousLocation); // distance between the current and previous hit position
-                        float angle = 90 - fabs(stampSlope); // right triangle with 90 degrees and stampSlope on top, angle is on bottom
-                        float heightDifference = distance/sinf(angle*DEG2RAD)*sinf(fabs(stampSlope)*DEG2RAD);
-                        
-                        float ratio = sinf((90 - stampAngle)*DEG2RAD) / sinf(stampAngle*DEG2RAD); // rise to run ratio, used to determine how much height difference translates into select radius difference
-                        
-                        if (stampSlope > 0)
-                            selectRadius = selectRadius + ratio * heightDifference;
-                        else
-                        {
-                            selectRadius = selectRadius - ratio * heightDifference;
+                            selectRadius = selectRadius - ratio * heightDifference;
                             
                             if (selectRadius < 0)
                                 selectRadius = 0;
                         }
                     }
                     
-                    float influenceRadius = selectRadius + innerRadius; // select radius is expanded by inner radius
-                    float heightCap = selectRadius*sinf(stampAngle*DEG2RAD)/sinf((180 - (90 + stampAngle))*DEG2RAD); // max height that can be produced by this select radius and stamp angle
+                    StampParams stamp; // settings shared by the circular and stretched stamp
+                    stamp.influenceRadius = selectRadius + innerRadius; // select radius is expanded by inner radius
+                    stamp.innerRadius = innerRadius;
+                    stamp.slopeRatio = sinf(stampAngle*DEG2RAD)/sinf((180 - (90 + stampAngle))*DEG2RAD);
+                    stamp.heightCap = selectRadius*stamp.slopeRatio; // max height that can be produced by this select radius and stamp angle
+                    stamp.offset = stampOffset;
+                    stamp.baseY = 0;
+                    stamp.cutOff = stampHeight;
+                    stamp.flip = stampFlip;
+                    stamp.invert = stampInvert;
+                    stamp.raiseOnly = raiseOnly;
+                    stamp.lowerOnly = lowerOnly;
                     
                     if (stampStretch) // find the vertex selection if stamp stretch is on, which has to be done differently
                     {       
@@ -2161,156 +3047,47 @@ int main()
                         
                         FindStampPoints(stampRotationAngle, stampStretchLength, stamp1, stamp2, stampAnchor);
                         
-                        RayHitInfo hp; // hit position on the mesh at the stamp anchor
-                        hp.hit = false;
-                        
-                        if (!rayCollision2d)
+                        if (!rayCollision2d) // if the mouse cursor mode is 3d, the stamp sits on the mesh at the stamp anchor, not the cursor hit position
                         {
-                            // if stamp stretch is on, the height to add to vertexY has to be found at stamp anchor, not cursor hit position
-                            Ray ray = {Vector3{stampAnchor.x, highestY, stampAnchor.y}, Vector3{0, -1, 0}}; 
+                            float anchorY;
+                            bool anchorFound;
                             
                             if (useGhostMesh && !ghostMesh.empty())
+                                anchorFound = SampleHeight(ghostMesh, stampAnchor.x, stampAnchor.y, anchorY, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight, modelSelection.topLeft);
+                            else if (!canvasHeld) // the mesh is being changed, the same height the ray was tested at
                             {
-                                hp = FindHit3D(ray, ghostMesh, lastRayHitLoc);
+                                anchorY = lastRayHitY;
+                                anchorFound = true;
                             }
                             else
-                            {
-                                for (int i = 0; i < editSelection.selection.size(); i++)
-                                {
-                                    hp = GetCollisionRayModel2(ray, &models[editSelection.selection[i].x][editSelection.selection[i].y]);
-                                    
-                                    if (hp.hit) 
-                                        break;
-                                }
-                            }
-                        }
-                        
-                        for (int i = 0; i < editSelection.selection.size(); i++) // check all models recorded by modelSelection for vertices to be modified
-                        {
-                            for (int j = 0; j < (models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertexCount * 3) - 2; j += 3) // check this models vertices
-                            {
-                                float& vertexY = models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices[j + 1]; // make an alias for this montrosity
-                                
-                                Vector2 vertexCoords = {models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices[j], models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices[j+2]};
+                                anchorFound = SampleHeight(models, stampAnchor.x, stampAnchor.y, anchorY, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
                             
-                                float dist = PointSegmentDistance(vertexCoords, stamp1, stamp2);
-                                
-                                if (dist <= influenceRadius)
-                                {
-                                    float yValue = vertexY; // old y value of this vertex
-                                    
-                                    if (stampFlip) // if stamp is upside down
-                                    {
-                                        dist = dist - innerRadius; // distance from the middle of the selection
-                                        
-                                        if (dist < 0) // the vertices inside inner radius will be at y = 0
-                                            vertexY = 0;
-                                        else
-                                            vertexY = dist*sinf(stampAngle*DEG2RAD)/sinf((180 - (90 + stampAngle))*DEG2RAD); 
-                                    }
-                                    else
-                                        vertexY = (influenceRadius - dist)*sinf(stampAngle*DEG2RAD)/sinf((180 - (90 + stampAngle))*DEG2RAD);
-                                    
-                                    if (vertexY > heightCap) // if the vertex is within the inner radius, limit its height extention
-                                        vertexY = heightCap;
-                                    
-                                    if (stampInvert) // invert vertexY
-                                        vertexY = -vertexY;
-                                    
-                                    if (stampOffset != 0) // add stamp offset
-                                        vertexY += stampOffset;
-                                    
-                                    if (!rayCollision2d) // if the mouse cursor mode is 3d, add the hit position y to vertexY
-                                    {
-                                        vertexY += hp.position.y;
-                                    }
-                                    
-                                    if (stampHeight && vertexY > stampHeight) // dont allow vertexY to go higher than what stampHeight (cut off) is set to
-                                        vertexY = stampHeight;
-                                        
-                                    if (raiseOnly && vertexY < yValue) // if raise only is on and vertex has been lowered, reverse it
-                                        vertexY = yValue;
-                                        
-                                    if (lowerOnly && vertexY > yValue) // if lower only is on and vertex has been raised, reverse it
-                                        vertexY = yValue;
-                                }
-                            }
+                            if (anchorFound)
+                                stamp.baseY = anchorY;
                         }
+                        
+                        dab.flags |= JOURNAL_STRETCH;
+                        dab.stampPoints[0] = stamp1;
+                        dab.stampPoints[1] = stamp2;
                     }
-                    else
+                    else if (!rayCollision2d) // if the mouse cursor mode is 3d, add the hit position y to vertexY
                     {
-                        for (int i = 0; i < vertexIndices.size(); i++)
-                        {
-                            float& vertexY = models[vertexIndices[i].coords.x][vertexIndices[i].coords.y].meshes[0].vertices[vertexIndices[i].index + 1]; // make an alias for this montrosity
-                            
-                            Vector2 vertexPos = {models[vertexIndices[i].coords.x][vertexIndices[i].coords.y].meshes[0].vertices[vertexIndices[i].index], models[vertexIndices[i].coords.x][vertexIndices[i].coords.y].meshes[0].vertices[vertexIndices[i].index + 2]};
-                            
-                            float dist = influenceRadius - xzDistance(Vector2{hitPosition.position.x, hitPosition.position.z}, vertexPos); // distance from the edge of the selection radius
-                            float yValue = vertexY;// old y value of this vertex
-
-                            if (stampFlip) // if stamp is upside down
-                            {
-                                dist = xzDistance(Vector2{hitPosition.position.x, hitPosition.position.z}, vertexPos) - innerRadius; // distance from the middle of the selection
-                                
-                                if (dist < 0) // the vertices inside inner radius will be at y = 0
-                                    vertexY = 0;
-                                else
-                                    vertexY = dist*sinf(stampAngle*DEG2RAD)/sinf((180 - (90 + stampAngle))*DEG2RAD); 
-                            }
-                            else
-                                vertexY = dist*sinf(stampAngle*DEG2RAD)/sinf((180 - (90 + stampAngle))*DEG2RAD);
-                            
-                            if (vertexY > heightCap) // if the vertex is within the inner radius, limit its height extention
-                                vertexY = heightCap;
-                            
-                            if (stampInvert) // invert vertexY
-                                vertexY = -vertexY;
-                            
-                            if (stampOffset != 0) // add stamp offset
-                                vertexY += stampOffset;
-                            
-                            if (!rayCollision2d) // if the mouse cursor mode is 3d, add the hit position y to vertexY
-                                vertexY += hitPosition.position.y;
-                                
-                            if (stampHeight && vertexY > stampHeight) // dont allow vertexY to go higher than what stampHeight (cut off) is set to
-                                vertexY = stampHeight;
-                                
-                            if (raiseOnly && vertexY < yValue) // if raise only is on and vertex has been lowered, reverse it
-                                vertexY = yValue;
-                                
-                            if (lowerOnly && vertexY > yValue) // if lower only is on and vertex has been raised, reverse it
-                                vertexY = yValue;
-                        }
+                        stamp.baseY = hitPosition.position.y;
                     }
                     
-                    stampDrag = true; // set to true so subsequent edits will act accordingly. reset to false on mouse click release
-                    previousLocation = {hitPosition.position.x, hitPosition.position.z}; // change previous location to current location so it's ready for the next tick
+                    dab.type = JournalCommandType::DAB;
+                    dab.stamp = stamp;
                     
-                    for (int i = 0; i < editSelection.selection.size(); i++)
-                    {
-                        rlUpdateBuffer(models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vboId[0], models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices, models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex position 
-                        rlUpdateBuffer(models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vboId[2], models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertices, models[editSelection.selection[i].x][editSelection.selection[i].y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex normals 
-                    }
+                    if (!updateFlag) // the history is updated before editing if this is the first tick of the operation
+                        dab.flags |= JOURNAL_STROKE_START;
                     
-                    timeCounter += GetFrameTime();
+                    SubmitEdit(dab, editSelection, vertexIndices, maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight, !canvasHeld);
                     
-                    if (timeCounter >= 0.1f) // update heightmap every tenth of a second
-                    {
-                        for (int i = 0; i < editSelection.selection.size(); i++)
-                        {
-                            UpdateHeightmap(models[editSelection.selection[i].x][editSelection.selection[i].y], modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode); 
-                        }
-                        
-                        timeCounter = 0;
-                    }
+                    stampDrag = true; // set to true so subsequent edits will act accordingly. reset to false on mouse click release
+                    previousLocation = {hitPosition.position.x, hitPosition.position.z}; // change previous location to current location so it's ready for the next tick
                     
                     updateFlag = true;
                 }
-            
-                if (hitPosition.hit)
-                {
-                    lastEditSelection = editSelection; // update what the lastEditSelection was 
-                }
             }
             else
             {
@@ -2401,9 +3178,6 @@ int main()
                     {
                         Ray ray = GetMouseRay(GetMousePosition(), camera);
                         
-                        int modelx; 
-                        int modely;
-                    
                         if (!models.empty())
                         {
                             for (int i = 0; i < models.size(); i++) // test ray against all models
@@ -2412,12 +3186,8 @@ int main()
                                 {
                                     hitPosition = GetCollisionRayModel2(ray, &models[i][j]); 
                                     
-                                    if (hitPosition.hit) // if collision is found, record which and break the search
-                                    {
-                                        modelx = i;
-                                        modely = j;
+                                    if (hitPosition.hit) // if collision is found, break the search
                                         break;
-                                    }
                                 }
                                 
                                 if (hitPosition.hit) break;
@@ -2426,10 +3196,8 @@ int main()
                         
                         if (hitPosition.hit)
                         {
-                            terrainCells.selection.push_back(Vector2{modelx, modely}); // first cell is whichever one the player begins in
-                            FillTerrainCells(terrainCells, models);
-                            
                             camera.position = Vector3{hitPosition.position.x, hitPosition.position.y + playerEyesHeight, hitPosition.position.z};
+                            PlaceCharacter(hitPosition.position);
                             SetCameraMode(camera, CAMERA_CUSTOM);
                             camera.fovy = 65.0f;
                             cameraSetting = CameraSetting::CHARACTER;
@@ -2439,8 +3207,6 @@ int main()
                 }
                 else
                 {
-                    timeCounter = 0;
-                    
                     if (stampDrag)
                     {
                         stampDrag = false;
@@ -2448,13 +3214,10 @@ int main()
                     
                     if (updateFlag) // if an edit was just completed
                     {
-                        FinalizeHistoryStep(history[stepIndex - 1], models);
+                        JournalCommand strokeEnd = {};
+                        strokeEnd.type = JournalCommandType::STROKE_END;
                         
-                        for (int i = 0; i < history[stepIndex - 1].modelCoords.size(); i++)
-                        {
-                            UpdateNormals(models[history[stepIndex - 1].modelCoords[i].x][history[stepIndex - 1].modelCoords[i].y], modelVertexWidth, modelVertexHeight);
-                            UpdateHeightmap(models[history[stepIndex - 1].modelCoords[i].x][history[stepIndex - 1].modelCoords[i].y], modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);
-                        }
+                        SubmitEdit(strokeEnd, editSelection, vertexIndices, maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
                         
                         updateFlag = false;                
                     }
@@ -2463,93 +3226,86 @@ int main()
             
             if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_Z) && stepIndex > 0 && !history.empty()) // undo key
             {
-                for (int i = 0; i < history[stepIndex - 1].startingVertices.size(); i++) // reinstate the previous state of the mesh as recorded by the startingVertices at stepIndex - 1
-                {
-                    int x = history[stepIndex - 1].startingVertices[i].coords.x;
-                    int y = history[stepIndex - 1].startingVertices[i].coords.y;
-                    
-                    models[x][y].meshes[0].vertices[history[stepIndex - 1].startingVertices[i].index + 1] = history[stepIndex - 1].startingVertices[i].y; 
-                }
+                JournalCommand undo = {};
+                undo.type = JournalCommandType::UNDO;
                 
-                for (int i = 0; i < history[stepIndex - 1].modelCoords.size(); i++)
-                {
-                    int x = history[stepIndex - 1].modelCoords[i].x;
-                    int y = history[stepIndex - 1].modelCoords[i].y;
-                    
-                    UpdateNormals(models[x][y], modelVertexWidth, modelVertexHeight);
-                    
-                    rlUpdateBuffer(models[x][y].meshes[0].vboId[0], models[x][y].meshes[0].vertices, models[x][y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex position 
-                    rlUpdateBuffer(models[x][y].meshes[0].vboId[2], models[x][y].meshes[0].vertices, models[x][y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex normals 
-           
-                    UpdateHeightmap(models[x][y], modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode); 
-                }         
-
-                stepIndex--;
+                SubmitEdit(undo, editSelection, vertexIndices, maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
             }
             
             if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_X) && !history.empty() && stepIndex < (int)history.size()) // redo key
             {
-                for (int i = 0; i < history[stepIndex].endingVertices.size(); i++) // reinstate the previous state of the mesh as recorded by the endingVertices at stepIndex
-                {
-                    int x = history[stepIndex].endingVertices[i].coords.x;
-                    int y = history[stepIndex].endingVertices[i].coords.y;
-                    
-                    models[x][y].meshes[0].vertices[history[stepIndex].endingVertices[i].index + 1] = history[stepIndex].endingVertices[i].y;
-                }           
-
-                for (int i = 0; i < history[stepIndex].modelCoords.size(); i++)
-                {
-                    int x = history[stepIndex].modelCoords[i].x;
-                    int y = history[stepIndex].modelCoords[i].y;
-                    
-                    UpdateNormals(models[x][y], modelVertexWidth, modelVertexHeight);
-                    
-                    rlUpdateBuffer(models[x][y].meshes[0].vboId[0], models[x][y].meshes[0].vertices, models[x][y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex position 
-                    rlUpdateBuffer(models[x][y].meshes[0].vboId[2], models[x][y].meshes[0].vertices, models[x][y].meshes[0].vertexCount*3*sizeof(float));    // Update vertex normals 
-           
-                    UpdateHeightmap(models[x][y], modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode); 
-                }   
-
-                stepIndex++;               
+                JournalCommand redo = {};
+                redo.type = JournalCommandType::REDO;
+                
+                SubmitEdit(redo, editSelection, vertexIndices, maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
             }
             
             if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_D) && !vertexSelection.empty()) // deselect
             {
-                vertexSelection.clear();
+                JournalCommand deselect = {};
+                deselect.type = JournalCommandType::DESELECT;
+                
+                SubmitEdit(deselect, editSelection, vertexIndices, maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
+            }
+            
+            if (IsKeyPressed(KEY_F7)) // color the canvas in the shader, or with the cpu textures
+                SetHeightmapShader(!heightmapShader.enabled, models, modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);
+            
+            if (IsKeyPressed(KEY_F8)) // draw every frame, or only when something changes
+                continuousRendering = !continuousRendering;
+            
+            if (IsKeyPressed(KEY_F9) && !updateFlag && !models.empty()) // start or stop recording the edit journal. not in the middle of a stroke, so a journal never starts or ends halfway through one
+            {
+                if (journal.file)
+                    StopJournal(journal);
+                else
+                {
+                    if (!StartJournal(journal, JOURNAL_FILE_NAME, canvasWidth, canvasHeight, modelVertexWidth, modelVertexHeight, maxSteps, CanvasChecksum(models, modelVertexWidth, modelVertexHeight)))
+                        TraceLog(LOG_WARNING, "JOURNAL: [%s] couldnt be written", JOURNAL_FILE_NAME);
+                }
             }
             
-            if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_T)) // hotkey for updating the texture
+            if (IsKeyPressed(KEY_F10) && !updateFlag && !journal.file && !models.empty()) // replay the edit journal onto the canvas at full speed. it should be the canvas the journal was started on, as it was then
             {
-                float maxY = models[0][0].meshes[0].vertices[1]; // start with the first y value;
-                float minY = models[0][0].meshes[0].vertices[1];
+                JournalHeader header;
+                std::vector<JournalCommand> commands;
                 
-                for (int i = 0; i < models.size(); i++)
+                if (!LoadJournal(JOURNAL_FILE_NAME, header, commands))
+                    TraceLog(LOG_WARNING, "JOURNAL: [%s] couldnt be read", JOURNAL_FILE_NAME);
+                else if (header.canvasWidth != canvasWidth || header.canvasHeight != canvasHeight || header.modelVertexWidth != modelVertexWidth || header.modelVertexHeight != modelVertexHeight || header.maxSteps != maxSteps) // undo and redo only land where they did with the same history length, the same as a batch replays it
+                    TraceLog(LOG_WARNING, "JOURNAL: [%s] was recorded on a different canvas or history length", JOURNAL_FILE_NAME);
+                else if (header.checksum != CanvasChecksum(models, modelVertexWidth, modelVertexHeight)) // already replayed, edited since, or another canvas the same size
+                    TraceLog(LOG_WARNING, "JOURNAL: [%s] was started on a canvas with different heights", JOURNAL_FILE_NAME);
+                else
                 {
-                    for (int j = 0; j < models[i].size(); j++)
+                    ReplayJournal(commands, models, vertexSelection, history, stepIndex, header.maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
+                    
+                    for (int i = 0; i < models.size(); i++)
                     {
-                        for (int k = 0; k < (models[i][j].meshes[0].vertexCount * 3) - 2; k += 3) // check this models vertices
+                        for (int j = 0; j < models[i].size(); j++)
                         {
-                            if (models[i][j].meshes[0].vertices[k + 1] > maxY)
-                                maxY = models[i][j].meshes[0].vertices[k + 1];
+                            if (!ModelLoaded(models[i][j])) // paged out models werent touched
+                                continue;
                             
-                            if (models[i][j].meshes[0].vertices[k + 1] < minY)
-                                minY = models[i][j].meshes[0].vertices[k + 1];
+                            MarkModelChanged(modelRevisions, i, j);
+                            ScheduleTileJob(i, j, TILE_JOB_UPLOAD | TILE_JOB_HEIGHTMAP);
                         }
                     }
                 }
+            }
+            
+            if (IsKeyDown(KEY_LEFT_CONTROL) && IsKeyPressed(KEY_T) && !models.empty()) // hotkey for updating the texture
+            {
+                GetCanvasHeightRange(models, lowestY, highestY);
                 
-                highestY = maxY;
-                lowestY = minY;
-                
-                for (int i = 0; i < models.size(); i++) // update normals
+                for (int i = 0; i < models.size(); i++) // paged out models are textured when they are loaded again
                 {
                     for (int j = 0; j < models[i].size(); j++)
                     {
-                        UpdateNormals(models[i][j], modelVertexWidth, modelVertexHeight);
+                        if (ModelLoaded(models[i][j]))
+                            ScheduleTileJob(i, j, TILE_JOB_NORMALS | TILE_JOB_HEIGHTMAP);
                     }
                 }
-                
-                UpdateHeightmap(models, modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode); 
             }
             
             switch (inputFocus)
@@ -2854,26 +3610,20 @@ int main()
         DRAWING
     **********************************************************************************************************************************************************************/
             
-            BeginDrawing();
-            
+            if (changed || !frameCached) // drawn into frameCache, and only when something could have changed
+            {
+                BeginTextureMode(frameCache);
+                
                 ClearBackground(Color{240, 240, 240, 255});
                 
                 BeginMode3D(camera);
                 
                     if (!models.empty()) // draw models
-                    {
-                        for (int i = 0; i < models.size(); i++)
-                        {
-                            for (int j = 0; j < models[i].size(); j++)
-                            {
-                                DrawModel(models[i][j], Vector3{0, 0, 0}, 1.0f, WHITE);
-                            }
-                        }
-                    }
+                        DrawCanvas(models, highestY, lowestY, heightMapMode);
                     
                     if (models.empty()) DrawGrid(100, 1.0f);
                     
-                    if (!vertexSelection.empty()) // draw every selected vertex
+                    if (canvasHeld && !vertexSelection.empty()) // draw every selected vertex. not while the simulation thread could be changing it
                     {
                         Color vertexColor;
                         
@@ -2886,6 +3636,9 @@ int main()
                         
                         for (size_t i = 0; i < vertexSelection.size(); i += increment)
                         {
+                            if (!ModelLoaded(models[vertexSelection[i].coords.x][vertexSelection[i].coords.y]))
+                                continue;
+                            
                             Vector3 v = {models[vertexSelection[i].coords.x][vertexSelection[i].coords.y].meshes[0].vertices[vertexSelection[i].index], models[vertexSelection[i].coords.x][vertexSelection[i].coords.y].meshes[0].vertices[vertexSelection[i].index + 1], models[vertexSelection[i].coords.x][vertexSelection[i].coords.y].meshes[0].vertices[vertexSelection[i].index + 2]};
                             
                             DrawCube(v, 0.03f, 0.03f, 0.03f, vertexColor);
@@ -2950,7 +3703,7 @@ int main()
                     
                     if (!modelSelection.selection.empty()) // draw model selection frame
                     {
-                        float realModelWidth = modelWidth - (1 / 120.f) * modelWidth; // modelWidth minus the width of one polygon. ASSUMES MODELVERTEXWIDTH = 120
+                        float realModelWidth = modelWidth - (1 / (float)modelVertexWidth) * modelWidth; // modelWidth minus the width of one polygon
                         float cubeY;
                         
                         if (highestY > realModelWidth)
@@ -2981,7 +3734,7 @@ int main()
                 if (hitPosition.hit)
                     DrawText(FormatText("%f", hitPosition.position.x), 400, 30, 15, BLACK);
                 
-                if (history.size())
+                if (canvasHeld && history.size())
                 {
                     for (int i = 0; i < history[stepIndex - 1].modelCoords.size(); i++)
                     {
@@ -3005,7 +3758,6 @@ int main()
                 }
                 */
                 
-                DrawFPS(windowWidth - 30, 8);
                 DrawRectangleRec(UI, Color{200, 200, 200, 50});
                 
                 Color panelColor = {200, 200, 200, 150};
@@ -3046,11 +3798,13 @@ int main()
                         
                         DrawRectangleRec(exportButton, GRAY);
                         DrawRectangleRec(meshGenButton, GRAY);
+                        DrawRectangleRec(tileResolutionButton, GRAY);
                         DrawRectangleRec(loadButton, GRAY);
                         DrawRectangleRec(updateTextureButton, GRAY);
                         DrawRectangleRec(directoryButton, GRAY);
                         DrawTextRec(GetFontDefault(), "Update Texture", Rectangle {updateTextureButton.x + 5, updateTextureButton.y + 1, updateTextureButton.width - 2, updateTextureButton.height - 2}, 15, 1.f, true, BLACK);
                         DrawTextRec(GetFontDefault(), "Generate Mesh", Rectangle {meshGenButton.x + 5, meshGenButton.y + 1, meshGenButton.width - 2, meshGenButton.height - 2}, 15, 1.f, true, BLACK);
+                        DrawText(TextFormat("Tiles: %i", tileResolution), tileResolutionButton.x + 5, tileResolutionButton.y + 3, 15, tileResolution == modelVertexWidth || canvasWidth == 0 ? BLACK : DARKGRAY); // grayed out while it differs from the current canvas
                         DrawTextRec(GetFontDefault(), "Export Heightmap", Rectangle {exportButton.x + 5, exportButton.y + 1, exportButton.width - 2, exportButton.height - 2}, 15, 1.f, true, BLACK);
                         DrawTextRec(GetFontDefault(), "Load Heightmap", Rectangle {loadButton.x + 5, loadButton.y + 1, loadButton.width - 2, loadButton.height - 2}, 15, 1.f, true, BLACK);
                         DrawTextRec(GetFontDefault(), "Change Directory", Rectangle {directoryButton.x + 5, directoryButton.y + 1, directoryButton.width - 2, directoryButton.height - 2}, 15, 1.f, true, BLACK);
@@ -3386,18 +4140,53 @@ int main()
                     DrawRectangleRec(saveWindowHeightBox, WHITE);
                     DrawRectangleRec(saveWindowGrayscale, WHITE);
                     DrawRectangleRec(saveWindow32bit, WHITE);
+                    DrawRectangleRec(saveWindow16bit, WHITE);
+                    DrawRectangleRec(saveWindowR16, WHITE);
+                    DrawRectangleRec(saveWindowR32f, WHITE);
+                    DrawRectangleRec(saveWindowProject, WHITE);
+                    DrawRectangleRec(saveWindowObj, WHITE);
+                    DrawRectangleRec(saveWindowGlb, WHITE);
+                    DrawRectangleRec(saveWindowTiles, WHITE);
                     
                     DrawTextRec(GetFontDefault(), "Save", Rectangle {saveWindowSaveButton.x + 3, saveWindowSaveButton.y + 3, saveWindowSaveButton.width - 2, saveWindowSaveButton.height - 2}, 15, 0.5f, false, BLACK);
                     DrawTextRec(GetFontDefault(), "Cancel", Rectangle {saveWindowCancelButton.x + 3, saveWindowCancelButton.y + 3, saveWindowCancelButton.width - 2, saveWindowCancelButton.height - 2}, 15, 0.5f, false, BLACK);
-                    DrawText("Save heightmap as .png:", saveWindowAnchor.x + 6, saveWindowAnchor.y + 12, 17, BLACK);
-                    DrawText("Reference height (for scale):", saveWindowAnchor.x + 6, saveWindowAnchor.y + 87, 17, BLACK);
+                    DrawText("Save heightmap as:", saveWindowAnchor.x + 6, saveWindowAnchor.y + 12, 17, BLACK);
+                    
+                    bool meshFormat = saveFormat == HeightmapFormat::OBJ || saveFormat == HeightmapFormat::GLB;
+                    
+                    if (meshFormat)
+                        DrawText("Triangle budget:", saveWindowAnchor.x + 6, saveWindowAnchor.y + 87, 17, BLACK);
+                    else
+                        DrawText("Reference height (for scale):", saveWindowAnchor.x + 6, saveWindowAnchor.y + 87, 17, BLACK);
+                    
                     DrawText("Save as grayscale (8 bits)", saveWindowGrayscale.x + 16, saveWindowGrayscale.y - 1, 15, BLACK);
                     DrawText("Save using 4 channels (32 bits)", saveWindow32bit.x + 16, saveWindow32bit.y - 1, 15, BLACK);
+                    DrawText("Save as 16 bit png", saveWindow16bit.x + 16, saveWindow16bit.y - 1, 15, BLACK);
+                    DrawText("Save as raw 16 bit (.r16)", saveWindowR16.x + 16, saveWindowR16.y - 1, 15, BLACK);
+                    DrawText("Save as raw float (.r32)", saveWindowR32f.x + 16, saveWindowR32f.y - 1, 15, BLACK);
+                    DrawText("Save as project (.pangea)", saveWindowProject.x + 16, saveWindowProject.y - 1, 15, BLACK);
+                    DrawText("Save as mesh (.obj)", saveWindowObj.x + 16, saveWindowObj.y - 1, 15, BLACK);
+                    DrawText("Save as mesh (.glb)", saveWindowGlb.x + 16, saveWindowGlb.y - 1, 15, BLACK);
+                    DrawText("Save as tiles with mips (.json)", saveWindowTiles.x + 16, saveWindowTiles.y - 1, 15, BLACK);
                     
-                    if (saveGrayscale)
+                    if (saveFormat == HeightmapFormat::GRAYSCALE)
                         DrawText("+", saveWindowGrayscale.x + 1, saveWindowGrayscale.y - 3, 20, BLACK);
-                    else
+                    else if (saveFormat == HeightmapFormat::SPLIT)
                         DrawText("+", saveWindow32bit.x + 1, saveWindow32bit.y - 3, 20, BLACK);
+                    else if (saveFormat == HeightmapFormat::PNG16)
+                        DrawText("+", saveWindow16bit.x + 1, saveWindow16bit.y - 3, 20, BLACK);
+                    else if (saveFormat == HeightmapFormat::R16)
+                        DrawText("+", saveWindowR16.x + 1, saveWindowR16.y - 3, 20, BLACK);
+                    else if (saveFormat == HeightmapFormat::R32F)
+                        DrawText("+", saveWindowR32f.x + 1, saveWindowR32f.y - 3, 20, BLACK);
+                    else if (saveFormat == HeightmapFormat::OBJ)
+                        DrawText("+", saveWindowObj.x + 1, saveWindowObj.y - 3, 20, BLACK);
+                    else if (saveFormat == HeightmapFormat::GLB)
+                        DrawText("+", saveWindowGlb.x + 1, saveWindowGlb.y - 3, 20, BLACK);
+                    else if (saveFormat == HeightmapFormat::TILES)
+                        DrawText("+", saveWindowTiles.x + 1, saveWindowTiles.y - 3, 20, BLACK);
+                    else
+                        DrawText("+", saveWindowProject.x + 1, saveWindowProject.y - 3, 20, BLACK);
                     
                     char text[saveMeshString.size() + 1];
                     strcpy(text, saveMeshString.c_str());  
@@ -3405,7 +4194,7 @@ int main()
                     
                     if (saveHeightString.empty() && inputFocus != InputFocus::SAVE_MESH_HEIGHT)
                     {
-                        std::string tempString = std::to_string(highestY);
+                        std::string tempString = meshFormat ? std::to_string(MESH_EXPORT_TRIANGLE_BUDGET) : std::to_string(highestY);
                         char text[tempString.size() + 1];
                         strcpy(text, tempString.c_str());  
                         DrawTextRec(GetFontDefault(), text, Rectangle {saveWindowHeightBox.x + 3, saveWindowHeightBox.y + 3, saveWindowHeightBox.width - 2, saveWindowHeightBox.height - 2}, 15, 0.5f, false, BLACK);
@@ -3435,18 +4224,34 @@ int main()
                     DrawRectangleRec(loadWindowHeightBox, WHITE);
                     DrawRectangleRec(loadWindowGrayscale, WHITE);
                     DrawRectangleRec(loadWindow32bit, WHITE);
+                    DrawRectangleRec(loadWindow16bit, WHITE);
+                    DrawRectangleRec(loadWindowR16, WHITE);
+                    DrawRectangleRec(loadWindowR32f, WHITE);
+                    DrawRectangleRec(loadWindowProject, WHITE);
                     
                     DrawTextRec(GetFontDefault(), "Load", Rectangle {loadWindowLoadButton.x + 3, loadWindowLoadButton.y + 3, loadWindowLoadButton.width - 2, loadWindowLoadButton.height - 2}, 15, 0.5f, false, BLACK);
                     DrawTextRec(GetFontDefault(), "Cancel", Rectangle {loadWindowCancelButton.x + 3, loadWindowCancelButton.y + 3, loadWindowCancelButton.width - 2, loadWindowCancelButton.height - 2}, 15, 0.5f, false, BLACK);
-                    DrawText("Load heightmap (png):", loadWindowAnchor.x + 6, loadWindowAnchor.y + 12, 17, BLACK);
+                    DrawText("Load heightmap:", loadWindowAnchor.x + 6, loadWindowAnchor.y + 12, 17, BLACK);
                     DrawText("Pure white height value (for scale):", loadWindowAnchor.x + 6, loadWindowAnchor.y + 87, 17, BLACK);
-                    DrawText("Image is grayscale", saveWindowGrayscale.x + 16, saveWindowGrayscale.y - 1, 15, BLACK);
-                    DrawText("Image is split png", saveWindow32bit.x + 16, saveWindow32bit.y - 1, 15, BLACK);
+                    DrawText("Image is grayscale", loadWindowGrayscale.x + 16, loadWindowGrayscale.y - 1, 15, BLACK);
+                    DrawText("Image is split png", loadWindow32bit.x + 16, loadWindow32bit.y - 1, 15, BLACK);
+                    DrawText("Image is 16 bit png", loadWindow16bit.x + 16, loadWindow16bit.y - 1, 15, BLACK);
+                    DrawText("Raw 16 bit (.r16)", loadWindowR16.x + 16, loadWindowR16.y - 1, 15, BLACK);
+                    DrawText("Raw float (.r32)", loadWindowR32f.x + 16, loadWindowR32f.y - 1, 15, BLACK);
+                    DrawText("Project (.pangea)", loadWindowProject.x + 16, loadWindowProject.y - 1, 15, BLACK);
                     
-                    if (loadGrayscale)
+                    if (loadFormat == HeightmapFormat::GRAYSCALE)
                         DrawText("+", loadWindowGrayscale.x + 1, loadWindowGrayscale.y - 3, 20, BLACK);
-                    else
+                    else if (loadFormat == HeightmapFormat::SPLIT)
                         DrawText("+", loadWindow32bit.x + 1, loadWindow32bit.y - 3, 20, BLACK);
+                    else if (loadFormat == HeightmapFormat::PNG16)
+                        DrawText("+", loadWindow16bit.x + 1, loadWindow16bit.y - 3, 20, BLACK);
+                    else if (loadFormat == HeightmapFormat::R16)
+                        DrawText("+", loadWindowR16.x + 1, loadWindowR16.y - 3, 20, BLACK);
+                    else if (loadFormat == HeightmapFormat::R32F)
+                        DrawText("+", loadWindowR32f.x + 1, loadWindowR32f.y - 3, 20, BLACK);
+                    else
+                        DrawText("+", loadWindowProject.x + 1, loadWindowProject.y - 3, 20, BLACK);
                     
                     char text[loadMeshString.size() + 1];
                     strcpy(text, loadMeshString.c_str());  
@@ -3490,11 +4295,60 @@ int main()
                 {
                     DrawCircle(mousePosition.x, mousePosition.y, characterButton.width / 2 - 4, ORANGE);
                 }
+                
+                EndTextureMode();
+                
+                frameCached = true;
+            }
+            
+            BeginDrawing();
+            
+                DrawTextureRec(frameCache.texture, Rectangle{0, 0, (float)frameCache.texture.width, -(float)frameCache.texture.height}, Vector2{0, 0}, WHITE); // render textures are upside down
+                
+                DrawFPS(windowWidth - 30, 8); // drawn every tick, so they stay current while the frame is reused
+                DrawText(TextFormat("heap allocs: %i", frameHeapAllocations), windowWidth - 120, 32, 10, DARKGRAY);
+                DrawText(TextFormat("frame allocs: %i", frameArenaAllocations), windowWidth - 120, 44, 10, DARKGRAY);
+                DrawText(TextFormat("pool: %i%% of %i, %i tasks", (int)(poolStats.busy * 100), poolStats.threads, poolStats.tasks), windowWidth - 120, 56, 10, DARKGRAY);
+                DrawText(TextFormat("stolen: %i", poolStats.stolen), windowWidth - 120, 68, 10, DARKGRAY);
+                DrawText(TextFormat("uploads: %i, %i kb", uploadStats.uploads, (int)(uploadStats.bytes / 1024)), windowWidth - 120, 80, 10, DARKGRAY);
+                
+                if (uploadStats.stalls)
+                    DrawText(TextFormat("staging stalls: %i", uploadStats.stalls), windowWidth - 120, 92, 10, RED);
+                
+                if (journal.file)
+                    DrawText(TextFormat("recording journal: %i", journal.commandCount), windowWidth - 120, 104, 10, RED);
+                
+                if (continuousRendering)
+                    DrawText("continuous rendering", windowWidth - 120, 116, 10, DARKGRAY);
+                
+                if (!canvasHeld)
+                    DrawText("applying edit", windowWidth - 120, 128, 10, DARKGRAY);
             
             EndDrawing();
         }
+        
+        frameHeapAllocations = heapAllocationCount.exchange(0);
+        frameArenaAllocations = frameArena.allocations;
+        poolStats = TakeTaskPoolStats();
+        uploadStats = AdvanceUploadRing();
+        ResetFrameArena(frameArena);
+        ReleaseCanvas();
     }
     
+    ShutdownSimulation();
+    FinishAutosave();
+    StopJournal(journal);
+    ShutdownPager();
+    ShutdownTaskPool();
+    
+    UnloadRenderTexture(frameCache);
+    UnloadMaterial(heightmapShader.material);
+    
+    if (displacementGrid.palette.material.maps)
+        UnloadMaterial(displacementGrid.palette.material);
+    
+    if (displacementGrid.grid.vertices)
+        UnloadMesh(displacementGrid.grid);
     CloseWindow();
     
     return 0;
@@ -3578,7 +4432,6 @@ void NewHistoryStep(std::vector<HistoryStep>& history, const std::vector<std::ve
         stepIndex = history.size();
     }
 
-    std::vector<VertexState> state; // info of the vertices recorded by this history step
     HistoryStep step; // history step to be added to history
     
     for (int i = 0; i < modelCoords.size(); i++) // go through each of the models 
@@ -3597,13 +4450,11 @@ void NewHistoryStep(std::vector<HistoryStep>& history, const std::vector<std::ve
            temp.coords = modelCoords[i];
            temp.y = models[modelCoords[i].x][modelCoords[i].y].meshes[0].vertices[j+1];
            
-           state.push_back(temp);
+           step.startingVertices.push_back(temp);
         }
     }
     
-    step.startingVertices = state;
-    
-    history.push_back(step);
+    history.push_back(std::move(step)); // moved so the recorded vertices arent copied again
     stepIndex = history.size(); // history step is iterated here rather than in FinalizeHistoryStep() because the history size may have just been changed
 }
 
@@ -3682,18 +4533,19 @@ Color* GenHeightmapSelection(const std::vector<std::vector<Model>>& models, cons
 
 Color* GenHeightmap(const Model& model, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode, float slopeTolerance)
 {
-    // this version of GenHeightMap is used only for texturing the models in the editor, not exporting. it matches pixels 1:1 with polys rather than vertices
-    
     Color* pixels = (Color*)RL_MALLOC((modelVertexWidth - 1)*(modelVertexHeight - 1)*sizeof(Color)); 
     
-    for (int i = 0; i < (model.meshes[0].vertexCount * 3) - 2; i += 3) // find if there is a new highestY and/or lowestY
-    {
-        if (model.meshes[0].vertices[i+1] > highestY)
-            highestY = model.meshes[0].vertices[i+1];
-            
-        if (model.meshes[0].vertices[i+1] < lowestY)
-            lowestY = model.meshes[0].vertices[i+1];
-    }
+    GenHeightmap(model, modelVertexWidth, modelVertexHeight, highestY, lowestY, mode, pixels, slopeTolerance);
+    
+    return pixels;
+}
+
+
+void GenHeightmap(const Model& model, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode, Color* pixels, float slopeTolerance)
+{
+    // this version of GenHeightMap is used only for texturing the models in the editor, not exporting. it matches pixels 1:1 with polys rather than vertices
+    
+    WidenHeightRange(model, highestY, lowestY);
     
     float scale = highestY - lowestY;
     
@@ -3784,103 +4636,6 @@ Color* GenHeightmap(const Model& model, int modelVertexWidth, int modelVertexHei
             break;
         }
     }
-    
-    return pixels;
-}
-
-
-Color* GenHeightmap(const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, float maxHeight, float minHeight, bool grayscale)
-{
-    // this version of GenHeightMap is for exporting the heightmap only. it matches pixels 1:1 with vertices rather than polys
-    //(assumes modelVertexWidth and modelVertexHeight are actually the same)
-    int modelsSizeX = (int)models.size(); // number of model columns
-    int modelsSizeY = (int)models[0].size(); // number of model rows
-    int numOfModels = modelsSizeX * modelsSizeY; // find the number of models being used
-    int numOfPixels = (modelVertexWidth * modelsSizeX - (modelsSizeX - 1)) * (modelVertexHeight * modelsSizeY - (modelsSizeY - 1)); // number of pixels in the image. - (modelsSize - 1) so that overlapping pixels are only counted once
-    
-    Color* pixels = (Color*)RL_MALLOC(numOfPixels*sizeof(Color));
-    
-    if (minHeight > 0) // min height never above 0
-        minHeight = 0;
-    
-    float scale = maxHeight - minHeight;    
-    
-    for (int i = 0; i < modelsSizeX; i++) // go through each model and enter its data into pixels. 
-    {
-        for (int j = 0; j < modelsSizeY; j++)
-        {
-            int increment = 0; // number of pixels needed to skip to get to the start of the next row of pixels these vertices coorespond to
-            
-            for (int k = 0; k < modelVertexWidth*modelVertexHeight; k++) // go through this model's vertices (one per intersection, not every overlapping one)
-            {
-                if (k > 0 && k%modelVertexWidth == 0) // every time it moves to a new row of vertices, it needs to make a jump where it's writing to in the pixel array
-                    increment += modelVertexWidth * modelsSizeX - (modelsSizeX - 1) - modelVertexWidth; 
-                
-                int x = k - ((k / modelVertexWidth) * modelVertexWidth); // find the x and y of this vertex in the mesh
-                int y = k / modelVertexWidth;
-                
-                int rowPixelCount = (modelVertexWidth * modelsSizeX - (modelsSizeX - 1)) * (modelVertexHeight - 1); // number of pixels to adjust pixelIndex by for each row 
-                
-                int vertexIndex = GetVertexIndices(x, y, modelVertexWidth)[0]; // use x and y to get the actual index in the vertex array (only need one from the returned list)
-                int pixelIndex = j * rowPixelCount + (i * modelVertexWidth - i) + increment + k; // index in the pixel array that corresponds to this vertex
-                
-                if (grayscale)
-                {
-                    unsigned char pixelValue = (abs((maxHeight - models[i][j].meshes[0].vertices[vertexIndex+1]) - scale) / scale) * 255;
-                    
-                    pixels[pixelIndex].r = pixelValue;
-                    pixels[pixelIndex].g = pixelValue;
-                    pixels[pixelIndex].b = pixelValue;
-                    pixels[pixelIndex].a = 255;
-                }
-                else
-                {
-                    // use all channels of the png to save height data at much greater resolution
-                    unsigned int pixelValue = (abs((maxHeight - models[i][j].meshes[0].vertices[vertexIndex+1]) - scale) / scale) * 2147483647;
-                    
-                    std::bitset<32> pixelBits(pixelValue); // pixelValue in binary
-                    std::bitset<8> redBits; // red channel in binary
-                    std::bitset<8> greenBits; // green channel in binary
-                    std::bitset<8> blueBits; // blue channel in binary
-                    std::bitset<8> alphaBits; // alpha channel in binary
-                    
-                    int pixelBitsIndex = 0; // which bit in pixelBits needs to be copied next
-                    
-                    for (int i = 0; i < 8; i++) // copy the first 8 bits (right to left) of pixelBits into the red channel
-                    {
-                        redBits[i] = pixelBits[pixelBitsIndex];
-                        pixelBitsIndex++;  
-                    }
-                    
-                    for (int i = 0; i < 8; i++) // copy the second set of 8 bits into the green channel, and so on
-                    {
-                        greenBits[i] = pixelBits[pixelBitsIndex];
-                        pixelBitsIndex++;  
-                    }
-                    
-                    for (int i = 0; i < 8; i++)
-                    {
-                        blueBits[i] = pixelBits[pixelBitsIndex];
-                        pixelBitsIndex++;  
-                    }
-                    
-                    for (int i = 0; i < 8; i++)
-                    {
-                        alphaBits[i] = pixelBits[pixelBitsIndex];
-                        pixelBitsIndex++;  
-                    }
-                    
-                    // convert from binary to unsigned char and assign the channels their values
-                    pixels[pixelIndex].r = (unsigned char)redBits.to_ulong();
-                    pixels[pixelIndex].g = (unsigned char)greenBits.to_ulong();
-                    pixels[pixelIndex].b = (unsigned char)blueBits.to_ulong();
-                    pixels[pixelIndex].a = (unsigned char)alphaBits.to_ulong();
-                }
-            }
-        }
-    }
-    
-    return pixels;
 }
 
 
@@ -3934,1031 +4689,6978 @@ RayHitInfo GetCollisionRayModel2(Ray ray, const Model *model)
 }
 
 
-void UpdateHeightmap(const Model& model, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode heightMapMode)
-{
-    Color* pixels = GenHeightmap(model, modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);
-        
-    UpdateTexture(model.materials[0].maps[MAP_DIFFUSE].texture, pixels);
-    
-    RL_FREE(pixels);    
-}
-
-
-void UpdateHeightmap(const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode heightMapMode)
+void WidenHeightRange(const Model& model, float& highestY, float& lowestY)
 {
-    for (int i = 0; i < models.size(); i++)
+    for (int i = 0; i < (model.meshes[0].vertexCount * 3) - 2; i += 3) // find if there is a new highestY and/or lowestY
     {
-        for (int j = 0; j < models[i].size(); j++)
-        {
-            Color* pixels = GenHeightmap(models[i][j], modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);
-                
-            UpdateTexture(models[i][j].materials[0].maps[MAP_DIFFUSE].texture, pixels);
+        if (model.meshes[0].vertices[i+1] > highestY)
+            highestY = model.meshes[0].vertices[i+1];
             
-            RL_FREE(pixels);            
-        }
+        if (model.meshes[0].vertices[i+1] < lowestY)
+            lowestY = model.meshes[0].vertices[i+1];
     }
 }
 
 
-std::vector<int> GetVertexIndices(int x, int y, int width) 
+void InitHeightmapShader(bool enabled, bool displaced)
 {
-    std::vector<int> result;
-    
-    if (x == 0)
-    {
-        if (y == 0)
-        {
-            result.push_back(0);
-        }
-        else if (y == width - 1)
+    // the palettes are GenHeightmap's, worked out per fragment from the interpolated height rather than per quad
+    const char* vertexCode = R"(
+        #version 330
+        
+        in vec3 vertexPosition;
+        in vec3 vertexNormal;
+        
+        uniform mat4 mvp;
+        
+        out float height;
+        out vec3 normal;
+        
+        void main()
         {
-            result.push_back((y - 1) * ((width - 1) * 18) + 3);
-            result.push_back((y - 1) * ((width - 1) * 18) + 12);
+            height = vertexPosition.y;
+            normal = vertexNormal;
+            gl_Position = mvp * vec4(vertexPosition, 1.0);
         }
-        else
+    )";
+    
+    const char* fragmentCode = R"(
+        #version 330
+        
+        in float height;
+        in vec3 normal;
+        
+        uniform float highestY;
+        uniform float lowestY;
+        uniform float slopeTolerance;
+        uniform int mode; // HeightMapMode
+        
+        out vec4 finalColor;
+        
+        void main()
         {
-            result.push_back(((y - 1) * ((width - 1) * 18)) + 3);
-            result.push_back(((y - 1) * ((width - 1) * 18)) + 12);
-            result.push_back(y * ((width - 1) * 18));   
+            float scale = highestY - lowestY;
+            float t = scale > 0.0 ? clamp((height - lowestY) / scale, 0.0, 1.0) : 0.0; // 0 at the lowest point, 1 at the highest
+            vec3 color;
+            
+            if (mode == 0) // grayscale
+            {
+                color = vec3(t);
+            }
+            else if (mode == 1) // slope. brown where it is steeper than slopeTolerance, green where it isnt
+            {
+                float angle = degrees(asin(normal.y / length(normal)));
+                
+                if (90.0 - angle >= slopeTolerance)
+                    color = vec3(110.0 + t * 145.0, 66.0 + t * 147.0, t * 150.0) / 255.0;
+                else
+                    color = vec3(t * 150.0, 110.0 + t * 145.0, t * 150.0) / 255.0;
+            }
+            else // rainbow, 1170 steps from purple up to red
+            {
+                float rgb = t * 1170.0;
+                
+                float r = rgb <= 150.0 ? 150.0 - rgb : rgb > 915.0 ? 255.0 : rgb > 660.0 ? rgb - 660.0 : 0.0;
+                float g = rgb > 915.0 ? 255.0 - (rgb - 915.0) : rgb > 405.0 ? 255.0 : rgb > 150.0 ? rgb - 150.0 : 0.0;
+                float b = rgb <= 405.0 ? 255.0 : rgb <= 660.0 ? 255.0 - (rgb - 405.0) : 0.0;
+                
+                color = vec3(r, g, b) / 255.0;
+            }
+            
+            finalColor = vec4(color, 1.0);
         }
-    }
-    else if (x == width - 1)
-    {
-        if (y == 0)
+    )";
+    
+    // the grid is a triangle soup like the tiles, 6 vertices a quad, so each vertex finds its quad and its triangle's corners from its index and reads their heights. the normal comes out flat per triangle, the same as the tiles'
+    const char* displacedVertexCode = R"(
+        #version 330
+        
+        in vec3 vertexPosition;
+        
+        uniform mat4 mvp;
+        uniform sampler2D heights; // the tile's, one texel per grid point
+        uniform vec2 spacing;
+        
+        out float height;
+        out vec3 normal;
+        
+        vec3 gridPoint(ivec2 point)
         {
-            result.push_back(((width - 1) * 18) - 9);
-            result.push_back(((width - 1) * 18) - 12);
+            return vec3(float(point.x) * spacing.x, texelFetch(heights, point, 0).r, float(point.y) * spacing.y);
         }
-        else if (y == width - 1)
+        
+        void main()
         {
-            result.push_back((y * (width - 1) * 18) - 3);          
+            ivec2 size = textureSize(heights, 0);
+            int quad = gl_VertexID / 6;
+            int corner = gl_VertexID % 6;
+            ivec2 origin = ivec2(quad % (size.x - 1), quad / (size.x - 1));
+            
+            // in the order GenMeshHeightGrid writes them
+            vec3 a = gridPoint(corner < 3 ? origin : origin + ivec2(1, 0));
+            vec3 b = gridPoint(origin + ivec2(0, 1));
+            vec3 c = gridPoint(corner < 3 ? origin + ivec2(1, 0) : origin + ivec2(1, 1));
+            
+            vec3 position = corner % 3 == 0 ? a : corner % 3 == 1 ? b : c;
+            
+            height = position.y;
+            normal = normalize(cross(b - a, c - a));
+            gl_Position = mvp * vec4(vertexPosition.x, position.y, vertexPosition.z, 1.0);
         }
-        else
-        {
-            result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) - 3);
-            result.push_back((x * 18) + ((y * ((width - 1) * 18)) - 9)); 
-            result.push_back((x * 18) + ((y * ((width - 1) * 18)) - 12));
-        }        
-    }
-    else if (y == 0)
-    {
-        result.push_back(x * 18 - 9);
-        result.push_back(x * 18 - 12); 
-        result.push_back(x * 18);
-    }
-    else if (y == width - 1)
-    {
-        result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) - 3);
-        result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) + 3);
-        result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) + 12);     
-    }
+    )";
+    
+    if (LoadHeightmapShader(heightmapShader, vertexCode, fragmentCode))
+        heightmapShader.enabled = enabled;
     else
+        TraceLog(LOG_WARNING, "SHADER: heightmap shader didnt compile, using the heightmap textures");
+    
+    if (!displaced)
+        return;
+    
+    if (!LoadHeightmapShader(displacementGrid.palette, displacedVertexCode, fragmentCode))
     {
-        result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) - 3);
-        result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) + 3);
-        result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) + 12);
-        result.push_back((x * 18) + ((y * (width - 1) * 18)) - 12);
-        result.push_back((x * 18) + ((y * (width - 1) * 18)) - 9);
-        result.push_back((x * 18) + (y * (width - 1) * 18));
+        TraceLog(LOG_WARNING, "SHADER: displacement shader didnt compile, drawing the tiles' own meshes");
+        return;
     }
     
-    return result;
+    displacementGrid.palette.shader.locs[LOC_MAP_HEIGHT] = GetShaderLocation(displacementGrid.palette.shader, "heights"); // DrawMesh binds the material's MAP_HEIGHT texture to it
+    displacementGrid.spacingLoc = GetShaderLocation(displacementGrid.palette.shader, "spacing");
+    displacementGrid.palette.enabled = true;
+    displacementGrid.enabled = true;
+    
+    heightmapShader.enabled = true; // the heightmap textures arent drawn, so they are left alone the same as with the heightmap shader
 }
 
 
-Vector2 GetVertexCoords(int index, int width) 
+bool LoadHeightmapShader(HeightmapShader& palette, const char* vertexCode, const char* fragmentCode)
 {
-    // meshes are patterns of pairs of tris. divide into and count by low resolution squares, then use piecemeal rules for final precision if there is a remainder
-    Vector2 result;
+    palette.shader = LoadShaderCode(vertexCode, fragmentCode);
+    palette.material = LoadMaterialDefault();
     
-    int squares = (index + 1) / 18;
-    int remainder = (index + 1) - (squares * 18);
-    
-    result.y = squares / (width - 1);
-    result.x = squares - (result.y * (width - 1));
-    
-    if (result.x == 0 && remainder == 0)  // any time x = 0 without remainder, it needs to be corrected
-        result.x = width - 1;
-    
-    if (result.y == width - 1) // the only time result.y will be at the max is if the coord is the bottom right, so return result
-        return result;
+    if (palette.shader.id == GetShaderDefault().id) // raylib falls back to its default shader if this one didnt compile
+        return false;
     
-    // all checks below see if it's necessary to add one to x and/or y because of vertex position in the square (set of two tris)
-    if ((remainder > 3 && remainder < 7) || (remainder > 12 && remainder < 16))
-    {
-        result.y++;
-    }
-    else if (remainder > 6 && remainder < 13)
-    {
-        result.x++;
-    }
-    else if (remainder > 15 && remainder < 19)
-    {
-        result.y++;
-        result.x++;
-    }
+    palette.material.shader = palette.shader;
+    palette.highestYLoc = GetShaderLocation(palette.shader, "highestY");
+    palette.lowestYLoc = GetShaderLocation(palette.shader, "lowestY");
+    palette.slopeToleranceLoc = GetShaderLocation(palette.shader, "slopeTolerance");
+    palette.modeLoc = GetShaderLocation(palette.shader, "mode");
     
-    return result;
+    return true;
 }
 
 
-std::vector<Vector2> GetModelCoordsSelection(const std::vector<VertexState>& vsList)
+void SetHeightmapUniforms(const HeightmapShader& palette, float highestY, float lowestY, HeightMapMode mode)
 {
-    std::vector<Vector2> coords;
-    
-    coords.push_back(Vector2{vsList[0].coords.x, vsList[0].coords.y}); // get the first element's info
+    float slopeTolerance = SLOPE_TOLERANCE;
+    int modeValue = (int)mode;
     
-    if (vsList.size() > 1) // if list is only one, we're done
+    SetShaderValue(palette.shader, palette.highestYLoc, &highestY, UNIFORM_FLOAT);
+    SetShaderValue(palette.shader, palette.lowestYLoc, &lowestY, UNIFORM_FLOAT);
+    SetShaderValue(palette.shader, palette.slopeToleranceLoc, &slopeTolerance, UNIFORM_FLOAT);
+    SetShaderValue(palette.shader, palette.modeLoc, &modeValue, UNIFORM_INT);
+}
+
+
+void TextureTile(Model& model, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode)
+{
+    if (displacementGrid.enabled) // the palette shader colors it, a texture would never be drawn
     {
-        for (int i = 1; i < vsList.size(); i++) // add info from vsList if it's not already in coords
-        {
-            if (coords[coords.size() - 1].x != vsList[i].coords.x || coords[coords.size() - 1].y != vsList[i].coords.y) // check the last entry in coords before searching further (last entry will often match)
-            {
-                bool add = true;
-                
-                for (int j = 0; j < coords.size(); j++) // check coords if theres already a copy of this info anywhere in the list
-                {
-                    if (coords[j].x == vsList[i].coords.x && coords[j].y == vsList[i].coords.y) // dont add duplicates
-                    {
-                        add = false;
-                        break;
-                    }
-                }
-                
-                if (add)
-                    coords.push_back(Vector2{vsList[i].coords.x, vsList[i].coords.y});
-            }
-        }
+        WidenHeightRange(model, highestY, lowestY);
+        DisplaceTile(model, modelVertexWidth, modelVertexHeight);
+        return;
     }
-    else
-        return coords;
     
-    return coords;
+    Color* pixels = GenHeightmap(model, modelVertexWidth, modelVertexHeight, highestY, lowestY, mode);
+    Image image = LoadImageEx(pixels, modelVertexWidth - 1, modelVertexHeight - 1);
+    model.materials[0].maps[MAP_DIFFUSE].texture = LoadTextureFromImage(image); // height and width -1 so that pixels and polys are 1:1
+    RL_FREE(pixels);
+    UnloadImage(image);
 }
 
 
-void ModelStitch(std::vector<std::vector<Model>>& models, const ModelSelection &modelSelection, int modelVertexWidth, int modelVertexHeight)
+void DisplaceTile(Model& model, int modelVertexWidth, int modelVertexHeight)
 {
-    int canvasWidth = models.size();
-    int canvasHeight = models[0].size();
+    if (!displacementGrid.enabled)
+        return;
     
-    if (modelSelection.topLeft.x > 0 && modelSelection.topLeft.y > 0) // stitch top left vertex if there is a diagonally adjacent model
-    {
-        int vertexIndex1 = 0; // vertex to be merged to 
-        std::vector<int> vertexIndices = GetVertexIndices(modelVertexWidth - 1, modelVertexHeight - 1, modelVertexWidth); // vertices that need to be adjusted
-        
-        for (int i = 0; i < vertexIndices.size(); i++)
-            models[modelSelection.topLeft.x - 1][modelSelection.topLeft.y - 1].meshes[0].vertices[vertexIndices[i] + 1] = models[modelSelection.topLeft.x][modelSelection.topLeft.y].meshes[0].vertices[vertexIndex1 + 1];
-    }
+    Mesh& mesh = model.meshes[0];
     
-    if (modelSelection.bottomRight.x < canvasWidth - 1 && modelSelection.topLeft.y > 0) // stitch top right vertex if there is a diagonally adjacent model
+    if (mesh.vaoId) // it was uploaded anyway
     {
-        int vertexIndex1 = GetVertexIndices(modelVertexWidth - 1, 0, modelVertexWidth)[0]; // vertex to be merged to
-        std::vector<int> vertexIndices = GetVertexIndices(0, modelVertexHeight - 1, modelVertexWidth); // vertices that need to be adjusted
+        for (int i = 0; i < 7; i++)
+        {
+            if (mesh.vboId[i])
+                rlDeleteBuffers(mesh.vboId[i]);
+            
+            mesh.vboId[i] = 0;
+        }
         
-        for (int i = 0; i < vertexIndices.size(); i++)
-            models[modelSelection.bottomRight.x + 1][modelSelection.topLeft.y - 1].meshes[0].vertices[vertexIndices[i] + 1] = models[modelSelection.bottomRight.x][modelSelection.topLeft.y].meshes[0].vertices[vertexIndex1 + 1];            
+        rlDeleteVertexArrays(mesh.vaoId);
+        mesh.vaoId = 0;
     }
     
-    if (modelSelection.bottomRight.y < canvasHeight - 1 && modelSelection.bottomRight.x < canvasWidth - 1) // stitch bottom right vertex if there is a diagonally adjacent model
+    if (displacementGrid.gridWidth != modelVertexWidth || displacementGrid.gridHeight != modelVertexHeight) // a new canvas resolution. the grid is the tiles' mesh flattened and at the origin
     {
-        int vertexIndex1 = GetVertexIndices(modelVertexWidth - 1, modelVertexHeight - 1, modelVertexWidth)[0]; // vertex to be merged to
-        int vertexIndex2 = 0; // vertex that needs to be adjusted
+        if (displacementGrid.grid.vertices)
+            UnloadMesh(displacementGrid.grid);
+        
+        std::vector<float> flat(modelVertexWidth * modelVertexHeight, 0.0f);
         
-        models[modelSelection.bottomRight.x + 1][modelSelection.bottomRight.y + 1].meshes[0].vertices[vertexIndex2 + 1] = models[modelSelection.bottomRight.x][modelSelection.bottomRight.y].meshes[0].vertices[vertexIndex1 + 1];
+        displacementGrid.grid = GenMeshHeightGrid(flat.data(), modelVertexWidth, modelVertexHeight, 0, 0, modelVertexWidth, modelVertexHeight, (Vector3){ MODEL_WORLD_SIZE, 1, MODEL_WORLD_SIZE }, Vector2{0, 0});
+        displacementGrid.gridWidth = modelVertexWidth;
+        displacementGrid.gridHeight = modelVertexHeight;
+        displacementGrid.spacing = Vector2{MODEL_WORLD_SIZE / (float)modelVertexWidth, MODEL_WORLD_SIZE / (float)modelVertexHeight}; // GenMeshHeightGrid's scale factor
     }
     
-    if (modelSelection.topLeft.x > 0 && modelSelection.bottomRight.y < canvasHeight - 1) // stitch bottom left vertex if there is a diagonally adjacent model
-    {
-        int vertexIndex1 = GetVertexIndices(0, modelVertexHeight - 1, modelVertexWidth)[0]; // vertex that needs to be merged to
-        std::vector<int> vertexIndices = GetVertexIndices(modelVertexWidth, 0, modelVertexWidth); // vertices that need to be adjusted
-        
-        for (int i = 0; i < vertexIndices.size(); i++)
-            models[modelSelection.topLeft.x - 1][modelSelection.bottomRight.y + 1].meshes[0].vertices[vertexIndices[i] + 1] = models[modelSelection.topLeft.x][modelSelection.bottomRight.y].meshes[0].vertices[vertexIndex1 + 1];            
-    } 
+    Texture2D texture = { rlLoadTexture(NULL, modelVertexWidth, modelVertexHeight, UNCOMPRESSED_R32, 1), modelVertexWidth, modelVertexHeight, 1, UNCOMPRESSED_R32 }; // filled from staging memory below
+    float* heights = (float*)AcquireStaging(modelVertexWidth * modelVertexHeight * sizeof(float)).memory;
     
-    if (modelSelection.topLeft.y > 0)
+    GetTileHeights(mesh, modelVertexWidth, modelVertexHeight, heights);
+    UploadTexture(texture, heights);
+    
+    model.materials[0].maps[MAP_HEIGHT].texture = texture; // unloaded with the model's material
+}
+
+
+void GetTileHeights(const Mesh& mesh, int modelVertexWidth, int modelVertexHeight, float* heights)
+{
+    for (int z = 0; z < modelVertexHeight - 1; z++)
     {
-        for (int i = 0; i < modelSelection.width; i++) // stitch all overlapping vertices on the top edge
+        for (int x = 0; x < modelVertexWidth - 1; x++)
         {
-            for (int j = 0; j < modelVertexWidth; j++)
-            {     
-                int vertexIndex1 = GetVertexIndices(j, 0, modelVertexWidth)[0]; // vertex that needs to be merged to
-                std::vector<int> vertexIndices = GetVertexIndices(j, modelVertexHeight - 1, modelVertexWidth); // vertices that need to be adjusted
-                
-                for (int ii = 0; ii < vertexIndices.size(); ii++)
-                    models[modelSelection.topLeft.x + i][modelSelection.topLeft.y - 1].meshes[0].vertices[vertexIndices[ii] + 1] = models[modelSelection.topLeft.x + i][modelSelection.topLeft.y].meshes[0].vertices[vertexIndex1 + 1];        
-            }
+            const float* quad = mesh.vertices + (z * (modelVertexWidth - 1) + x) * 18; // the y of its four corners are at 1, 4, 7 and 16
+            
+            heights[z * modelVertexWidth + x] = quad[1];
+            heights[(z + 1) * modelVertexWidth + x] = quad[4];
+            heights[z * modelVertexWidth + x + 1] = quad[7];
+            heights[(z + 1) * modelVertexWidth + x + 1] = quad[16];
         }
     }
+}
+
+
+void SetHeightmapShader(bool enabled, std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode)
+{
+    if (displacementGrid.enabled) // displaced tiles have no texture coloring to go back to
+        return;
     
-    if (modelSelection.bottomRight.x < canvasWidth - 1) 
-    {
-        for (int i = 0; i < modelSelection.height; i++) // stitch all overlapping vertices on the right edge
-        {
-            for (int j = 0; j < modelVertexHeight; j++)
-            {     
-                int vertexIndex1 = GetVertexIndices(modelVertexWidth - 1, j, modelVertexWidth)[0]; // vertex that needs to be merged to
-                std::vector<int> vertexIndices = GetVertexIndices(0, j, modelVertexWidth); // vertices that need to be adjusted
-                
-                for (int ii = 0; ii < vertexIndices.size(); ii++)
-                    models[modelSelection.bottomRight.x + 1][modelSelection.topLeft.y + i].meshes[0].vertices[vertexIndices[ii] + 1] = models[modelSelection.bottomRight.x][modelSelection.topLeft.y + i].meshes[0].vertices[vertexIndex1 + 1];   
-            }
-        }        
-    }
+    if (heightmapShader.material.shader.id != heightmapShader.shader.id || heightmapShader.shader.id == GetShaderDefault().id) // it didnt compile
+        return;
+    
+    heightmapShader.enabled = enabled;
     
-    if (modelSelection.bottomRight.y < canvasHeight - 1)
+    if (!enabled) // the textures havent been kept up while the shader was on
+        UpdateHeightmap(models, modelVertexWidth, modelVertexHeight, highestY, lowestY, mode);
+}
+
+
+void DrawCanvas(const std::vector<std::vector<Model>>& models, float highestY, float lowestY, HeightMapMode mode)
+{
+    if (displacementGrid.enabled)
     {
-        for (int i = 0; i < modelSelection.width; i++) // stitch all overlapping vertices on the bottom edge
+        Material& material = displacementGrid.palette.material;
+        
+        SetHeightmapUniforms(displacementGrid.palette, highestY, lowestY, mode);
+        SetShaderValue(displacementGrid.palette.shader, displacementGrid.spacingLoc, &displacementGrid.spacing, UNIFORM_VEC2);
+        
+        for (int i = 0; i < models.size(); i++)
         {
-            for (int j = 0; j < modelVertexWidth; j++)
-            {     
-                int vertexIndex1 = GetVertexIndices(j, modelVertexHeight - 1, modelVertexWidth)[0]; // vertex that needs to be merged to
-                std::vector<int> vertexIndices = GetVertexIndices(j, 0, modelVertexWidth); // vertices that need to be adjusted
+            for (int j = 0; j < models[i].size(); j++)
+            {
+                if (!ModelLoaded(models[i][j]))
+                    continue;
+                
+                const float* origin = models[i][j].meshes[0].vertices; // the tile's first vertex is its corner
                 
-                for (int ii = 0; ii < vertexIndices.size(); ii++)
-                    models[modelSelection.topLeft.x + i][modelSelection.bottomRight.y + 1].meshes[0].vertices[vertexIndices[ii] + 1] = models[modelSelection.topLeft.x + i][modelSelection.bottomRight.y].meshes[0].vertices[vertexIndex1 + 1]; 
+                material.maps[MAP_HEIGHT].texture = models[i][j].materials[0].maps[MAP_HEIGHT].texture;
+                DrawMesh(displacementGrid.grid, material, MatrixTranslate(origin[0], 0, origin[2]));
             }
-        }         
+        }
+        
+        material.maps[MAP_HEIGHT].texture = (Texture2D){ 0 }; // so unloading the material doesnt take a tile's texture with it
+        
+        return;
     }
     
-    if (modelSelection.topLeft.x > 0)
+    if (heightmapShader.enabled)
+        SetHeightmapUniforms(heightmapShader, highestY, lowestY, mode);
+    
+    for (int i = 0; i < models.size(); i++)
     {
-        for (int i = 0; i < modelSelection.height; i++) // stitch all overlapping vertices on the left edge
+        for (int j = 0; j < models[i].size(); j++)
         {
-            for (int j = 0; j < modelVertexHeight; j++)
-            {     
-                int vertexIndex1 = GetVertexIndices(0, j, modelVertexWidth)[0]; // vertex that needs to be merged to 
-                std::vector<int> vertexIndices = GetVertexIndices(modelVertexWidth - 1, j, modelVertexWidth); // vertices that need to be adjusted
-                
-                for (int ii = 0; ii < vertexIndices.size(); ii++)
-                    models[modelSelection.topLeft.x - 1][modelSelection.topLeft.y + i].meshes[0].vertices[vertexIndices[ii] + 1] = models[modelSelection.topLeft.x][modelSelection.topLeft.y + i].meshes[0].vertices[vertexIndex1 + 1];
-            }
-        }          
+            if (heightmapShader.enabled && ModelLoaded(models[i][j]))
+                DrawMesh(models[i][j].meshes[0], heightmapShader.material, models[i][j].transform);
+            else
+                DrawModel(models[i][j], Vector3{0, 0, 0}, 1.0f, WHITE);
+        }
     }
 }
 
 
-void SetExSelection(ModelSelection& modelSelection, int canvasWidth, int canvasHeight)
+void UpdateHeightmap(const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode heightMapMode)
 {
-    modelSelection.expandedSelection = modelSelection.selection; // fill expanded selection with regular selection
+    std::vector<const Model*> loaded;
     
-    if (modelSelection.topLeft.x > 0 && modelSelection.topLeft.y > 0) // add the diagonally adjacent top left model
+    for (int i = 0; i < models.size(); i++)
     {
-        modelSelection.expandedSelection.push_back(Vector2{modelSelection.topLeft.x - 1, modelSelection.topLeft.y - 1});
+        for (int j = 0; j < models[i].size(); j++)
+        {
+            if (ModelLoaded(models[i][j])) // the rest are textured when they are loaded again
+                loaded.push_back(&models[i][j]);
+        }
     }
     
-    if (modelSelection.topLeft.y > 0 && modelSelection.bottomRight.x < canvasWidth - 1) // add the diagonally adjacent top right model
+    if (heightmapShader.enabled)
     {
-        modelSelection.expandedSelection.push_back(Vector2{modelSelection.bottomRight.x + 1, modelSelection.topLeft.y - 1});
+        for (int i = 0; i < loaded.size(); i++)
+            WidenHeightRange(*loaded[i], highestY, lowestY);
+        
+        return;
     }
     
-    if (modelSelection.bottomRight.x < canvasWidth - 1 && modelSelection.bottomRight.y < canvasHeight - 1) // add the diagonally adjacent bottom right model
-    {
-        modelSelection.expandedSelection.push_back(Vector2{modelSelection.bottomRight.x + 1, modelSelection.bottomRight.y + 1});
-    }
+    std::vector<Texture2D> textures(loaded.size());
     
-    if (modelSelection.topLeft.x > 0 && modelSelection.bottomRight.y < canvasHeight - 1) // add the diagonally adjacent bottom left model
-    {
-        modelSelection.expandedSelection.push_back(Vector2{modelSelection.topLeft.x - 1, modelSelection.bottomRight.y + 1});
-    }
+    for (int i = 0; i < loaded.size(); i++)
+        textures[i] = loaded[i]->materials[0].maps[MAP_DIFFUSE].texture;
     
-    if (modelSelection.topLeft.y > 0) // fill top row
+    ColorTiles(loaded, textures, modelVertexWidth, modelVertexHeight, highestY, lowestY, heightMapMode);
+}
+
+
+void ScheduleTileJob(int x, int y, unsigned char work)
+{
+    if (!tileScheduler.enabled)
+        return;
+    
+    for (int i = 0; i < tileScheduler.jobs.size(); i++)
     {
-        for (int i = 0; i < modelSelection.width; i++)
+        if (tileScheduler.jobs[i].x == x && tileScheduler.jobs[i].y == y) // keeps its deadline, so a model edited every frame still catches up
         {
-            modelSelection.expandedSelection.push_back(Vector2{modelSelection.topLeft.x + i, modelSelection.topLeft.y - 1});
+            tileScheduler.jobs[i].work |= work;
+            return;
         }
     }
     
-    if (modelSelection.bottomRight.x < canvasWidth - 1) // fill right column
+    TileJob job = { x, y, work, tileScheduler.frame + TILE_JOB_MAX_DELAY };
+    tileScheduler.jobs.push_back(job);
+}
+
+
+void InitUploadRing(bool gl)
+{
+    uploadRing.buffers.resize(UPLOAD_RING_SIZE);
+    uploadRing.uploadBuffer = gl ? UploadBufferGl : UploadBufferStub;
+    uploadRing.uploadTexture = gl ? UploadTextureGl : UploadTextureStub;
+    uploadRing.pbo = gl && LoadStagingGl(uploadRing.gl);
+    
+    if (gl && !uploadRing.pbo)
+        TraceLog(LOG_WARNING, "UPLOADS: no pixel buffer objects, uploading straight from staging memory");
+    
+    if (uploadRing.pbo)
     {
-        for (int i = 0; i < modelSelection.height; i++)
-        {
-            modelSelection.expandedSelection.push_back(Vector2{modelSelection.bottomRight.x + 1, modelSelection.topLeft.y + i});
-        }
+        for (int i = 0; i < uploadRing.buffers.size(); i++)
+            uploadRing.gl.genBuffers(1, &uploadRing.buffers[i].pbo);
     }
+}
+
+
+bool LoadStagingGl(StagingGl& gl)
+{
+    gl.genBuffers = (void (GLAPIENTRY *)(int, unsigned int*))glfwGetProcAddress("glGenBuffers");
+    gl.bindBuffer = (void (GLAPIENTRY *)(unsigned int, unsigned int))glfwGetProcAddress("glBindBuffer");
+    gl.bufferData = (void (GLAPIENTRY *)(unsigned int, ptrdiff_t, const void*, unsigned int))glfwGetProcAddress("glBufferData");
+    gl.mapBufferRange = (void* (GLAPIENTRY *)(unsigned int, ptrdiff_t, ptrdiff_t, unsigned int))glfwGetProcAddress("glMapBufferRange");
+    gl.unmapBuffer = (unsigned char (GLAPIENTRY *)(unsigned int))glfwGetProcAddress("glUnmapBuffer");
+    gl.copyBufferSubData = (void (GLAPIENTRY *)(unsigned int, unsigned int, ptrdiff_t, ptrdiff_t, ptrdiff_t))glfwGetProcAddress("glCopyBufferSubData");
+    gl.bindTexture = (void (GLAPIENTRY *)(unsigned int, unsigned int))glfwGetProcAddress("glBindTexture");
+    gl.texSubImage2D = (void (GLAPIENTRY *)(unsigned int, int, int, int, int, int, unsigned int, unsigned int, const void*))glfwGetProcAddress("glTexSubImage2D");
+    gl.fenceSync = (void* (GLAPIENTRY *)(unsigned int, unsigned int))glfwGetProcAddress("glFenceSync");
+    gl.clientWaitSync = (unsigned int (GLAPIENTRY *)(void*, unsigned int, unsigned long long))glfwGetProcAddress("glClientWaitSync");
+    gl.deleteSync = (void (GLAPIENTRY *)(void*))glfwGetProcAddress("glDeleteSync");
+    
+    return gl.genBuffers && gl.bindBuffer && gl.bufferData && gl.mapBufferRange && gl.unmapBuffer && gl.copyBufferSubData && gl.bindTexture && gl.texSubImage2D && gl.fenceSync && gl.clientWaitSync && gl.deleteSync;
+}
+
+
+StagingBuffer& AcquireStaging(size_t size)
+{
+    int count = uploadRing.buffers.size();
+    StagingBuffer* buffer = NULL;
     
-    if (modelSelection.bottomRight.y < canvasHeight - 1) // fill bottom row
+    for (int k = 0; k < count && !buffer; k++)
     {
-        for (int i = 0; i < modelSelection.width; i++)
+        int index = (uploadRing.next + k) % count;
+        
+        if (!uploadRing.buffers[index].pending && StagingFencePassed(uploadRing.buffers[index], false))
         {
-            modelSelection.expandedSelection.push_back(Vector2{modelSelection.topLeft.x + i, modelSelection.bottomRight.y + 1});
+            buffer = &uploadRing.buffers[index];
+            uploadRing.next = (index + 1) % count;
         }
     }
     
-    if (modelSelection.topLeft.x > 0) // fill left column
+    for (int k = 0; k < count && !buffer; k++) // every free one is waiting on the gpu. the oldest is waited for
     {
-        for (int i = 0; i < modelSelection.height; i++)
+        int index = (uploadRing.next + k) % count;
+        
+        if (!uploadRing.buffers[index].pending) // one that hasnt been uploaded from yet still holds what was written to it
         {
-            modelSelection.expandedSelection.push_back(Vector2{modelSelection.topLeft.x - 1, modelSelection.topLeft.y + i});
+            buffer = &uploadRing.buffers[index];
+            uploadRing.next = (index + 1) % count;
+            uploadRing.stats.stalls++;
+            
+            StagingFencePassed(*buffer, true);
         }
     }
+    
+    if (!buffer) // every buffer is handed out. the ring grows rather than give one out twice
+    {
+        TraceLog(LOG_WARNING, "UPLOADS: every staging buffer is in use, growing the ring to %i", count + 1);
+        
+        uploadRing.buffers.emplace_back();
+        buffer = &uploadRing.buffers.back();
+        
+        if (uploadRing.pbo)
+            uploadRing.gl.genBuffers(1, &buffer->pbo);
+    }
+    
+    if (uploadRing.pbo)
+        MapStaging(*buffer, size);
+    else if (buffer->capacity < size)
+    {
+        RL_FREE(buffer->memory);
+        buffer->memory = (unsigned char*)RL_MALLOC(size);
+        buffer->capacity = size;
+    }
+    
+    buffer->pending = true;
+    
+    return *buffer;
 }
 
 
-void UpdateCharacterCamera(Camera* camera, const std::vector<std::vector<Model>>& models, ModelSelection& terrainCells)
+bool StagingFencePassed(StagingBuffer& staging, bool wait)
 {
-    static Vector2 previousMousePosition = { 0.0f, 0.0f };
+    if (!staging.fence)
+        return true;
     
-    // Mouse movement detection
-    Vector2 mousePositionDelta = { 0.0f, 0.0f };
-    Vector2 mousePosition = GetMousePosition();
+    unsigned int result = uploadRing.gl.clientWaitSync(staging.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, 0);
     
-    bool direction[6] = { IsKeyDown(cameraMoveControl[MOVE_FRONT]),
-                           IsKeyDown(cameraMoveControl[MOVE_BACK]),
-                           IsKeyDown(cameraMoveControl[MOVE_RIGHT]),
-                           IsKeyDown(cameraMoveControl[MOVE_LEFT]),
-                           IsKeyDown(cameraMoveControl[MOVE_UP]),
-                           IsKeyDown(cameraMoveControl[MOVE_DOWN]) };
-                           
-    mousePositionDelta.x = mousePosition.x - previousMousePosition.x;
-    mousePositionDelta.y = mousePosition.y - previousMousePosition.y;
-
-    previousMousePosition = mousePosition;
+    while (wait && result == GL_TIMEOUT_EXPIRED)
+        result = uploadRing.gl.clientWaitSync(staging.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // a millisecond at a time
     
-    float newCameraPositionX = camera->position.x;
-    float newCameraPositionZ = camera->position.z;
+    if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+        return false;
     
-    // Camera orientation calculation
-    cameraAngle.x += (mousePositionDelta.x*-CAMERA_MOUSE_MOVE_SENSITIVITY);
-    cameraAngle.y += (mousePositionDelta.y*-CAMERA_MOUSE_MOVE_SENSITIVITY);
+    uploadRing.gl.deleteSync(staging.fence);
+    staging.fence = NULL;
     
-    // Angle clamp
-    if (cameraAngle.y > CAMERA_FIRST_PERSON_MIN_CLAMP*DEG2RAD) cameraAngle.y = CAMERA_FIRST_PERSON_MIN_CLAMP*DEG2RAD;
-    else if (cameraAngle.y < CAMERA_FIRST_PERSON_MAX_CLAMP*DEG2RAD) cameraAngle.y = CAMERA_FIRST_PERSON_MAX_CLAMP*DEG2RAD;
+    return true;
+}
+
+
+void MapStaging(StagingBuffer& staging, size_t size)
+{
+    StagingGl& gl = uploadRing.gl;
     
-    newCameraPositionX += (sinf(cameraAngle.x)*direction[MOVE_BACK] -
-                           sinf(cameraAngle.x)*direction[MOVE_FRONT] -
-                           cosf(cameraAngle.x)*direction[MOVE_LEFT] +
-                           cosf(cameraAngle.x)*direction[MOVE_RIGHT])/PLAYER_MOVEMENT_SENSITIVITY;
-                           
-    newCameraPositionZ += (cosf(cameraAngle.x)*direction[MOVE_BACK] -
-                           cosf(cameraAngle.x)*direction[MOVE_FRONT] +
-                           sinf(cameraAngle.x)*direction[MOVE_LEFT] -
-                           sinf(cameraAngle.x)*direction[MOVE_RIGHT])/PLAYER_MOVEMENT_SENSITIVITY;
+    gl.bindBuffer(GL_PIXEL_UNPACK_BUFFER, staging.pbo);
     
-    // keep the camera at ground level by finding the distance to the ground
-    Ray ray = {Vector3{newCameraPositionX, camera->position.y + 10, newCameraPositionZ}, Vector3{0, -1, 0}};
-    RayHitInfo hitPosition;
+    if (staging.memory && staging.capacity < size) // still mapped from a frame it wasnt uploaded from, but too small
+    {
+        gl.unmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        staging.memory = NULL;
+    }
     
-    int modelx; // x coord of the model that intersects ray
-    int modely; // y coord of the model that intersects ray
-
-    if (!models.empty())
+    if (!staging.memory)
     {
-        for (int i = 0; i < terrainCells.selection.size(); i++)
+        if (staging.capacity < size)
         {
-            hitPosition = GetCollisionRayModel2(ray, &models[terrainCells.selection[i].x][terrainCells.selection[i].y]); 
-            
-            if (hitPosition.hit)
-            {
-                modelx = terrainCells.selection[i].x;
-                modely = terrainCells.selection[i].y;
-                break;
-            }
+            gl.bufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+            staging.capacity = size;
         }
+        
+        staging.memory = (unsigned char*)gl.mapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, staging.capacity, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT); // its fence has passed, so the driver has nothing to wait for
     }
     
-    if (hitPosition.hit && modelx != terrainCells.selection[0].x || modely != terrainCells.selection[0].y) // if player is found on a cell other than the center, readjust the terrain cells to the new center
+    gl.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); // left bound, rlgl's own texture uploads would read from it
+}
+
+
+StagingBuffer* FindStaging(const void* memory)
+{
+    for (int i = 0; i < uploadRing.buffers.size(); i++)
     {
-        terrainCells.selection.clear();
-        terrainCells.selection.push_back(Vector2{modelx, modely});
-        FillTerrainCells(terrainCells, models);
+        if (memory && uploadRing.buffers[i].memory == memory)
+            return &uploadRing.buffers[i];
     }
     
-    camera->target.x = camera->position.x - sinf(cameraAngle.x)*cosf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
-    camera->target.y = camera->position.y + sinf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
-    camera->target.z = camera->position.z - cosf(cameraAngle.x)*cosf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
-        
-    if (hitPosition.hit) // if a place to move to was found, update camera
-    {
-        camera->position.x = newCameraPositionX;
-        camera->position.y = hitPosition.position.y + playerEyesHeight;
-        camera->position.z = newCameraPositionZ;
-    }    
+    return NULL;
 }
 
 
-void UpdateFreeCamera(Camera* camera)
+void UploadBuffer(unsigned int bufferId, const void* data, int size)
 {
-    static Vector2 previousMousePosition = { 0.0f, 0.0f };
+    StagingBuffer& staging = AcquireStaging(size);
     
-    // Mouse movement detection
-    Vector2 mousePositionDelta = { 0.0f, 0.0f };
-    Vector2 mousePosition = GetMousePosition();
+    memcpy(staging.memory, data, size);
+    uploadRing.uploadBuffer(staging, bufferId, size);
+    staging.pending = false;
     
-    bool direction[6] = { IsKeyDown(cameraMoveControl[MOVE_FRONT]),
-                           IsKeyDown(cameraMoveControl[MOVE_BACK]),
-                           IsKeyDown(cameraMoveControl[MOVE_RIGHT]),
-                           IsKeyDown(cameraMoveControl[MOVE_LEFT]),
-                           IsKeyDown(cameraMoveControl[MOVE_UP]),
-                           IsKeyDown(cameraMoveControl[MOVE_DOWN]) };
-                           
-    mousePositionDelta.x = mousePosition.x - previousMousePosition.x;
-    mousePositionDelta.y = mousePosition.y - previousMousePosition.y;
+    uploadRing.stats.uploads++;
+    uploadRing.stats.bytes += size;
+}
 
-    previousMousePosition = mousePosition;
-    
-    if (IsMouseButtonDown(MOUSE_RIGHT_BUTTON))
+
+void UploadVertices(const Mesh& mesh)
+{
+    UploadBuffer(mesh.vboId[0], mesh.vertices, mesh.vertexCount*3*sizeof(float));    // Update vertex position 
+    UploadBuffer(mesh.vboId[2], mesh.normals, mesh.vertexCount*3*sizeof(float));    // Update vertex normals 
+}
+
+
+void UploadTile(const Model& model)
+{
+    if (!displacementGrid.enabled)
     {
-        // Camera orientation calculation
-        cameraAngle.x += (mousePositionDelta.x*-CAMERA_MOUSE_MOVE_SENSITIVITY);
-        cameraAngle.y += (mousePositionDelta.y*-CAMERA_MOUSE_MOVE_SENSITIVITY);
+        UploadVertices(model.meshes[0]);
+        return;
     }
     
-    // Angle clamp
-    if (cameraAngle.y > CAMERA_FIRST_PERSON_MIN_CLAMP*DEG2RAD) cameraAngle.y = CAMERA_FIRST_PERSON_MIN_CLAMP*DEG2RAD;
-    else if (cameraAngle.y < CAMERA_FIRST_PERSON_MAX_CLAMP*DEG2RAD) cameraAngle.y = CAMERA_FIRST_PERSON_MAX_CLAMP*DEG2RAD;
-    
-    // free fly camera
-    camera->position.x += (sinf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_BACK] -
-                           sinf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_FRONT] -
-                           cosf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_LEFT] +
-                           cosf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_RIGHT]);
-                           
-    camera->position.y += (sinf(cameraAngle.y)*direction[MOVE_FRONT] -
-                           sinf(cameraAngle.y)*direction[MOVE_BACK] +
-                           1.0f*direction[MOVE_UP] - 1.0f*direction[MOVE_DOWN]);
-                           
-    camera->position.z += (cosf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_BACK] -
-                           cosf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_FRONT] +
-                           sinf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_LEFT] -
-                           sinf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_RIGHT]);
+    Texture2D texture = model.materials[0].maps[MAP_HEIGHT].texture;
+    float* heights = (float*)AcquireStaging(texture.width * texture.height * sizeof(float)).memory;
     
-    camera->target.x = camera->position.x - sinf(cameraAngle.x)*cosf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
-    camera->target.y = camera->position.y + sinf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
-    camera->target.z = camera->position.z - cosf(cameraAngle.x)*cosf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
+    GetTileHeights(model.meshes[0], texture.width, texture.height, heights);
+    UploadTexture(texture, heights);
 }
 
 
-void UpdateOrthographicCamera(Camera* camera)
+void UploadTexture(Texture2D texture, const void* pixels)
 {
-    bool direction[6] = { IsKeyDown(cameraMoveControl[MOVE_FRONT]),
-                           IsKeyDown(cameraMoveControl[MOVE_BACK]),
-                           IsKeyDown(cameraMoveControl[MOVE_RIGHT]),
-                           IsKeyDown(cameraMoveControl[MOVE_LEFT]),
-                           IsKeyDown(cameraMoveControl[MOVE_UP]),
-                           IsKeyDown(cameraMoveControl[MOVE_DOWN]) };
+    StagingBuffer* staging = FindStaging(pixels);
     
-    // free fly camera
-    camera->position.x += direction[MOVE_RIGHT] - direction[MOVE_LEFT];
-                           
-    camera->position.y += direction[MOVE_UP] - direction[MOVE_DOWN];
-                           
-    camera->position.z += direction[MOVE_BACK] - direction[MOVE_FRONT];
+    uploadRing.uploadTexture(staging, texture, pixels);
     
-    camera->target.x = camera->position.x;
-    camera->target.y = camera->position.y - 0.1;
-    camera->target.z = camera->position.z;
+    if (staging)
+        staging->pending = false;
+    
+    uploadRing.stats.uploads++;
+    uploadRing.stats.bytes += texture.width * texture.height * sizeof(Color);
 }
 
 
-void FillTerrainCells(ModelSelection& modelSelection, const std::vector<std::vector<Model>>& models)
+UploadStats AdvanceUploadRing()
 {
-    // attempt to fill the rest of terrainCells with adjacent models from right, down, left, up, top right, bottom right, bottom left, top left
-    // filled in the order of the likelyhood of the player occupying it, so center first, sides second, corners last
+    UploadStats stats = uploadRing.stats;
     
-    if (modelSelection.selection.empty()) // needs to have the first element filled
-        return;
+    uploadRing.stats = UploadStats{};
     
-    int canvasWidth = models.size();
-    int canvasHeight = models[0].size();
+    for (int i = 0; i < uploadRing.buffers.size(); i++) // handed out and dropped. a pixel buffer object stays mapped for the next one
+        uploadRing.buffers[i].pending = false;
+    
+    return stats;
+}
 
-    Vector2 center = modelSelection.selection[0];
 
-    if (center.x < canvasWidth - 1)
-        modelSelection.selection.push_back(Vector2{center.x + 1, center.y});
-    
-    if (center.y < canvasHeight - 1)
-        modelSelection.selection.push_back(Vector2{center.x, center.y + 1});
-    
-    if (center.x > 0)
-        modelSelection.selection.push_back(Vector2{center.x - 1, center.y});
-    
-    if (center.y > 0)
-        modelSelection.selection.push_back(Vector2{center.x, center.y - 1});
+void UploadBufferGl(StagingBuffer& staging, unsigned int bufferId, int size)
+{
+    if (!uploadRing.pbo)
+    {
+        rlUpdateBuffer(bufferId, staging.memory, size);
+        return;
+    }
     
-    if (center.x < canvasWidth - 1 && center.y > 0)
-        modelSelection.selection.push_back(Vector2{center.x + 1, center.y - 1});
+    StagingGl& gl = uploadRing.gl;
     
-    if (center.x < canvasWidth - 1 && center.y < canvasHeight - 1)
-        modelSelection.selection.push_back(Vector2{center.x + 1, center.y + 1}); 
-
-    if (center.x > 0 && center.y < canvasHeight - 1)
-        modelSelection.selection.push_back(Vector2{center.x - 1, center.y + 1});    
+    gl.bindBuffer(GL_COPY_READ_BUFFER, staging.pbo);
+    gl.unmapBuffer(GL_COPY_READ_BUFFER);
+    gl.bindBuffer(GL_COPY_WRITE_BUFFER, bufferId);
+    gl.copyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size); // a gpu side copy, queued behind the draws still reading the buffer instead of waiting on them
+    gl.bindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    gl.bindBuffer(GL_COPY_READ_BUFFER, 0);
     
-    if (center.x > 0 && center.y > 0)
-        modelSelection.selection.push_back(Vector2{center.x - 1, center.y - 1});
+    staging.memory = NULL;
+    staging.fence = gl.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
 
 
-void PrintBoxInfo(Rectangle box, InputFocus currentFocus, InputFocus matchingFocus, const std::string& s, float info)
+void UploadTextureGl(StagingBuffer* staging, Texture2D texture, const void* pixels)
 {
-    if (currentFocus == matchingFocus || !s.empty())     
-    {
-        char c[s.size() + 1];
-        strcpy(c, s.c_str());                        
-        
-        DrawTextRec(GetFontDefault(), c, Rectangle {box.x + 2, box.y + 2, box.width - 2, box.height - 2}, 11, 1.f, false, BLACK);
-    }
-    else     
+    if (!staging || !uploadRing.pbo) // rlgl copies it before returning
     {
-        std::string temp = std::to_string(info);
-        char c[temp.size() + 1];
-        strcpy(c, temp.c_str());
-        
-        DrawTextRec(GetFontDefault(), c, Rectangle {box.x + 2, box.y + 2, box.width - 2, box.height - 2}, 11, 1.f, false, BLACK);
+        UpdateTexture(texture, pixels);
+        return;
     }
+    
+    StagingGl& gl = uploadRing.gl;
+    
+    gl.bindBuffer(GL_PIXEL_UNPACK_BUFFER, staging->pbo);
+    gl.unmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    gl.bindTexture(GL_TEXTURE_2D, texture.id);
+    gl.texSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture.width, texture.height, texture.format == UNCOMPRESSED_R32 ? GL_RED : GL_RGBA, texture.format == UNCOMPRESSED_R32 ? GL_FLOAT : GL_UNSIGNED_BYTE, (const void*)0); // from the bound buffer, returns before the gpu has read it
+    gl.bindTexture(GL_TEXTURE_2D, 0);
+    gl.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    
+    staging->memory = NULL;
+    staging->fence = gl.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
 
 
-void PrintBoxInfo(Rectangle box, InputFocus currentFocus, InputFocus matchingFocus, const std::string& s, int info)
+void UploadBufferStub(StagingBuffer& staging, unsigned int bufferId, int size)
 {
-    if (currentFocus == matchingFocus || !s.empty())     
-    {
-        char c[s.size() + 1];
-        strcpy(c, s.c_str());                        
-        
-        DrawTextRec(GetFontDefault(), c, Rectangle {box.x + 2, box.y + 2, box.width - 2, box.height - 2}, 11, 1.f, false, BLACK);
-    }
-    else     
-    {
-        std::string temp = std::to_string(info);
-        char c[temp.size() + 1];
-        strcpy(c, temp.c_str());
-        
-        DrawTextRec(GetFontDefault(), c, Rectangle {box.x + 2, box.y + 2, box.width - 2, box.height - 2}, 11, 1.f, false, BLACK);
-    }
 }
 
 
-void ProcessInput(int key, std::string& s, float& input, InputFocus& inputFocus, int maxSize)
+void UploadTextureStub(StagingBuffer* staging, Texture2D texture, const void* pixels)
 {
-    if (((key >= 48 && key <= 57) || key == 46) && ((int)s.size() < maxSize))
-    {
-        if (key == 48 && s.empty())
-        {}
-        else
-            s.push_back((char)key);
-    }
+}
 
-    if (IsKeyPressed(KEY_BACKSPACE) && !s.empty())
-        s.pop_back();
+
+void ColorTiles(const std::vector<const Model*>& tiles, const std::vector<Texture2D>& textures, int modelVertexWidth, int modelVertexHeight, float& highestY, float& lowestY, HeightMapMode mode)
+{
+    const int chunk = UPLOAD_RING_SIZE / 2;
+    std::vector<Color*> pixels(chunk);
+    std::vector<Vector2> ranges(chunk);
     
-    if (IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_KP_ENTER))
+    for (int first = 0; first < tiles.size(); first += chunk)
     {
-        if (s.empty())
-            inputFocus = InputFocus::NONE;
-        else
+        int count = std::min((int)tiles.size() - first, chunk);
+        
+        for (int i = 0; i < count; i++)
         {
-            input = stof(s);
-            inputFocus = InputFocus::NONE; 
+            pixels[i] = (Color*)AcquireStaging((modelVertexWidth - 1) * (modelVertexHeight - 1) * sizeof(Color)).memory;
+            ranges[i] = Vector2{lowestY, highestY}; // each tile widens its own copy of the range, merged below
+        }
+        
+        ParallelFor(count, [&](int i)
+        {
+            GenHeightmap(*tiles[first + i], modelVertexWidth, modelVertexHeight, ranges[i].y, ranges[i].x, mode, pixels[i]);
+        });
+        
+        for (int i = 0; i < count; i++) // uploads on the main thread
+        {
+            UploadTexture(textures[first + i], pixels[i]);
+            
+            lowestY = std::min(lowestY, ranges[i].x);
+            highestY = std::max(highestY, ranges[i].y);
         }
     }
 }
 
 
-std::vector<VertexState> FindVertexSelection(const std::vector<std::vector<Model>>& models, const ModelSelection& modelSelection, RayHitInfo hitPosition, float selectRadius)
+bool RunTileJobs(std::vector<std::vector<Model>>& models, Vector3 cameraPosition, int modelVertexWidth, int modelVertexHeight, int modelWidth, float& highestY, float& lowestY, HeightMapMode mode)
 {
-    std::vector<VertexState>vertexIndices; // vector to return
+    unsigned int frame = ++tileScheduler.frame;
+    std::vector<TileJob>& jobs = tileScheduler.jobs;
     
-    if (hitPosition.hit)
+    if (jobs.empty())
+        return false;
+    
+    float realModelWidth = modelWidth - (1 / (float)modelVertexWidth) * modelWidth; // modelWidth minus the width of one polygon
+    
+    auto distance = [&](const TileJob& job) { return xzDistance(Vector2{(job.x + 0.5f) * realModelWidth, (job.y + 0.5f) * realModelWidth}, Vector2{cameraPosition.x, cameraPosition.z}); };
+    
+    std::sort(jobs.begin(), jobs.end(), [&](const TileJob& a, const TileJob& b)
     {
-        Vector2 hitCoords = {hitPosition.position.x, hitPosition.position.z};
+        if ((a.deadline <= frame) != (b.deadline <= frame)) // due first
+            return a.deadline <= frame;
+        
+        if ((a.work & TILE_JOB_UPLOAD) != (b.work & TILE_JOB_UPLOAD)) // then the ones with geometry on the way
+            return (a.work & TILE_JOB_UPLOAD) != 0;
+        
+        return distance(a) < distance(b);
+    });
     
-        for (int i = 0; i < modelSelection.selection.size(); i++) // check models for vertices to be selected
+    auto start = std::chrono::steady_clock::now();
+    int waveSize = std::min((int)taskPool.threads.size() + 1, UPLOAD_RING_SIZE - 2); // a job per thread at a time. each can hold a staging buffer for its heightmap until the end of the wave, and the vertex uploads need two more
+    int done = 0;
+    
+    while (done < jobs.size())
+    {
+        std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - start;
+        int waveEnd = done;
+        
+        while (waveEnd < jobs.size() && waveEnd - done < waveSize && (elapsed.count() < TILE_JOB_BUDGET || jobs[waveEnd].deadline <= frame)) // out of time, and the rest can wait
+            waveEnd++;
+        
+        if (waveEnd == done)
+            break;
+        
+        std::vector<Model*> wave(waveEnd - done, NULL);
+        std::vector<Color*> pixels(waveEnd - done, NULL);
+        std::vector<Vector2> ranges(waveEnd - done, Vector2{lowestY, highestY}); // each heightmap widens its own copy of the range, merged below
+        TaskGroup normals;
+        TaskGroup heightmaps;
+        
+        for (int k = 0; k < wave.size(); k++) // the cpu work on the pool
         {
-            for (int j = 0; j < (models[modelSelection.selection[i].x][modelSelection.selection[i].y].meshes[0].vertexCount * 3) - 2; j += 3) // check this models vertices
+            const TileJob& job = jobs[done + k];
+            
+            if (job.x >= models.size() || job.y >= models[job.x].size() || !ModelLoaded(models[job.x][job.y])) // the canvas changed, or it was paged out and is brought up to date when it is loaded again
+                continue;
+            
+            Model* model = &models[job.x][job.y];
+            wave[k] = model;
+            
+            if (job.work & TILE_JOB_NORMALS)
+                SubmitTask(normals, [=]() { UpdateNormals(*model, modelVertexWidth, modelVertexHeight); });
+            
+            if ((job.work & TILE_JOB_HEIGHTMAP) && heightmapShader.enabled) // the shader colors it, only the range needs to take it in
+                SubmitTask(heightmaps, [&ranges, k, model]() { WidenHeightRange(*model, ranges[k].y, ranges[k].x); });
+            else if (job.work & TILE_JOB_HEIGHTMAP) // after the normals, the slope colors are worked out from them
             {
-                Vector2 vertexCoords = {models[modelSelection.selection[i].x][modelSelection.selection[i].y].meshes[0].vertices[j], models[modelSelection.selection[i].x][modelSelection.selection[i].y].meshes[0].vertices[j+2]};
-                
-                float result = xzDistance(hitCoords, vertexCoords);
-                
-                if (result <= selectRadius) // if this vertex is inside the radius
-                {
-                    VertexState vs;
-                    vs.coords.x = modelSelection.selection[i].x;
-                    vs.coords.y = modelSelection.selection[i].y;
-                    vs.index = j; 
-                    
-                    vertexIndices.push_back(vs); // store the vertex's index in the mesh and its models coords
-                }
-            }          
+                pixels[k] = (Color*)AcquireStaging((modelVertexWidth - 1) * (modelVertexHeight - 1) * sizeof(Color)).memory;
+                SubmitTask(heightmaps, [&pixels, &ranges, k, model, modelVertexWidth, modelVertexHeight, mode]() { GenHeightmap(*model, modelVertexWidth, modelVertexHeight, ranges[k].y, ranges[k].x, mode, pixels[k]); }, &normals);
+            }
         }
-    }
-    
-    return vertexIndices;
-}
-
+        
+        WaitTaskGroup(heightmaps);
+        WaitTaskGroup(normals);
+        
+        for (int k = 0; k < wave.size(); k++) // and the gl calls here
+        {
+            if (!wave[k])
+                continue;
+            
+            Model& model = *wave[k];
+            
+            if (pixels[k]) // first, so its staging buffer is free again for the vertices
+                UploadTexture(model.materials[0].maps[MAP_DIFFUSE].texture, pixels[k]);
+            
+            if ((jobs[done + k].work & TILE_JOB_UPLOAD) || ((jobs[done + k].work & TILE_JOB_NORMALS) && !displacementGrid.enabled)) // the heightmap shader reads the normals. displaced, it works them out itself
+                UploadTile(model);
+            
+            lowestY = std::min(lowestY, ranges[k].x);
+            highestY = std::max(highestY, ranges[k].y);
+        }
+        
+        done = waveEnd;
+    }
+    
+    jobs.erase(jobs.begin(), jobs.begin() + done);
+    
+    return true;
+}
+
+
+VertexIndexSpan GetVertexIndices(int x, int y, int width) 
+{
+    const VertexLattice& lattice = GetVertexLattice(width);
+    int point = y * width + x;
+    
+    return VertexIndexSpan{lattice.indices.data() + lattice.offsets[point], lattice.offsets[point + 1] - lattice.offsets[point]};
+}
+
+
+Vector2 GetVertexCoords(int index, int width) 
+{
+    return GetVertexLattice(width).coords[index / 3];
+}
+
+
+const VertexLattice& GetVertexLattice(int width)
+{
+    thread_local const VertexLattice* last = NULL; // nearly every lookup is for the same width as the one before, so skip the lock for it
+    
+    if (last && last->width == width)
+        return *last;
+    
+    static std::deque<VertexLattice> lattices; // a deque so the ones already handed out dont move when another is added
+    static std::mutex mutex;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    
+    for (int i = 0; i < lattices.size(); i++)
+    {
+        if (lattices[i].width == width)
+        {
+            last = &lattices[i];
+            return *last;
+        }
+    }
+    
+    lattices.emplace_back();
+    BuildVertexLattice(lattices.back(), width);
+    
+    last = &lattices.back();
+    return *last;
+}
+
+
+void BuildVertexLattice(VertexLattice& lattice, int width)
+{
+    lattice.width = width;
+    lattice.offsets.resize(width * width + 1);
+    lattice.indices.clear();
+    lattice.indices.reserve((width - 1) * (width - 1) * 6);
+    lattice.coords.resize((width - 1) * (width - 1) * 6);
+    
+    std::vector<int>& result = lattice.indices;
+    
+    for (int y = 0; y < width; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            int first = result.size();
+            lattice.offsets[y * width + x] = first;
+            
+            if (x == 0)
+            {
+                if (y == 0)
+                {
+                    result.push_back(0);
+                }
+                else if (y == width - 1)
+                {
+                    result.push_back((y - 1) * ((width - 1) * 18) + 3);
+                    result.push_back((y - 1) * ((width - 1) * 18) + 12);
+                }
+                else
+                {
+                    result.push_back(((y - 1) * ((width - 1) * 18)) + 3);
+                    result.push_back(((y - 1) * ((width - 1) * 18)) + 12);
+                    result.push_back(y * ((width - 1) * 18));   
+                }
+            }
+            else if (x == width - 1)
+            {
+                if (y == 0)
+                {
+                    result.push_back(((width - 1) * 18) - 9);
+                    result.push_back(((width - 1) * 18) - 12);
+                }
+                else if (y == width - 1)
+                {
+                    result.push_back((y * (width - 1) * 18) - 3);          
+                }
+                else
+                {
+                    result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) - 3);
+                    result.push_back((x * 18) + ((y * ((width - 1) * 18)) - 9)); 
+                    result.push_back((x * 18) + ((y * ((width - 1) * 18)) - 12));
+                }        
+            }
+            else if (y == 0)
+            {
+                result.push_back(x * 18 - 9);
+                result.push_back(x * 18 - 12); 
+                result.push_back(x * 18);
+            }
+            else if (y == width - 1)
+            {
+                result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) - 3);
+                result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) + 3);
+                result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) + 12);     
+            }
+            else
+            {
+                result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) - 3);
+                result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) + 3);
+                result.push_back((x * 18) + ((y - 1) * ((width - 1) * 18)) + 12);
+                result.push_back((x * 18) + ((y * (width - 1) * 18)) - 12);
+                result.push_back((x * 18) + ((y * (width - 1) * 18)) - 9);
+                result.push_back((x * 18) + (y * (width - 1) * 18));
+            }
+            
+            for (int i = first; i < result.size(); i++)
+                lattice.coords[result[i] / 3] = Vector2{(float)x, (float)y};
+        }
+    }
+    
+    lattice.offsets[width * width] = result.size();
+}
+
+
+void* FrameAllocate(size_t size, size_t alignment)
+{
+    FrameArena& arena = frameArena;
+    arena.allocations++;
+    
+    size_t start = (arena.used + alignment - 1) / alignment * alignment;
+    
+    if (start + size <= arena.capacity)
+    {
+        arena.used = start + size;
+        
+        if (arena.used > arena.peak)
+            arena.peak = arena.used;
+        
+        return arena.memory + start;
+    }
+    
+    // doesnt fit. take it from the heap for this tick and count it toward the size the arena grows to
+    arena.peak = std::max(arena.peak, arena.used) + size + alignment;
+    
+    void* block = RL_MALLOC(size);
+    arena.overflow.push_back(block);
+    
+    return block;
+}
+
+
+void ResetFrameArena(FrameArena& arena)
+{
+    for (int i = 0; i < arena.overflow.size(); i++)
+        RL_FREE(arena.overflow[i]);
+    
+    arena.overflow.clear();
+    
+    size_t wanted = std::max(arena.peak, (size_t)FRAME_ARENA_INITIAL_SIZE);
+    
+    if (wanted > FRAME_ARENA_MAX_SIZE)
+        wanted = FRAME_ARENA_MAX_SIZE;
+    
+    if (wanted > arena.capacity)
+    {
+        RL_FREE(arena.memory);
+        arena.memory = (unsigned char*)RL_MALLOC(wanted);
+        arena.capacity = wanted;
+    }
+    
+    arena.used = 0;
+    arena.peak = 0;
+    arena.allocations = 0;
+}
+
+
+void RewindFrameArena(FrameArena& arena, size_t used, int overflowCount)
+{
+    for (int i = overflowCount; i < arena.overflow.size(); i++)
+        RL_FREE(arena.overflow[i]);
+    
+    arena.overflow.resize(overflowCount);
+    arena.used = used;
+}
+
+
+void* operator new(size_t size) // counted so the allocations each tick can be shown
+{
+    heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    
+    void* block = malloc(size ? size : 1);
+    
+    if (!block)
+        throw std::bad_alloc();
+    
+    return block;
+}
+
+
+void operator delete(void* block) noexcept
+{
+    free(block);
+}
+
+
+void operator delete(void* block, size_t) noexcept
+{
+    free(block);
+}
+
+
+std::vector<Vector2> GetModelCoordsSelection(const std::vector<VertexState>& vsList)
+{
+    std::vector<Vector2> coords;
+    
+    coords.push_back(Vector2{vsList[0].coords.x, vsList[0].coords.y}); // get the first element's info
+    
+    if (vsList.size() > 1) // if list is only one, we're done
+    {
+        for (int i = 1; i < vsList.size(); i++) // add info from vsList if it's not already in coords
+        {
+            if (coords[coords.size() - 1].x != vsList[i].coords.x || coords[coords.size() - 1].y != vsList[i].coords.y) // check the last entry in coords before searching further (last entry will often match)
+            {
+                bool add = true;
+                
+                for (int j = 0; j < coords.size(); j++) // check coords if theres already a copy of this info anywhere in the list
+                {
+                    if (coords[j].x == vsList[i].coords.x && coords[j].y == vsList[i].coords.y) // dont add duplicates
+                    {
+                        add = false;
+                        break;
+                    }
+                }
+                
+                if (add)
+                    coords.push_back(Vector2{vsList[i].coords.x, vsList[i].coords.y});
+            }
+        }
+    }
+    else
+        return coords;
+    
+    return coords;
+}
+
+
+void SetExSelection(ModelSelection& modelSelection, int canvasWidth, int canvasHeight)
+{
+    modelSelection.expandedSelection = modelSelection.selection; // fill expanded selection with regular selection
+    
+    if (modelSelection.topLeft.x > 0 && modelSelection.topLeft.y > 0) // add the diagonally adjacent top left model
+    {
+        modelSelection.expandedSelection.push_back(Vector2{modelSelection.topLeft.x - 1, modelSelection.topLeft.y - 1});
+    }
+    
+    if (modelSelection.topLeft.y > 0 && modelSelection.bottomRight.x < canvasWidth - 1) // add the diagonally adjacent top right model
+    {
+        modelSelection.expandedSelection.push_back(Vector2{modelSelection.bottomRight.x + 1, modelSelection.topLeft.y - 1});
+    }
+    
+    if (modelSelection.bottomRight.x < canvasWidth - 1 && modelSelection.bottomRight.y < canvasHeight - 1) // add the diagonally adjacent bottom right model
+    {
+        modelSelection.expandedSelection.push_back(Vector2{modelSelection.bottomRight.x + 1, modelSelection.bottomRight.y + 1});
+    }
+    
+    if (modelSelection.topLeft.x > 0 && modelSelection.bottomRight.y < canvasHeight - 1) // add the diagonally adjacent bottom left model
+    {
+        modelSelection.expandedSelection.push_back(Vector2{modelSelection.topLeft.x - 1, modelSelection.bottomRight.y + 1});
+    }
+    
+    if (modelSelection.topLeft.y > 0) // fill top row
+    {
+        for (int i = 0; i < modelSelection.width; i++)
+        {
+            modelSelection.expandedSelection.push_back(Vector2{modelSelection.topLeft.x + i, modelSelection.topLeft.y - 1});
+        }
+    }
+    
+    if (modelSelection.bottomRight.x < canvasWidth - 1) // fill right column
+    {
+        for (int i = 0; i < modelSelection.height; i++)
+        {
+            modelSelection.expandedSelection.push_back(Vector2{modelSelection.bottomRight.x + 1, modelSelection.topLeft.y + i});
+        }
+    }
+    
+    if (modelSelection.bottomRight.y < canvasHeight - 1) // fill bottom row
+    {
+        for (int i = 0; i < modelSelection.width; i++)
+        {
+            modelSelection.expandedSelection.push_back(Vector2{modelSelection.topLeft.x + i, modelSelection.bottomRight.y + 1});
+        }
+    }
+    
+    if (modelSelection.topLeft.x > 0) // fill left column
+    {
+        for (int i = 0; i < modelSelection.height; i++)
+        {
+            modelSelection.expandedSelection.push_back(Vector2{modelSelection.topLeft.x - 1, modelSelection.topLeft.y + i});
+        }
+    }
+}
+
+
+void UpdateCharacterCamera(Camera* camera, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, bool grounded)
+{
+    static Vector2 previousMousePosition = { 0.0f, 0.0f };
+    
+    // Mouse movement detection
+    Vector2 mousePositionDelta = { 0.0f, 0.0f };
+    Vector2 mousePosition = GetMousePosition();
+    
+    bool direction[6] = { IsKeyDown(cameraMoveControl[MOVE_FRONT]),
+                           IsKeyDown(cameraMoveControl[MOVE_BACK]),
+                           IsKeyDown(cameraMoveControl[MOVE_RIGHT]),
+                           IsKeyDown(cameraMoveControl[MOVE_LEFT]),
+                           IsKeyDown(cameraMoveControl[MOVE_UP]),
+                           IsKeyDown(cameraMoveControl[MOVE_DOWN]) };
+                           
+    mousePositionDelta.x = mousePosition.x - previousMousePosition.x;
+    mousePositionDelta.y = mousePosition.y - previousMousePosition.y;
+
+    previousMousePosition = mousePosition;
+    
+    // Camera orientation calculation
+    cameraAngle.x += (mousePositionDelta.x*-CAMERA_MOUSE_MOVE_SENSITIVITY);
+    cameraAngle.y += (mousePositionDelta.y*-CAMERA_MOUSE_MOVE_SENSITIVITY);
+    
+    // Angle clamp
+    if (cameraAngle.y > CAMERA_FIRST_PERSON_MIN_CLAMP*DEG2RAD) cameraAngle.y = CAMERA_FIRST_PERSON_MIN_CLAMP*DEG2RAD;
+    else if (cameraAngle.y < CAMERA_FIRST_PERSON_MAX_CLAMP*DEG2RAD) cameraAngle.y = CAMERA_FIRST_PERSON_MAX_CLAMP*DEG2RAD;
+    
+    // movement direction for this frame. looking around stays per frame, only movement is simulated at a fixed rate
+    Vector2 move;
+    
+    move.x = sinf(cameraAngle.x)*direction[MOVE_BACK] -
+             sinf(cameraAngle.x)*direction[MOVE_FRONT] -
+             cosf(cameraAngle.x)*direction[MOVE_LEFT] +
+             cosf(cameraAngle.x)*direction[MOVE_RIGHT];
+                           
+    move.y = cosf(cameraAngle.x)*direction[MOVE_BACK] -
+             cosf(cameraAngle.x)*direction[MOVE_FRONT] +
+             sinf(cameraAngle.x)*direction[MOVE_LEFT] -
+             sinf(cameraAngle.x)*direction[MOVE_RIGHT];
+    
+    float stepTime = 1.0f/PLAYER_STEP_RATE;
+    
+    move.x *= PLAYER_MOVEMENT_SPEED*stepTime;
+    move.y *= PLAYER_MOVEMENT_SPEED*stepTime;
+    
+    playerTimeAccumulator += GetFrameTime();
+    
+    int steps = 0;
+    
+    while (playerTimeAccumulator >= stepTime)
+    {
+        if (steps == PLAYER_MAX_STEPS_PER_FRAME) // too far behind, drop the rest of the time
+        {
+            playerTimeAccumulator = 0;
+            break;
+        }
+        
+        previousPlayerPosition = playerPosition;
+        
+        if (!StepCharacter(models, playerPosition, move, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight, grounded)) // blocked, try sliding along each axis
+        {
+            if (!StepCharacter(models, playerPosition, Vector2{move.x, 0}, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight, grounded))
+                StepCharacter(models, playerPosition, Vector2{0, move.y}, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight, grounded);
+        }
+        
+        playerTimeAccumulator -= stepTime;
+        steps++;
+    }
+    
+    // place the camera between the last two steps by how far into the next step this frame is
+    Vector3 feet = Vector3Lerp(previousPlayerPosition, playerPosition, playerTimeAccumulator/stepTime);
+    
+    camera->position = Vector3{feet.x, feet.y + playerEyesHeight, feet.z};
+    
+    camera->target.x = camera->position.x - sinf(cameraAngle.x)*cosf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
+    camera->target.y = camera->position.y + sinf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
+    camera->target.z = camera->position.z - cosf(cameraAngle.x)*cosf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
+}
+
+
+void PlaceCharacter(Vector3 position)
+{
+    playerPosition = position;
+    previousPlayerPosition = position;
+    playerTimeAccumulator = 0;
+}
+
+
+bool StepCharacter(const std::vector<std::vector<Model>>& models, Vector3& position, Vector2 move, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, bool grounded)
+{
+    if (move.x == 0 && move.y == 0) // standing still, but the ground under it may have been edited
+    {
+        float groundY;
+        
+        if (grounded && SampleHeight(models, position.x, position.z, groundY, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight))
+            position.y = groundY;
+        
+        return true;
+    }
+    
+    if (!grounded) // the simulation thread has the heights. the next grounded step puts it back on the ground
+    {
+        float canvasX = models.size() * (modelWidth - (1 / (float)modelVertexWidth) * modelWidth); // from the layout, like FindHit2D
+        float canvasZ = models.empty() ? 0 : models[0].size() * (modelHeight - (1 / (float)modelVertexHeight) * modelHeight);
+        
+        if (position.x + move.x < 0 || position.x + move.x > canvasX || position.z + move.y < 0 || position.z + move.y > canvasZ) // off the mesh
+            return false;
+        
+        position = Vector3{position.x + move.x, position.y, position.z + move.y};
+        
+        return true;
+    }
+    
+    float groundY;
+    
+    if (!SampleHeight(models, position.x + move.x, position.z + move.y, groundY, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight)) // off the mesh
+        return false;
+    
+    if (groundY - position.y > PLAYER_STEP_HEIGHT) // too high to step up
+        return false;
+    
+    float run = sqrt(move.x * move.x + move.y * move.y);
+    float aheadY;
+    
+    if (SampleHeight(models, position.x + move.x / run * PLAYER_SLOPE_RUN, position.z + move.y / run * PLAYER_SLOPE_RUN, aheadY, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight) && aheadY - position.y > PLAYER_SLOPE_RUN * tanf(PLAYER_MAX_SLOPE*DEG2RAD)) // too steep to walk up. past the edge of the mesh only the step is tested
+        return false;
+    
+    position = Vector3{position.x + move.x, groundY, position.z + move.y}; // snap to the ground, going down is never blocked
+    
+    return true;
+}
+
+
+bool InputPressed()
+{
+    for (int button = MOUSE_LEFT_BUTTON; button <= MOUSE_MIDDLE_BUTTON; button++)
+    {
+        if (IsMouseButtonPressed(button) || IsMouseButtonReleased(button))
+            return true;
+    }
+    
+    for (int key = KEY_SPACE; key <= KEY_KB_MENU; key++)
+    {
+        if (IsKeyPressed(key))
+            return true;
+    }
+    
+    return false;
+}
+
+
+bool InputActive()
+{
+    static Vector2 previousMousePosition = { 0.0f, 0.0f };
+    
+    Vector2 mousePosition = GetMousePosition();
+    bool moved = mousePosition.x != previousMousePosition.x || mousePosition.y != previousMousePosition.y;
+    previousMousePosition = mousePosition;
+    
+    if (moved || GetMouseWheelMove() != 0)
+        return true;
+    
+    for (int button = MOUSE_LEFT_BUTTON; button <= MOUSE_MIDDLE_BUTTON; button++)
+    {
+        if (IsMouseButtonDown(button) || IsMouseButtonReleased(button))
+            return true;
+    }
+    
+    for (int key = KEY_SPACE; key <= KEY_KB_MENU; key++) // every key raylib knows. held keys move the camera and change brush settings
+    {
+        if (IsKeyDown(key) || IsKeyReleased(key))
+            return true;
+    }
+    
+    return false;
+}
+
+
+void UpdateFreeCamera(Camera* camera)
+{
+    static Vector2 previousMousePosition = { 0.0f, 0.0f };
+    
+    // Mouse movement detection
+    Vector2 mousePositionDelta = { 0.0f, 0.0f };
+    Vector2 mousePosition = GetMousePosition();
+    
+    bool direction[6] = { IsKeyDown(cameraMoveControl[MOVE_FRONT]),
+                           IsKeyDown(cameraMoveControl[MOVE_BACK]),
+                           IsKeyDown(cameraMoveControl[MOVE_RIGHT]),
+                           IsKeyDown(cameraMoveControl[MOVE_LEFT]),
+                           IsKeyDown(cameraMoveControl[MOVE_UP]),
+                           IsKeyDown(cameraMoveControl[MOVE_DOWN]) };
+                           
+    mousePositionDelta.x = mousePosition.x - previousMousePosition.x;
+    mousePositionDelta.y = mousePosition.y - previousMousePosition.y;
+
+    previousMousePosition = mousePosition;
+    
+    if (IsMouseButtonDown(MOUSE_RIGHT_BUTTON))
+    {
+        // Camera orientation calculation
+        cameraAngle.x += (mousePositionDelta.x*-CAMERA_MOUSE_MOVE_SENSITIVITY);
+        cameraAngle.y += (mousePositionDelta.y*-CAMERA_MOUSE_MOVE_SENSITIVITY);
+    }
+    
+    // Angle clamp
+    if (cameraAngle.y > CAMERA_FIRST_PERSON_MIN_CLAMP*DEG2RAD) cameraAngle.y = CAMERA_FIRST_PERSON_MIN_CLAMP*DEG2RAD;
+    else if (cameraAngle.y < CAMERA_FIRST_PERSON_MAX_CLAMP*DEG2RAD) cameraAngle.y = CAMERA_FIRST_PERSON_MAX_CLAMP*DEG2RAD;
+    
+    // free fly camera
+    camera->position.x += (sinf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_BACK] -
+                           sinf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_FRONT] -
+                           cosf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_LEFT] +
+                           cosf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_RIGHT]);
+                           
+    camera->position.y += (sinf(cameraAngle.y)*direction[MOVE_FRONT] -
+                           sinf(cameraAngle.y)*direction[MOVE_BACK] +
+                           1.0f*direction[MOVE_UP] - 1.0f*direction[MOVE_DOWN]);
+                           
+    camera->position.z += (cosf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_BACK] -
+                           cosf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_FRONT] +
+                           sinf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_LEFT] -
+                           sinf(cameraAngle.x)*cosf(cameraAngle.y)*direction[MOVE_RIGHT]);
+    
+    camera->target.x = camera->position.x - sinf(cameraAngle.x)*cosf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
+    camera->target.y = camera->position.y + sinf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
+    camera->target.z = camera->position.z - cosf(cameraAngle.x)*cosf(cameraAngle.y)*CAMERA_FIRST_PERSON_FOCUS_DISTANCE;
+}
+
+
+void UpdateOrthographicCamera(Camera* camera)
+{
+    bool direction[6] = { IsKeyDown(cameraMoveControl[MOVE_FRONT]),
+                           IsKeyDown(cameraMoveControl[MOVE_BACK]),
+                           IsKeyDown(cameraMoveControl[MOVE_RIGHT]),
+                           IsKeyDown(cameraMoveControl[MOVE_LEFT]),
+                           IsKeyDown(cameraMoveControl[MOVE_UP]),
+                           IsKeyDown(cameraMoveControl[MOVE_DOWN]) };
+    
+    // free fly camera
+    camera->position.x += direction[MOVE_RIGHT] - direction[MOVE_LEFT];
+                           
+    camera->position.y += direction[MOVE_UP] - direction[MOVE_DOWN];
+                           
+    camera->position.z += direction[MOVE_BACK] - direction[MOVE_FRONT];
+    
+    camera->target.x = camera->position.x;
+    camera->target.y = camera->position.y - 0.1;
+    camera->target.z = camera->position.z;
+}
+
+
+void PrintBoxInfo(Rectangle box, InputFocus currentFocus, InputFocus matchingFocus, const std::string& s, float info)
+{
+    if (currentFocus == matchingFocus || !s.empty())     
+    {
+        char c[s.size() + 1];
+        strcpy(c, s.c_str());                        
+        
+        DrawTextRec(GetFontDefault(), c, Rectangle {box.x + 2, box.y + 2, box.width - 2, box.height - 2}, 11, 1.f, false, BLACK);
+    }
+    else     
+    {
+        std::string temp = std::to_string(info);
+        char c[temp.size() + 1];
+        strcpy(c, temp.c_str());
+        
+        DrawTextRec(GetFontDefault(), c, Rectangle {box.x + 2, box.y + 2, box.width - 2, box.height - 2}, 11, 1.f, false, BLACK);
+    }
+}
+
+
+void PrintBoxInfo(Rectangle box, InputFocus currentFocus, InputFocus matchingFocus, const std::string& s, int info)
+{
+    if (currentFocus == matchingFocus || !s.empty())     
+    {
+        char c[s.size() + 1];
+        strcpy(c, s.c_str());                        
+        
+        DrawTextRec(GetFontDefault(), c, Rectangle {box.x + 2, box.y + 2, box.width - 2, box.height - 2}, 11, 1.f, false, BLACK);
+    }
+    else     
+    {
+        std::string temp = std::to_string(info);
+        char c[temp.size() + 1];
+        strcpy(c, temp.c_str());
+        
+        DrawTextRec(GetFontDefault(), c, Rectangle {box.x + 2, box.y + 2, box.width - 2, box.height - 2}, 11, 1.f, false, BLACK);
+    }
+}
+
+
+void ProcessInput(int key, std::string& s, float& input, InputFocus& inputFocus, int maxSize)
+{
+    if (((key >= 48 && key <= 57) || key == 46) && ((int)s.size() < maxSize))
+    {
+        if (key == 48 && s.empty())
+        {}
+        else
+            s.push_back((char)key);
+    }
+
+    if (IsKeyPressed(KEY_BACKSPACE) && !s.empty())
+        s.pop_back();
+    
+    if (IsKeyPressed(KEY_ENTER) || IsKeyPressed(KEY_KP_ENTER))
+    {
+        if (s.empty())
+            inputFocus = InputFocus::NONE;
+        else
+        {
+            input = stof(s);
+            inputFocus = InputFocus::NONE; 
+        }
+    }
+}
+
+
+FrameVector<VertexState> FindVertexSelection(const std::vector<std::vector<Model>>& models, const ModelSelection& modelSelection, RayHitInfo hitPosition, float selectRadius, int modelVertexWidth, int modelVertexHeight)
+{
+    FrameVector<VertexState>vertexIndices; // vector to return
+    
+    if (hitPosition.hit)
+    {
+        Vector2 hitCoords = {hitPosition.position.x, hitPosition.position.z};
+        int canvasWidth = models.size();
+        int canvasHeight = models[0].size();
+        
+        for (int i = 0; i < modelSelection.selection.size(); i++) // check models for vertices to be selected
+        {
+            int modelX = modelSelection.selection[i].x;
+            int modelY = modelSelection.selection[i].y;
+            const Mesh& mesh = models[modelX][modelY].meshes[0];
+            
+            for (int z = 0; z < modelVertexHeight; z++)
+            {
+                for (int x = 0; x < modelVertexWidth; x++) // one vertex per lattice point. the rest of the point's vertices are written along with it
+                {
+                    if ((x == modelVertexWidth - 1 && modelX < canvasWidth - 1) || (z == modelVertexHeight - 1 && modelY < canvasHeight - 1)) // a point on a shared right or bottom edge is found from the model that has it on its left or top edge
+                        continue;
+                    
+                    int index = GetVertexIndices(x, z, modelVertexWidth)[0];
+                    Vector2 vertexCoords = {mesh.vertices[index], mesh.vertices[index + 2]};
+                    
+                    if (xzDistance(hitCoords, vertexCoords) > selectRadius)
+                        continue;
+                    
+                    LatticeCopy copies[4];
+                    int copyCount = GetLatticeCopies(modelX, modelY, x, z, modelVertexWidth, modelVertexHeight, canvasWidth, canvasHeight, copies);
+                    
+                    if (!LatticeCopiesInSelection(copies, copyCount, modelSelection)) // editing it would leave the copy outside the selection behind
+                        continue;
+                    
+                    VertexState vs;
+                    vs.coords.x = modelX;
+                    vs.coords.y = modelY;
+                    vs.index = index;
+                    
+                    vertexIndices.push_back(vs); // store the vertex's index in the mesh and its models coords
+                }
+            }
+        }
+    }
+    
+    return vertexIndices;
+}
+
+
+int GetLatticeCopies(int modelX, int modelY, int x, int z, int modelVertexWidth, int modelVertexHeight, int canvasWidth, int canvasHeight, LatticeCopy* copies)
+{
+    int columns[2][2] = {{modelX, x}}; // model and lattice column of each copy along x
+    int columnCount = 1;
+    
+    if (x == 0 && modelX > 0)
+    {
+        columns[1][0] = modelX - 1;
+        columns[1][1] = modelVertexWidth - 1;
+        columnCount++;
+    }
+    else if (x == modelVertexWidth - 1 && modelX < canvasWidth - 1)
+    {
+        columns[1][0] = modelX + 1;
+        columns[1][1] = 0;
+        columnCount++;
+    }
+    
+    int rows[2][2] = {{modelY, z}};
+    int rowCount = 1;
+    
+    if (z == 0 && modelY > 0)
+    {
+        rows[1][0] = modelY - 1;
+        rows[1][1] = modelVertexHeight - 1;
+        rowCount++;
+    }
+    else if (z == modelVertexHeight - 1 && modelY < canvasHeight - 1)
+    {
+        rows[1][0] = modelY + 1;
+        rows[1][1] = 0;
+        rowCount++;
+    }
+    
+    int count = 0;
+    
+    for (int i = 0; i < rowCount; i++)
+    {
+        for (int j = 0; j < columnCount; j++)
+        {
+            copies[count].modelX = columns[j][0];
+            copies[count].modelY = rows[i][0];
+            copies[count].x = columns[j][1];
+            copies[count].z = rows[i][1];
+            count++;
+        }
+    }
+    
+    return count;
+}
+
+
+bool LatticeCopiesInSelection(const LatticeCopy* copies, int count, const ModelSelection& modelSelection)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (copies[i].modelX < modelSelection.topLeft.x || copies[i].modelX > modelSelection.bottomRight.x || copies[i].modelY < modelSelection.topLeft.y || copies[i].modelY > modelSelection.bottomRight.y)
+            return false;
+    }
+    
+    return true;
+}
+
+
+void SetLatticeHeight(std::vector<std::vector<Model>>& models, const LatticeCopy* copies, int count, float y, int modelVertexWidth)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float* vertices = models[copies[i].modelX][copies[i].modelY].meshes[0].vertices;
+        VertexIndexSpan indices = GetVertexIndices(copies[i].x, copies[i].z, modelVertexWidth);
+        
+        for (int j = 0; j < indices.size(); j++)
+            vertices[indices[j] + 1] = y;
+    }
+}
+
+
+void SetVertexHeight(std::vector<std::vector<Model>>& models, const VertexState& vertex, float y, int modelVertexWidth, int modelVertexHeight)
+{
+    Vector2 coords = GetVertexCoords(vertex.index, modelVertexWidth);
+    
+    LatticeCopy copies[4];
+    int count = GetLatticeCopies(vertex.coords.x, vertex.coords.y, coords.x, coords.y, modelVertexWidth, modelVertexHeight, models.size(), models[0].size(), copies);
+    
+    SetLatticeHeight(models, copies, count, y, modelVertexWidth);
+}
+
+
+void FindStampPoints(float stampRotationAngle, float stampStretchLength, Vector2& outVec1, Vector2& outVec2, Vector2 stampAnchor)
+{
+    float offsetX;
+    float offsetY;
+    // find the locations of stamp1 and stamp2 given the stretch length and rotation angle
+    if (stampRotationAngle == 0)
+    {
+        offsetX = 0;
+        offsetY = stampStretchLength/2;
+    }
+    else if (stampRotationAngle > 0 && stampRotationAngle < 90)
+    {
+        float a = 90 - stampRotationAngle;
+        
+        offsetX = ((stampStretchLength / 2) * sinf(stampRotationAngle*DEG2RAD));
+        offsetY = ((stampStretchLength / 2) * sinf(a*DEG2RAD));
+    }
+    else if (stampRotationAngle == 90)
+    {
+        offsetX = stampStretchLength/2;
+        offsetY = 0;
+    }
+    else if (stampRotationAngle > 90 && stampRotationAngle < 180)
+    {
+        float b = stampRotationAngle - 90;
+        float a = 90 - b;
+        
+        offsetX = ((stampStretchLength / 2) * sinf(a*DEG2RAD));
+        offsetY = -((stampStretchLength / 2) * sinf(b*DEG2RAD));
+    }
+    else if (stampRotationAngle == 180)
+    {
+        offsetX = 0;
+        offsetY = -stampStretchLength/2;
+    }
+    else if (stampRotationAngle > 180 && stampRotationAngle < 270)
+    {
+        float b = stampRotationAngle - 180;
+        float a = 90 - b;
+        
+        offsetX = -((stampStretchLength / 2) * sinf(b*DEG2RAD));
+        offsetY = -((stampStretchLength / 2) * sinf(a*DEG2RAD));
+    }
+    else if (stampRotationAngle == 270)
+    {
+        offsetX = -stampStretchLength/2;
+        offsetY = 0;
+    }
+    else if (stampRotationAngle > 270)
+    {
+        float b = stampRotationAngle - 270;
+        float a = 90 - b;
+        
+        offsetX = -((stampStretchLength / 2) * sinf(a*DEG2RAD));
+        offsetY = ((stampStretchLength / 2) * sinf(b*DEG2RAD));
+    }
+    
+    outVec1 = Vector2{stampAnchor.x + offsetX, stampAnchor.y + offsetY};
+    outVec2 = Vector2{stampAnchor.x - offsetX, stampAnchor.y - offsetY};
+    
+    return;
+}
+
+
+float PointSegmentDistance(Vector2 point, Vector2 segmentPoint1, Vector2 segmentPoint2)
+{
+    float a = point.x - segmentPoint1.x;
+    float b = point.y - segmentPoint1.y;
+    float c = segmentPoint2.x - segmentPoint1.x;
+    float d = segmentPoint2.y - segmentPoint1.y;
+
+    float dot = a * c + b * d;
+    float len_sq = c * c + d * d;
+    float p = -1;
+    
+    if (len_sq != 0) 
+      p = dot / len_sq;
+
+    float xx;
+    float yy;
+
+    if (p < 0)
+    {
+        xx = segmentPoint1.x;
+        yy = segmentPoint1.y;
+    }
+    else if (p > 1) 
+    {
+        xx = segmentPoint2.x;
+        yy = segmentPoint2.y;
+    }
+    else 
+    {
+        xx = segmentPoint1.x + p * c;
+        yy = segmentPoint1.y + p * d;
+    }
+
+    float dx = point.x - xx;
+    float dy = point.y - yy;
+    
+    return sqrt(dx * dx + dy * dy);    
+}
+
+
+bool SampleHeight(const std::vector<std::vector<Model>>& models, float x, float z, float& outY, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, Vector2 topLeft)
+{
+    if (models.empty())
+        return false;
+    
+    float spacingX = modelWidth / (float)modelVertexWidth; // distance between two vertices on the x axis
+    float spacingZ = modelHeight / (float)modelVertexHeight;
+    
+    // position in vertices relative to the first vertex of models[0][0]. models share their border vertices so each model covers modelVertexWidth - 1 quads
+    float gridX = x / spacingX - topLeft.x * (modelVertexWidth - 1);
+    float gridZ = z / spacingZ - topLeft.y * (modelVertexHeight - 1);
+    
+    float maxX = models.size() * (modelVertexWidth - 1);
+    float maxZ = models[0].size() * (modelVertexHeight - 1);
+    
+    if (gridX < 0 || gridZ < 0 || gridX > maxX || gridZ > maxZ)
+        return false;
+    
+    int modelX = (int)gridX / (modelVertexWidth - 1);
+    int modelZ = (int)gridZ / (modelVertexHeight - 1);
+    
+    if (modelX > models.size() - 1) // on the far edge of the last model
+        modelX = models.size() - 1;
+    
+    if (modelZ > models[0].size() - 1)
+        modelZ = models[0].size() - 1;
+    
+    float localX = gridX - modelX * (modelVertexWidth - 1);
+    float localZ = gridZ - modelZ * (modelVertexHeight - 1);
+    
+    int quadX = (int)localX;
+    int quadZ = (int)localZ;
+    
+    if (quadX > modelVertexWidth - 2)
+        quadX = modelVertexWidth - 2;
+    
+    if (quadZ > modelVertexHeight - 2)
+        quadZ = modelVertexHeight - 2;
+    
+    if (!ModelLoaded(models[modelX][modelZ])) // paged out, treated as off the mesh until it is back
+        return false;
+    
+    float fx = localX - quadX; // position inside the quad, 0 to 1
+    float fz = localZ - quadZ;
+    
+    // each quad is 2 triangles, 18 floats. the first is (x, z), (x, z + 1), (x + 1, z) and the second (x + 1, z), (x, z + 1), (x + 1, z + 1)
+    const float* vertices = models[modelX][modelZ].meshes[0].vertices + (quadZ * (modelVertexWidth - 1) + quadX) * 18;
+    
+    float topLeftY = vertices[1];
+    float bottomLeftY = vertices[4];
+    float topRightY = vertices[7];
+    float bottomRightY = vertices[16];
+    
+    if (fx + fz <= 1) // first triangle
+        outY = topLeftY + fx * (topRightY - topLeftY) + fz * (bottomLeftY - topLeftY);
+    else
+        outY = bottomRightY + (1 - fx) * (bottomLeftY - bottomRightY) + (1 - fz) * (topRightY - bottomRightY);
+    
+    return true;
+}
+
+
+float StampVertexHeight(float distance, float vertexY, const StampParams& stamp)
+{
+    float y;
+    
+    if (stamp.flip) // if stamp is upside down
+    {
+        float dist = distance - stamp.innerRadius; // distance from the middle of the selection
+        
+        if (dist < 0) // the vertices inside inner radius will be at y = 0
+            y = 0;
+        else
+            y = dist * stamp.slopeRatio;
+    }
+    else
+        y = (stamp.influenceRadius - distance) * stamp.slopeRatio; // distance from the edge of the selection radius
+    
+    if (y > stamp.heightCap) // if the vertex is within the inner radius, limit its height extention
+        y = stamp.heightCap;
+    
+    if (stamp.invert)
+        y = -y;
+    
+    if (stamp.offset != 0)
+        y += stamp.offset;
+    
+    y += stamp.baseY;
+    
+    if (stamp.cutOff && y > stamp.cutOff) // dont allow y to go higher than what the cut off is set to
+        y = stamp.cutOff;
+        
+    if (stamp.raiseOnly && y < vertexY) // if raise only is on and vertex would be lowered, keep the old value
+        y = vertexY;
+        
+    if (stamp.lowerOnly && y > vertexY) // if lower only is on and vertex would be raised, keep the old value
+        y = vertexY;
+    
+    return y;
+}
+
+
+bool CapsuleRowSpan(Vector2 segmentPoint1, Vector2 segmentPoint2, float radius, float rowZ, float& outStart, float& outEnd)
+{
+    // the capsule is convex so a row crosses it in one span. that span is the union of the spans through the two end circles and the rectangle between them
+    float spanStart = FLT_MAX;
+    float spanEnd = -FLT_MAX;
+    
+    Vector2 ends[2] = {segmentPoint1, segmentPoint2};
+    
+    for (int i = 0; i < 2; i++) // end circles
+    {
+        float dz = rowZ - ends[i].y;
+        
+        if (fabs(dz) <= radius)
+        {
+            float halfWidth = sqrt(radius * radius - dz * dz);
+            
+            if (ends[i].x - halfWidth < spanStart)
+                spanStart = ends[i].x - halfWidth;
+            
+            if (ends[i].x + halfWidth > spanEnd)
+                spanEnd = ends[i].x + halfWidth;
+        }
+    }
+    
+    float c = segmentPoint2.x - segmentPoint1.x;
+    float d = segmentPoint2.y - segmentPoint1.y;
+    float length = sqrt(c * c + d * d);
+    
+    if (length > 0) // rectangle. along the row both the position of the projection on the segment and the distance from the segment's line are linear in x
+    {
+        float slopes[2] = {c / (length * length), d / length}; // change per unit of x
+        float intercepts[2] = {(-segmentPoint1.x * c + (rowZ - segmentPoint1.y) * d) / (length * length), (-segmentPoint1.x * d - (rowZ - segmentPoint1.y) * c) / length}; // value at x = 0
+        float minValues[2] = {0, -radius}; // projection has to be between the segment points, distance within the radius
+        float maxValues[2] = {1, radius};
+        
+        float rectStart = -FLT_MAX;
+        float rectEnd = FLT_MAX;
+        
+        for (int i = 0; i < 2; i++)
+        {
+            if (slopes[i] == 0)
+            {
+                if (intercepts[i] < minValues[i] || intercepts[i] > maxValues[i]) // constant along the row and out of range
+                {
+                    rectStart = FLT_MAX;
+                    break;
+                }
+            }
+            else
+            {
+                float x1 = (minValues[i] - intercepts[i]) / slopes[i];
+                float x2 = (maxValues[i] - intercepts[i]) / slopes[i];
+                
+                if (x1 > x2)
+                {
+                    float temp = x1;
+                    x1 = x2;
+                    x2 = temp;
+                }
+                
+                if (x1 > rectStart)
+                    rectStart = x1;
+                
+                if (x2 < rectEnd)
+                    rectEnd = x2;
+            }
+        }
+        
+        if (rectStart <= rectEnd)
+        {
+            if (rectStart < spanStart)
+                spanStart = rectStart;
+            
+            if (rectEnd > spanEnd)
+                spanEnd = rectEnd;
+        }
+    }
+    
+    if (spanStart > spanEnd)
+        return false;
+    
+    outStart = spanStart;
+    outEnd = spanEnd;
+    
+    return true;
+}
+
+
+void StampCapsule(std::vector<std::vector<Model>>& models, const ModelSelection& modelSelection, Vector2 segmentPoint1, Vector2 segmentPoint2, const StampParams& stamp, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight)
+{
+    float spacingX = modelWidth / (float)modelVertexWidth; // distance between two vertices on the x axis
+    float spacingZ = modelHeight / (float)modelVertexHeight;
+    
+    float topZ = fmin(segmentPoint1.y, segmentPoint2.y) - stamp.influenceRadius; // bounding region of the capsule on the z axis
+    float bottomZ = fmax(segmentPoint1.y, segmentPoint2.y) + stamp.influenceRadius;
+    
+    for (int i = 0; i < modelSelection.selection.size(); i++)
+    {
+        Mesh& mesh = models[modelSelection.selection[i].x][modelSelection.selection[i].y].meshes[0];
+        
+        float originX = modelSelection.selection[i].x * (modelVertexWidth - 1) * spacingX; // location of this model's first vertex
+        float originZ = modelSelection.selection[i].y * (modelVertexHeight - 1) * spacingZ;
+        
+        // rows and columns are widened by one vertex so rounding never skips one on the edge. the exact distance test below decides
+        int firstRow = (int)floor((topZ - originZ) / spacingZ) - 1;
+        int lastRow = (int)ceil((bottomZ - originZ) / spacingZ) + 1;
+        
+        if (firstRow < 0) firstRow = 0;
+        if (lastRow > modelVertexHeight - 1) lastRow = modelVertexHeight - 1;
+        
+        for (int z = firstRow; z <= lastRow; z++)
+        {
+            float spanStart;
+            float spanEnd;
+            
+            if (!CapsuleRowSpan(segmentPoint1, segmentPoint2, stamp.influenceRadius + spacingZ, originZ + z * spacingZ, spanStart, spanEnd)) // radius widened by a row so rows grazing the capsule arent skipped
+                continue;
+            
+            int firstColumn = (int)floor((spanStart - originX) / spacingX) - 1;
+            int lastColumn = (int)ceil((spanEnd - originX) / spacingX) + 1;
+            
+            if (firstColumn < 0) firstColumn = 0;
+            if (lastColumn > modelVertexWidth - 1) lastColumn = modelVertexWidth - 1;
+            
+            for (int x = firstColumn; x <= lastColumn; x++)
+            {
+                if ((x == modelVertexWidth - 1 && modelSelection.selection[i].x < modelSelection.bottomRight.x) || (z == modelVertexHeight - 1 && modelSelection.selection[i].y < modelSelection.bottomRight.y)) // stamped from the selected model that has it on its left or top edge
+                    continue;
+                
+                int index = GetVertexIndices(x, z, modelVertexWidth)[0];
+                
+                Vector2 vertexCoords = {mesh.vertices[index], mesh.vertices[index + 2]};
+                
+                float dist = PointSegmentDistance(vertexCoords, segmentPoint1, segmentPoint2);
+                
+                if (dist <= stamp.influenceRadius)
+                {
+                    LatticeCopy copies[4];
+                    int copyCount = GetLatticeCopies(modelSelection.selection[i].x, modelSelection.selection[i].y, x, z, modelVertexWidth, modelVertexHeight, models.size(), models[0].size(), copies);
+                    
+                    if (LatticeCopiesInSelection(copies, copyCount, modelSelection)) // a copy outside the selection cant be written, so neither is this one
+                        SetLatticeHeight(models, copies, copyCount, StampVertexHeight(dist, mesh.vertices[index + 1], stamp), modelVertexWidth);
+                }
+            }
+        }
+    }
+}
+
+
+Mesh CopyMesh(const Mesh& mesh)
+{
+    // (doesnt copy animation data)
+    Mesh newMesh = { 0 };
+    newMesh.vboId = (unsigned int *)RL_CALLOC(7, sizeof(unsigned int)); // (MAX_MESH_VBO = 7)
+    
+    newMesh.vertexCount = mesh.vertexCount;
+    newMesh.triangleCount = mesh.triangleCount;
+    
+    newMesh.vertices = (float *)RL_MALLOC(mesh.vertexCount*3*sizeof(float));
+    newMesh.normals = (float *)RL_MALLOC(mesh.vertexCount*3*sizeof(float));
+    newMesh.texcoords = (float *)RL_MALLOC(mesh.vertexCount*2*sizeof(float));
+    newMesh.colors = NULL;
+    
+    for (int i = 0; i < mesh.vertexCount*3; i++)
+    {
+        newMesh.vertices[i] = mesh.vertices[i];
+    }
+    
+    for (int i = 0; i < mesh.vertexCount*3; i++)
+    {
+        newMesh.normals[i] = mesh.normals[i];
+    }
+    
+    for (int i = 0; i < mesh.vertexCount*2; i++)
+    {
+        newMesh.texcoords[i] = mesh.texcoords[i];
+    }
+    
+    rlLoadMesh(&newMesh, false);
+    
+    return newMesh;
+}
+
+
+void Smooth(std::vector<std::vector<Model>>& models, const FrameVector<VertexState>& vertices, int modelVertexWidth, int modelVertexHeight, int canvasWidth, int canvasHeight)
+{
+    FrameVector<VertexState> changes; //  calculate and then make changes all at once rather than one at a time
+    changes.reserve(vertices.size());
+    
+    for (int i = 0; i < vertices.size(); ++i)
+    {
+        Vector2 coords = GetVertexCoords(vertices[i].index, modelVertexWidth);
+        
+        float yValues[4]; // at most one neighbour on each side
+        int yValueCount = 0;
+        
+        if (coords.x != 0) // dont attempt x = -1
+        {
+            int index = GetVertexIndices(coords.x - 1, coords.y, modelVertexWidth)[0];
+            
+            yValues[yValueCount++] = models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[index + 1];   
+        }
+        else if (coords.x == 0 && (vertices[i].coords.x > 0)) // if the vertex x coord is 0, check if there is another model to the left
+        {
+            int index = GetVertexIndices(modelVertexWidth - 2, coords.y, modelVertexWidth)[0]; // get the index of the vertex in the other model
+            
+            yValues[yValueCount++] = models[vertices[i].coords.x - 1][vertices[i].coords.y].meshes[0].vertices[index + 1];
+        }
+        
+        if (coords.x != modelVertexWidth - 1) // dont attempt out of bounds x
+        {
+            int index = GetVertexIndices(coords.x + 1, coords.y, modelVertexWidth)[0];
+            
+            yValues[yValueCount++] = models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[index + 1];
+        }
+        else if (coords.x == modelVertexWidth - 1 && (vertices[i].coords.x < canvasWidth - 1)) // if the vertex x coord is at max width, check if there is another model to the right
+        {
+            int index = GetVertexIndices(1, coords.y, modelVertexWidth)[0]; // get the index of the vertex in the other model
+            
+            yValues[yValueCount++] = models[vertices[i].coords.x + 1][vertices[i].coords.y].meshes[0].vertices[index + 1];                                   
+        }
+        
+        if (coords.y != 0) // dont attempt y = -1
+        {
+            int index = GetVertexIndices(coords.x, coords.y - 1, modelVertexWidth)[0];
+            
+            yValues[yValueCount++] = models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[index + 1];    
+        }
+        else if (coords.y == 0 && (vertices[i].coords.y > 0)) // if the vertex y coord is at the top, check if there is a model above
+        {
+            int index = GetVertexIndices(coords.x, modelVertexHeight - 2, modelVertexWidth)[0]; // get the index of the vertex in the other model
+            
+            yValues[yValueCount++] = models[vertices[i].coords.x][vertices[i].coords.y - 1].meshes[0].vertices[index + 1];
+        }
+        
+        if (coords.y != modelVertexHeight - 1) // dont attempt out of bounds y
+        {
+            int index = GetVertexIndices(coords.x, coords.y + 1, modelVertexWidth)[0];
+            
+            yValues[yValueCount++] = models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[index + 1];
+        }
+        else if (coords.y == modelVertexHeight - 1 && (vertices[i].coords.y < canvasHeight - 1)) // if the vertex y coord is at the bottom, check if there is a model below
+        {
+            int index = GetVertexIndices(coords.x, 1, modelVertexWidth)[0]; // get the index of the vertex in the other model
+            
+            yValues[yValueCount++] = models[vertices[i].coords.x][vertices[i].coords.y + 1].meshes[0].vertices[index + 1];
+        }
+        
+        float average = 0;
+        
+        for (int i = 0; i < yValueCount; i++)
+        {
+            average += yValues[i];
+        }
+        
+        average = average / (float)yValueCount;
+        
+        VertexState temp;
+        temp.coords = vertices[i].coords;
+        temp.index = vertices[i].index;
+        temp.y = average;
+        
+        changes.push_back(temp);
+    }
+
+    for (int i = 0; i < changes.size(); i++) // enact all changes 
+    {
+        SetVertexHeight(models, changes[i], changes[i].y, modelVertexWidth, modelVertexHeight);
+    }
+    
+    return;
+}
+
+
+void EncodeSplitRow(const float* values, int count, unsigned char* pixels)
+{
+    for (int i = 0; i < count; i++)
+    {
+        float value = values[i];
+        value = value < 0 ? 0 : (value > 1 ? 1 : value);
+        
+        unsigned int pixelValue = value * 2147483647;
+        
+        pixels[i * 4] = pixelValue & 0xFF;
+        pixels[i * 4 + 1] = (pixelValue >> 8) & 0xFF;
+        pixels[i * 4 + 2] = (pixelValue >> 16) & 0xFF;
+        pixels[i * 4 + 3] = pixelValue >> 24;
+    }
+}
+
+
+void DecodeSplitRow(const unsigned char* pixels, int count, float* values)
+{
+    for (int i = 0; i < count; i++)
+    {
+        unsigned int pixelValue = (unsigned int)pixels[i * 4] | (unsigned int)pixels[i * 4 + 1] << 8 | (unsigned int)pixels[i * 4 + 2] << 16 | (unsigned int)pixels[i * 4 + 3] << 24;
+        
+        values[i] = pixelValue / 2147483647.f;
+    }
+}
+
+
+unsigned long PixelToHeight(Color pixel)
+{
+    std::bitset<32> heightValueBits;
+    int heightValueIndex = 0;
+    
+    std::bitset<8> redPixels(pixel.r);
+    
+    for (int i = 0; i < 8; i++)
+    {
+        heightValueBits[heightValueIndex] = redPixels[i];
+        heightValueIndex++;
+    }
+    
+    std::bitset<8> greenPixels(pixel.g);
+    
+    for (int i = 0; i < 8; i++)
+    {
+        heightValueBits[heightValueIndex] = greenPixels[i];
+        heightValueIndex++;
+    }
+    
+    std::bitset<8> bluePixels(pixel.b);
+    
+    for (int i = 0; i < 8; i++)
+    {
+        heightValueBits[heightValueIndex] = bluePixels[i];
+        heightValueIndex++;
+    }
+    
+    std::bitset<8> alphaPixels(pixel.a);
+    
+    for (int i = 0; i < 8; i++)
+    {
+        heightValueBits[heightValueIndex] = alphaPixels[i];
+        heightValueIndex++;
+    }
+    
+    return heightValueBits.to_ulong();
+}
+
+
+Color HeightToPixel(unsigned long height)
+{
+    std::bitset<32> heightValueBits(height);
+    unsigned char channels[4];
+    
+    for (int channel = 0; channel < 4; channel++) // red takes the lowest 8 bits, alpha the highest
+    {
+        std::bitset<8> channelBits;
+        
+        for (int i = 0; i < 8; i++)
+            channelBits[i] = heightValueBits[channel * 8 + i];
+        
+        channels[channel] = (unsigned char)channelBits.to_ulong();
+    }
+    
+    return (Color){ channels[0], channels[1], channels[2], channels[3] };
+}
+
+
+int LatticeVertexIndex(int x, int z, int modelVertexWidth, int modelVertexHeight)
+{
+    return LatticeVertexIndex(x, z, TileGeometry{modelVertexWidth, modelVertexHeight});
+}
+
+
+template<class Geometry>
+int LatticeVertexIndex(int x, int z, const Geometry& geometry)
+{
+    // every lattice point is the first vertex of the quad to its bottom right, except on the last column and row where it has to be taken from the quad before it
+    int quadX = x;
+    int quadZ = z;
+    int vertex = 0;
+    
+    if (x == geometry.width - 1 && z == geometry.height - 1) // bottom right corner, last vertex of the last quad
+    {
+        quadX--;
+        quadZ--;
+        vertex = 5;
+    }
+    else if (x == geometry.width - 1) // right column, top right vertex of the quad to the left
+    {
+        quadX--;
+        vertex = 2;
+    }
+    else if (z == geometry.height - 1) // bottom row, bottom left vertex of the quad above
+    {
+        quadZ--;
+        vertex = 1;
+    }
+    
+    return (quadZ * (geometry.width - 1) + quadX) * 18 + vertex * 3;
+}
+
+
+template<class Kernel>
+void DispatchTileGeometry(int modelVertexWidth, int modelVertexHeight, Kernel kernel)
+{
+    if (modelVertexWidth == modelVertexHeight)
+    {
+        switch (modelVertexWidth)
+        {
+            case 65: kernel(FixedTileGeometry<65>()); return;
+            case 120: kernel(FixedTileGeometry<120>()); return;
+            case 129: kernel(FixedTileGeometry<129>()); return;
+            case 257: kernel(FixedTileGeometry<257>()); return;
+        }
+    }
+    
+    kernel(TileGeometry{modelVertexWidth, modelVertexHeight}); // anything else, like a project saved with a size the editor doesnt offer
+}
+
+
+const char* HeightmapExtension(HeightmapFormat format)
+{
+    if (format == HeightmapFormat::R16)
+        return ".r16";
+    
+    if (format == HeightmapFormat::R32F)
+        return ".r32";
+    
+    if (format == HeightmapFormat::PROJECT)
+        return ".pangea";
+    
+    if (format == HeightmapFormat::OBJ)
+        return ".obj";
+    
+    if (format == HeightmapFormat::GLB)
+        return ".glb";
+    
+    if (format == HeightmapFormat::TILES)
+        return ".json";
+    
+    return ".png";
+}
+
+
+unsigned int UpdateCrc32(unsigned int crc, const unsigned char* data, int length)
+{
+    static const std::vector<unsigned int> table = []() // filled once, safely even when chunks are written on several threads
+    {
+        std::vector<unsigned int> table(256);
+        
+        for (unsigned int i = 0; i < 256; i++)
+        {
+            unsigned int c = i;
+            
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            
+            table[i] = c;
+        }
+        
+        return table;
+    }();
+    
+    for (int i = 0; i < length; i++)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    
+    return crc;
+}
+
+
+unsigned int UpdateAdler32(unsigned int adler, const unsigned char* data, int length)
+{
+    unsigned int a = adler & 0xFFFF;
+    unsigned int b = adler >> 16;
+    
+    while (length > 0)
+    {
+        int block = length < 5552 ? length : 5552; // largest run that cant overflow before the modulo
+        
+        for (int i = 0; i < block; i++)
+        {
+            a += data[i];
+            b += a;
+        }
+        
+        a %= 65521;
+        b %= 65521;
+        
+        data += block;
+        length -= block;
+    }
+    
+    return (b << 16) | a;
+}
+
+
+void WritePngChunk(FILE* file, const char* type, const unsigned char* data, int length)
+{
+    unsigned char header[8] = {(unsigned char)(length >> 24), (unsigned char)(length >> 16), (unsigned char)(length >> 8), (unsigned char)length, (unsigned char)type[0], (unsigned char)type[1], (unsigned char)type[2], (unsigned char)type[3]};
+    
+    unsigned int crc = UpdateCrc32(0xFFFFFFFFu, header + 4, 4); // crc covers the type and data, not the length
+    crc = UpdateCrc32(crc, data, length) ^ 0xFFFFFFFFu;
+    
+    unsigned char footer[4] = {(unsigned char)(crc >> 24), (unsigned char)(crc >> 16), (unsigned char)(crc >> 8), (unsigned char)crc};
+    
+    fwrite(header, 1, 8, file);
+    fwrite(data, 1, length, file);
+    fwrite(footer, 1, 4, file);
+}
+
+
+bool BeginPngStream(PngStream& png, const char* fileName, int width, int height, int bitDepth, int colorType)
+{
+    png.file = fopen(fileName, "wb");
+    
+    if (!png.file)
+        return false;
+    
+    png.adler = 1;
+    png.zlibStarted = false;
+    png.pixelSize = (bitDepth < 8 ? 1 : bitDepth / 8) * (colorType == 6 ? 4 : colorType == 2 ? 3 : colorType == 4 ? 2 : 1);
+    png.buffer.clear();
+    png.window.clear();
+    png.windowStart = 0;
+    png.hashHead.assign(1 << PNG_HASH_BITS, -1);
+    png.hashPrevious.assign(PNG_WINDOW_SIZE, -1);
+    png.bitBuffer = 0;
+    png.bitCount = 0;
+    
+    const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    fwrite(signature, 1, 8, png.file);
+    
+    unsigned char ihdr[13] = {(unsigned char)(width >> 24), (unsigned char)(width >> 16), (unsigned char)(width >> 8), (unsigned char)width,
+                              (unsigned char)(height >> 24), (unsigned char)(height >> 16), (unsigned char)(height >> 8), (unsigned char)height,
+                              (unsigned char)bitDepth, (unsigned char)colorType, 0, 0, 0}; // deflate, adaptive filtering, no interlace
+    
+    WritePngChunk(png.file, "IHDR", ihdr, 13);
+    
+    return true;
+}
+
+
+void WritePngRow(PngStream& png, const unsigned char* row, int length)
+{
+    // each row is sub filtered and deflated into its own IDAT chunk as one fixed huffman block, matching back into the rows before it, so only the deflate window is held in memory
+    png.buffer.clear();
+    
+    if (!png.zlibStarted)
+    {
+        png.buffer.push_back(0x78); // zlib header, deflate with a 32k window
+        png.buffer.push_back(0x01);
+        png.zlibStarted = true;
+    }
+    
+    if (png.window.size() > 2 * PNG_WINDOW_SIZE) // let go of what is out of reach
+    {
+        int drop = png.window.size() - PNG_WINDOW_SIZE;
+        
+        png.window.erase(png.window.begin(), png.window.begin() + drop);
+        png.windowStart += drop;
+    }
+    
+    int rowStart = png.window.size();
+    
+    png.window.push_back(1); // sub filter. each byte is stored as the difference from the same byte of the pixel to its left, so smooth heights repeat
+    
+    for (int i = 0; i < length; i++)
+        png.window.push_back(i < png.pixelSize ? row[i] : (unsigned char)(row[i] - row[i - png.pixelSize]));
+    
+    png.adler = UpdateAdler32(png.adler, png.window.data() + rowStart, length + 1);
+    
+    PutPngBits(png, 2, 3); // not the final block, fixed huffman codes
+    
+    const unsigned char* data = png.window.data();
+    int end = png.window.size();
+    int i = rowStart;
+    
+    while (i < end)
+    {
+        int bestLength = 0;
+        int bestDistance = 0;
+        
+        if (i + 3 <= end)
+        {
+            unsigned int hash = (((data[i] << 16) | (data[i + 1] << 8) | data[i + 2]) * 2654435761u) >> (32 - PNG_HASH_BITS);
+            long long position = png.windowStart + i;
+            long long candidate = png.hashHead[hash];
+            int maxLength = std::min(258, end - i); // matches stop at the end of the row, the next one isnt here yet
+            
+            for (int k = 0; k < PNG_MATCH_CHAIN && candidate >= png.windowStart && position - candidate <= PNG_WINDOW_SIZE; k++)
+            {
+                const unsigned char* match = data + (candidate - png.windowStart);
+                int matchLength = 0;
+                
+                while (matchLength < maxLength && match[matchLength] == data[i + matchLength])
+                    matchLength++;
+                
+                if (matchLength > bestLength)
+                {
+                    bestLength = matchLength;
+                    bestDistance = (int)(position - candidate);
+                    
+                    if (matchLength == maxLength)
+                        break;
+                }
+                
+                candidate = png.hashPrevious[candidate & (PNG_WINDOW_SIZE - 1)];
+            }
+        }
+        
+        if (bestLength >= 3)
+            PutPngMatch(png, bestLength, bestDistance);
+        else
+        {
+            PutPngSymbol(png, data[i]);
+            bestLength = 1;
+        }
+        
+        for (int k = 0; k < bestLength; k++, i++) // every position covered goes in the hash chains, the last two of the row cant be hashed yet
+        {
+            if (i + 3 > end)
+                continue;
+            
+            unsigned int hash = (((data[i] << 16) | (data[i + 1] << 8) | data[i + 2]) * 2654435761u) >> (32 - PNG_HASH_BITS);
+            long long position = png.windowStart + i;
+            
+            png.hashPrevious[position & (PNG_WINDOW_SIZE - 1)] = png.hashHead[hash];
+            png.hashHead[hash] = position;
+        }
+    }
+    
+    PutPngSymbol(png, 256); // end of block. the bits that dont fill a byte go out with the next chunk
+    
+    WritePngChunk(png.file, "IDAT", png.buffer.data(), png.buffer.size());
+}
+
+
+void PutPngBits(PngStream& png, unsigned int bits, int count)
+{
+    png.bitBuffer |= bits << png.bitCount;
+    png.bitCount += count;
+    
+    while (png.bitCount >= 8)
+    {
+        png.buffer.push_back(png.bitBuffer & 0xFF);
+        png.bitBuffer >>= 8;
+        png.bitCount -= 8;
+    }
+}
+
+
+void PutPngCode(PngStream& png, unsigned int code, int length)
+{
+    unsigned int reversed = 0;
+    
+    for (int i = 0; i < length; i++)
+        reversed |= ((code >> i) & 1) << (length - 1 - i);
+    
+    PutPngBits(png, reversed, length);
+}
+
+
+void PutPngSymbol(PngStream& png, int symbol)
+{
+    if (symbol < 144)
+        PutPngCode(png, 0x30 + symbol, 8);
+    else if (symbol < 256)
+        PutPngCode(png, 0x190 + symbol - 144, 9);
+    else if (symbol < 280)
+        PutPngCode(png, symbol - 256, 7);
+    else
+        PutPngCode(png, 0xC0 + symbol - 280, 8);
+}
+
+
+void PutPngMatch(PngStream& png, int length, int distance)
+{
+    static const int lengthBase[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static const int lengthExtra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const int distanceBase[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static const int distanceExtra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    
+    int code = 28;
+    
+    while (lengthBase[code] > length)
+        code--;
+    
+    PutPngSymbol(png, 257 + code);
+    PutPngBits(png, length - lengthBase[code], lengthExtra[code]);
+    
+    code = 29;
+    
+    while (distanceBase[code] > distance)
+        code--;
+    
+    PutPngCode(png, code, 5); // distance codes are all 5 bits in the fixed codes
+    PutPngBits(png, distance - distanceBase[code], distanceExtra[code]);
+}
+
+
+bool EndPngStream(PngStream& png)
+{
+    // an empty final block closes the deflate stream, followed by the adler32 of all the row data
+    png.buffer.clear();
+    
+    PutPngBits(png, 3, 3); // the final block, fixed huffman codes
+    PutPngSymbol(png, 256);
+    
+    if (png.bitCount > 0)
+        png.buffer.push_back(png.bitBuffer & 0xFF);
+    
+    png.buffer.push_back(png.adler >> 24);
+    png.buffer.push_back(png.adler >> 16);
+    png.buffer.push_back(png.adler >> 8);
+    png.buffer.push_back(png.adler);
+    
+    WritePngChunk(png.file, "IDAT", png.buffer.data(), png.buffer.size());
+    WritePngChunk(png.file, "IEND", NULL, 0);
+    
+    bool success = !ferror(png.file);
+    
+    fclose(png.file);
+    png.file = NULL;
+    png.buffer.clear();
+    png.buffer.shrink_to_fit();
+    png.window.clear();
+    png.window.shrink_to_fit();
+    png.hashHead.clear();
+    png.hashHead.shrink_to_fit();
+    png.hashPrevious.clear();
+    png.hashPrevious.shrink_to_fit();
+    
+    return success;
+}
+
+
+bool ExportHeightmap(const char* fileName, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, float maxHeight, float minHeight, HeightmapFormat format, int cropWidth, int cropHeight)
+{
+    int modelsSizeX = (int)models.size();
+    int modelsSizeY = (int)models[0].size();
+    int width = modelVertexWidth * modelsSizeX - (modelsSizeX - 1); // overlapping vertices are only counted once
+    int height = modelVertexHeight * modelsSizeY - (modelsSizeY - 1);
+    
+    if (cropWidth > 0 && cropWidth < width)
+        width = cropWidth;
+    
+    if (cropHeight > 0 && cropHeight < height)
+        height = cropHeight;
+    
+    if (minHeight > 0) // min height never above 0
+        minHeight = 0;
+    
+    float scale = maxHeight - minHeight;
+    
+    bool isPng = format != HeightmapFormat::R16 && format != HeightmapFormat::R32F;
+    int sampleSize; // bytes per pixel
+    
+    if (format == HeightmapFormat::GRAYSCALE)
+        sampleSize = 1;
+    else if (format == HeightmapFormat::SPLIT || format == HeightmapFormat::R32F)
+        sampleSize = 4;
+    else
+        sampleSize = 2;
+    
+    std::vector<unsigned char> row(width * sampleSize); // one row of the image
+    std::vector<float> values(format == HeightmapFormat::SPLIT ? width : 0); // split rows are encoded all at once
+    std::vector<float> strip(modelsSizeX * modelVertexWidth * modelVertexHeight); // heights of the row of models the image row is in
+    int stripZ = -1; // which row of models is in strip
+    
+    PngStream png;
+    FILE* file = NULL;
+    
+    if (isPng)
+    {
+        bool opened;
+        
+        if (format == HeightmapFormat::GRAYSCALE)
+            opened = BeginPngStream(png, fileName, width, height, 8, 0); // 8 bit grayscale
+        else if (format == HeightmapFormat::SPLIT)
+            opened = BeginPngStream(png, fileName, width, height, 8, 6); // 8 bit rgba
+        else
+            opened = BeginPngStream(png, fileName, width, height, 16, 0); // 16 bit grayscale
+        
+        if (!opened)
+            return false;
+    }
+    else
+    {
+        file = fopen(fileName, "wb");
+        
+        if (!file)
+            return false;
+    }
+    
+    for (int z = 0; z < height; z++)
+    {
+        int modelZ = z / (modelVertexHeight - 1); // models share their border vertices
+        
+        if (modelZ > modelsSizeY - 1) // the last row of the map belongs to the last model
+            modelZ = modelsSizeY - 1;
+        
+        if (modelZ != stripZ)
+        {
+            for (int i = 0; i < modelsSizeX; i++)
+                ReadModelHeights(models, i, modelZ, &strip[i * modelVertexWidth * modelVertexHeight], modelVertexWidth, modelVertexHeight);
+            
+            stripZ = modelZ;
+        }
+        
+        int localZ = z - modelZ * (modelVertexHeight - 1);
+        
+        for (int x = 0; x < width; x++)
+        {
+            int modelX = x / (modelVertexWidth - 1);
+            
+            if (modelX > modelsSizeX - 1)
+                modelX = modelsSizeX - 1;
+            
+            int localX = x - modelX * (modelVertexWidth - 1);
+            
+            float vertexHeight = strip[(modelX * modelVertexHeight + localZ) * modelVertexWidth + localX];
+            float value = (vertexHeight - minHeight) / scale; // 0 to 1
+            
+            if (value < 0) value = 0;
+            else if (value > 1) value = 1;
+            
+            unsigned char* sample = &row[x * sampleSize];
+            
+            if (format == HeightmapFormat::GRAYSCALE)
+            {
+                sample[0] = (unsigned char)(value * 255);
+            }
+            else if (format == HeightmapFormat::SPLIT) // use all channels of the png to save height data at much greater resolution
+            {
+                values[x] = value;
+            }
+            else if (format == HeightmapFormat::R32F) // little endian float. the height itself, floats dont need it scaled into a range
+            {
+                unsigned int bits;
+                memcpy(&bits, &vertexHeight, 4);
+                
+                sample[0] = bits;
+                sample[1] = bits >> 8;
+                sample[2] = bits >> 16;
+                sample[3] = bits >> 24;
+            }
+            else
+            {
+                unsigned short pixelValue = (unsigned short)(value * 65535 + 0.5f);
+                
+                if (format == HeightmapFormat::PNG16) // png is big endian
+                {
+                    sample[0] = pixelValue >> 8;
+                    sample[1] = pixelValue & 0xFF;
+                }
+                else // raw r16 is little endian
+                {
+                    sample[0] = pixelValue & 0xFF;
+                    sample[1] = pixelValue >> 8;
+                }
+            }
+        }
+        
+        if (format == HeightmapFormat::SPLIT)
+            EncodeSplitRow(values.data(), width, row.data());
+        
+        if (isPng)
+            WritePngRow(png, row.data(), row.size());
+        else
+            fwrite(row.data(), 1, row.size(), file);
+    }
+    
+    if (isPng)
+        return EndPngStream(png);
+    
+    bool success = !ferror(file);
+    fclose(file);
+    
+    return success;
+}
+
+
+bool WritePng16(const char* fileName, const unsigned short* pixels, int width, int height)
+{
+    std::vector<unsigned char> raw((width * 2 + 1) * height); // filter byte then big endian samples, row by row
+    
+    for (int z = 0; z < height; z++)
+    {
+        unsigned char* row = &raw[z * (width * 2 + 1)];
+        row[0] = 1; // sub filter. each byte is stored as the difference from the same byte of the pixel to its left, which compresses heights much better
+        
+        for (int x = 0; x < width; x++)
+        {
+            unsigned short value = pixels[z * width + x];
+            unsigned short left = x > 0 ? pixels[z * width + x - 1] : 0;
+            
+            row[1 + x * 2] = (value >> 8) - (left >> 8);
+            row[2 + x * 2] = (value & 0xFF) - (left & 0xFF);
+        }
+    }
+    
+    int compressedSize = 0;
+    unsigned char* compressed = CompressData(raw.data(), raw.size(), &compressedSize); // a zlib stream, which is what idat holds
+    
+    if (!compressed)
+        return false;
+    
+    FILE* file = fopen(fileName, "wb");
+    
+    if (!file)
+    {
+        RL_FREE(compressed);
+        return false;
+    }
+    
+    const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    fwrite(signature, 1, 8, file);
+    
+    unsigned char ihdr[13] = {(unsigned char)(width >> 24), (unsigned char)(width >> 16), (unsigned char)(width >> 8), (unsigned char)width,
+                              (unsigned char)(height >> 24), (unsigned char)(height >> 16), (unsigned char)(height >> 8), (unsigned char)height,
+                              16, 0, 0, 0, 0}; // 16 bit grayscale, deflate, adaptive filtering, no interlace
+    
+    WritePngChunk(file, "IHDR", ihdr, 13);
+    WritePngChunk(file, "IDAT", compressed, compressedSize);
+    WritePngChunk(file, "IEND", NULL, 0);
+    
+    RL_FREE(compressed);
+    
+    bool success = !ferror(file);
+    fclose(file);
+    
+    return success;
+}
+
+
+bool ExportTiles(const char* fileName, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, int modelWidth, float maxHeight, float minHeight, int chunkSize, int cropWidth, int cropHeight)
+{
+    int modelsSizeX = (int)models.size();
+    int modelsSizeY = (int)models[0].size();
+    int width = modelVertexWidth * modelsSizeX - (modelsSizeX - 1); // overlapping vertices are only counted once
+    int height = modelVertexHeight * modelsSizeY - (modelsSizeY - 1);
+    
+    if (cropWidth > 0 && cropWidth < width)
+        width = cropWidth;
+    
+    if (cropHeight > 0 && cropHeight < height)
+        height = cropHeight;
+    
+    if (chunkSize <= 0) // one chunk per model
+        chunkSize = modelVertexWidth;
+    
+    if (chunkSize < 2)
+        return false;
+    
+    if (minHeight > 0) // min height never above 0
+        minHeight = 0;
+    
+    float scale = maxHeight - minHeight;
+    
+    // the mip levels need the whole map at once, so it is gathered into one grid. each level replaces the one before it
+    std::vector<float> level(width * height);
+    std::vector<float> heights(modelVertexWidth * modelVertexHeight);
+    
+    for (int i = 0; i < modelsSizeX; i++)
+    {
+        for (int j = 0; j < modelsSizeY; j++)
+        {
+            if (!ReadModelHeights(models, i, j, heights.data(), modelVertexWidth, modelVertexHeight))
+                std::fill(heights.begin(), heights.end(), 0.f);
+            
+            int columns = std::min(modelVertexWidth, width - i * (modelVertexWidth - 1)); // of this model inside the crop
+            
+            for (int z = 0; z < modelVertexHeight && j * (modelVertexHeight - 1) + z < height && columns > 0; z++)
+                memcpy(&level[(j * (modelVertexHeight - 1) + z) * width + i * (modelVertexWidth - 1)], &heights[z * modelVertexWidth], columns * sizeof(float));
+        }
+    }
+    
+    std::string base = fileName; // chunks are named after the manifest, without its extension
+    
+    if (base.size() > 5 && base.compare(base.size() - 5, 5, ".json") == 0)
+        base.erase(base.size() - 5);
+    
+    std::string baseName = GetFileName(base.c_str()); // the manifest points at the chunks relative to itself
+    
+    float spacing = modelWidth / (float)modelVertexWidth; // same spacing GenMeshHeightGrid uses
+    float canvasWidth = (width - 1) * spacing;
+    float canvasHeight = (height - 1) * spacing;
+    
+    char line[512];
+    snprintf(line, sizeof(line), "{\n    \"format\": \"png16\",\n    \"chunkSize\": %d,\n    \"heightMin\": %.9g,\n    \"heightMax\": %.9g,\n    \"levels\": [\n", chunkSize, minHeight, maxHeight);
+    
+    std::string manifest = line;
+    bool success = true;
+    int levelWidth = width;
+    int levelHeight = height;
+    
+    for (int lod = 0; ; lod++)
+    {
+        int stride = chunkSize - 1; // neighbouring chunks share their border vertices
+        int chunksX = std::max(1, (levelWidth - 2 + stride) / stride);
+        int chunksY = std::max(1, (levelHeight - 2 + stride) / stride);
+        float levelSpacing = spacing * (1 << lod);
+        
+        std::vector<TileChunk> chunks(chunksX * chunksY);
+        
+        ParallelFor(chunks.size(), [&](int c)
+        {
+            TileChunk& chunk = chunks[c];
+            int x0 = (c % chunksX) * stride;
+            int z0 = (c / chunksX) * stride;
+            
+            chunk.width = std::min(chunkSize, levelWidth - x0); // chunks on the far edges can be smaller
+            chunk.height = std::min(chunkSize, levelHeight - z0);
+            chunk.minY = FLT_MAX;
+            chunk.maxY = -FLT_MAX;
+            
+            std::vector<unsigned short> pixels(chunk.width * chunk.height);
+            
+            for (int z = 0; z < chunk.height; z++)
+            {
+                for (int x = 0; x < chunk.width; x++)
+                {
+                    float y = level[(z0 + z) * levelWidth + x0 + x];
+                    
+                    chunk.minY = std::min(chunk.minY, y);
+                    chunk.maxY = std::max(chunk.maxY, y);
+                    
+                    float value = (y - minHeight) / scale; // 0 to 1
+                    
+                    if (value < 0) value = 0;
+                    else if (value > 1) value = 1;
+                    
+                    pixels[z * chunk.width + x] = (unsigned short)(value * 65535 + 0.5f);
+                }
+            }
+            
+            std::string chunkName = base + "_" + std::to_string(lod) + "_" + std::to_string(c % chunksX) + "_" + std::to_string(c / chunksX) + ".png";
+            chunk.written = WritePng16(chunkName.c_str(), pixels.data(), chunk.width, chunk.height);
+        });
+        
+        snprintf(line, sizeof(line), "%s        {\n            \"level\": %d,\n            \"width\": %d,\n            \"height\": %d,\n            \"spacing\": %.9g,\n            \"chunks\": [\n", lod > 0 ? ",\n" : "", lod, levelWidth, levelHeight, levelSpacing);
+        manifest += line;
+        
+        for (int c = 0; c < chunks.size(); c++)
+        {
+            const TileChunk& chunk = chunks[c];
+            int chunkX = c % chunksX;
+            int chunkY = c / chunksX;
+            
+            // bounds on the canvas in world units. the last vertex of a level can land past the canvas edge when it was rounded up, so they are clamped
+            float left = chunkX * stride * levelSpacing;
+            float top = chunkY * stride * levelSpacing;
+            float right = std::min(left + (chunk.width - 1) * levelSpacing, canvasWidth);
+            float bottom = std::min(top + (chunk.height - 1) * levelSpacing, canvasHeight);
+            
+            snprintf(line, sizeof(line), "                {\"x\": %d, \"y\": %d, \"file\": \"%s_%d_%d_%d.png\", \"width\": %d, \"height\": %d, \"bounds\": [%.9g, %.9g, %.9g, %.9g], \"minY\": %.9g, \"maxY\": %.9g}%s\n",
+                     chunkX, chunkY, baseName.c_str(), lod, chunkX, chunkY, chunk.width, chunk.height, left, top, right, bottom, chunk.minY, chunk.maxY, c < chunks.size() - 1 ? "," : "");
+            manifest += line;
+            
+            success = success && chunk.written;
+        }
+        
+        manifest += "            ]\n        }";
+        
+        if (chunksX == 1 && chunksY == 1) // the whole map fits in one chunk, nothing coarser is needed
+            break;
+        
+        // next level at half the resolution. each vertex is the 3x3 tent filtered average of the one under it, so vertices shared by chunks still match
+        int nextWidth = levelWidth / 2 + 1;
+        int nextHeight = levelHeight / 2 + 1;
+        std::vector<float> next(nextWidth * nextHeight);
+        
+        ParallelFor(nextHeight, [&](int z)
+        {
+            const float weights[3] = {1, 2, 1};
+            
+            for (int x = 0; x < nextWidth; x++)
+            {
+                float sum = 0;
+                
+                for (int dz = -1; dz <= 1; dz++)
+                {
+                    int sourceZ = std::max(0, std::min(levelHeight - 1, z * 2 + dz));
+                    
+                    for (int dx = -1; dx <= 1; dx++)
+                    {
+                        int sourceX = std::max(0, std::min(levelWidth - 1, x * 2 + dx));
+                        sum += level[sourceZ * levelWidth + sourceX] * weights[dx + 1] * weights[dz + 1];
+                    }
+                }
+                
+                next[z * nextWidth + x] = sum / 16;
+            }
+        });
+        
+        level.swap(next);
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+    
+    manifest += "\n    ]\n}\n";
+    
+    FILE* file = fopen(fileName, "wb"); // manifest last, so it only exists once the chunks it lists do
+    
+    if (!file)
+        return false;
+    
+    fwrite(manifest.data(), 1, manifest.size(), file);
+    
+    success = success && !ferror(file);
+    fclose(file);
+    
+    return success;
+}
+
+
+void ParallelFor(int count, const std::function<void(int)>& body)
+{
+    if (taskPool.queues.empty()) // no pool yet
+    {
+        for (int i = 0; i < count; i++)
+            body(i);
+        
+        return;
+    }
+    
+    int chunkCount = std::min(count, (int)(taskPool.threads.size() + 1) * 4); // a few chunks per thread, so a thread that finishes early can steal the rest
+    TaskGroup group;
+    
+    for (int c = 0; c < chunkCount; c++)
+    {
+        int first = (long long)count * c / chunkCount;
+        int last = (long long)count * (c + 1) / chunkCount;
+        
+        SubmitTask(group, [&body, first, last]()
+        {
+            for (int i = first; i < last; i++)
+                body(i);
+        });
+    }
+    
+    WaitTaskGroup(group);
+}
+
+
+void InitTaskPool(int threadCount)
+{
+    if (threadCount <= 0)
+        threadCount = std::max((int)std::thread::hardware_concurrency() - 1, 0); // the calling thread runs tasks too while it waits
+    
+    taskPool.quit = false;
+    taskPool.queues.resize(std::max(threadCount, 1));
+    taskPool.statsStart = std::chrono::steady_clock::now();
+    
+    for (int i = 0; i < threadCount; i++)
+        taskPool.threads.emplace_back(TaskWorker, i);
+}
+
+
+void ShutdownTaskPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(taskPool.sleepMutex);
+        taskPool.quit = true;
+    }
+    
+    taskPool.wake.notify_all();
+    
+    for (int i = 0; i < taskPool.threads.size(); i++)
+        taskPool.threads[i].join();
+    
+    while (RunPoolTask(-1)) // left over if there were no pool threads
+        ;
+    
+    taskPool.threads.clear();
+    taskPool.queues.clear();
+}
+
+
+void SubmitTask(TaskGroup& group, std::function<void()> run, TaskGroup* after)
+{
+    group.pending++;
+    Task task = { std::move(run), &group };
+    
+    if (after)
+    {
+        std::lock_guard<std::mutex> lock(after->mutex); // FinishTask releases the continuations under the same lock, so this cant miss it
+        
+        if (after->pending > 0)
+        {
+            after->continuations.push_back(std::move(task));
+            return;
+        }
+    }
+    
+    PushTask(std::move(task));
+}
+
+
+void WaitTaskGroup(TaskGroup& group)
+{
+    while (group.pending > 0)
+    {
+        if (!RunPoolTask(taskQueueIndex)) // the rest are running on other threads
+            std::this_thread::yield();
+    }
+    
+    std::lock_guard<std::mutex> lock(group.mutex); // the thread that finished the last task may still be releasing continuations, wait for it before group goes away
+}
+
+
+void PushTask(Task task)
+{
+    int index = taskQueueIndex >= 0 ? taskQueueIndex : taskPool.nextQueue++ % taskPool.queues.size();
+    
+    {
+        std::lock_guard<std::mutex> lock(taskPool.queues[index].mutex);
+        taskPool.queues[index].tasks.push_back(std::move(task));
+    }
+    
+    taskPool.queued++;
+    
+    {
+        std::lock_guard<std::mutex> lock(taskPool.sleepMutex); // so a worker between checking queued and sleeping doesnt miss the wake
+    }
+    
+    taskPool.wake.notify_one();
+}
+
+
+bool RunPoolTask(int queueIndex)
+{
+    Task task;
+    bool found = false;
+    bool stolen = false;
+    
+    if (queueIndex >= 0)
+    {
+        TaskQueue& queue = taskPool.queues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            found = true;
+        }
+    }
+    
+    for (int k = 1; k <= taskPool.queues.size() && !found; k++) // steal, starting after its own queue so the thieves spread out
+    {
+        TaskQueue& queue = taskPool.queues[(queueIndex + k + taskPool.queues.size()) % taskPool.queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        
+        if (!queue.tasks.empty())
+        {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            found = true;
+            stolen = queueIndex >= 0;
+        }
+    }
+    
+    if (!found)
+        return false;
+    
+    taskPool.queued--;
+    
+    auto start = std::chrono::steady_clock::now();
+    
+    task.run();
+    
+    taskPool.busyTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    taskPool.tasksRun++;
+    
+    if (stolen)
+        taskPool.tasksStolen++;
+    
+    FinishTask(task.group);
+    
+    return true;
+}
+
+
+void FinishTask(TaskGroup* group)
+{
+    std::vector<Task> continuations;
+    
+    {
+        std::lock_guard<std::mutex> lock(group->mutex);
+        
+        if (--group->pending == 0)
+            continuations.swap(group->continuations);
+    }
+    
+    for (int i = 0; i < continuations.size(); i++) // group may be gone by now, only its continuations are left
+        PushTask(std::move(continuations[i]));
+}
+
+
+void TaskWorker(int queueIndex)
+{
+    taskQueueIndex = queueIndex;
+    
+    while (true)
+    {
+        if (RunPoolTask(queueIndex))
+            continue;
+        
+        std::unique_lock<std::mutex> lock(taskPool.sleepMutex);
+        taskPool.wake.wait(lock, []() { return taskPool.quit || taskPool.queued > 0; });
+        
+        if (taskPool.quit && taskPool.queued == 0)
+            return;
+    }
+}
+
+
+TaskPoolStats TakeTaskPoolStats()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double> elapsed = now - taskPool.statsStart;
+    taskPool.statsStart = now;
+    
+    TaskPoolStats stats;
+    stats.threads = taskPool.threads.size() + 1;
+    stats.busy = elapsed.count() > 0 ? (float)(taskPool.busyTime.exchange(0) / 1e9 / (elapsed.count() * stats.threads)) : 0;
+    stats.tasks = taskPool.tasksRun.exchange(0);
+    stats.stolen = taskPool.tasksStolen.exchange(0);
+    
+    return stats;
+}
+
+
+int RunBatch(int argc, char** argv)
+{
+    std::vector<std::string> tokens;
+    int threadCount = TASK_POOL_THREADS;
+    
+    for (int i = 0; i < argc; i++)
+    {
+        if (i == 0 && strcmp(argv[i], "--batch") == 0)
+            continue;
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) // pool threads besides the main thread
+            threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) // a script. its words are read in place of the argument, # starts a comment
+        {
+            FILE* file = fopen(argv[++i], "rb");
+            
+            if (!file)
+            {
+                printf("couldnt open script %s\n", argv[i]);
+                return 1;
+            }
+            
+            std::string word;
+            bool comment = false;
+            int c;
+            
+            while ((c = fgetc(file)) != EOF)
+            {
+                if (c == '#')
+                    comment = true;
+                else if (c == '\n')
+                    comment = false;
+                
+                if (comment || isspace(c))
+                {
+                    if (!word.empty())
+                        tokens.push_back(word);
+                    
+                    word.clear();
+                }
+                else
+                    word += (char)c;
+            }
+            
+            if (!word.empty())
+                tokens.push_back(word);
+            
+            fclose(file);
+        }
+        else
+            tokens.push_back(argv[i]);
+    }
+    
+    std::vector<std::vector<std::string>> steps;
+    
+    for (int i = 0; i < tokens.size(); i++) // every operation name starts a step, the words after it are its arguments
+    {
+        if (BatchOperationIndex(tokens[i]) >= 0)
+            steps.emplace_back();
+        else if (!steps.empty() && steps.back().size() > batchMaxArguments[BatchOperationIndex(steps.back()[0])]) // past the last argument the step can take
+        {
+            printf("unknown operation %s\n", tokens[i].c_str());
+            return 1;
+        }
+        else if (steps.empty())
+        {
+            if (tokens[i] != "-h" && tokens[i] != "--help")
+                printf("unknown operation %s\n", tokens[i].c_str());
+            
+            printf("usage: pangea [--batch] [-j threads] [-f script] [operation arguments...]\n");
+            printf("  import <file> <format> [height]           read a heightmap, pure white at height. r32f takes no height, its heights are used as they are\n");
+            printf("  resolution <vertices>                     vertices along each side of the models exports are built from (default %i)\n", TILE_RESOLUTION_DEFAULT);
+            printf("  resize <width> <height>                   resample the map, in vertices\n");
+            printf("  smooth [passes]                           move each vertex to the average of its neighbors\n");
+            printf("  stamp <x> <z> <radius> <angle> [inner] [offset]  stamp centered on vertex x, z. radius and inner in vertices\n");
+            printf("  replay <journal>                          apply an edit journal recorded in the editor, at its resolution. starts flat if nothing was imported\n");
+            printf("  preview <mode>                            color every model as the editor previews it, through the upload ring with the gl calls stubbed out. mode is grayscale slope or rainbow\n");
+            printf("  export <file> <format> [height]           height is the pure white height, or the triangle budget for obj and glb\n");
+            printf("  selftest                                  check the split png row codec against the bitset one it replaced\n");
+            printf("  bench [pixels]                            time the split png row codec against the bitset one (default %i pixels)\n", BATCH_BENCH_PIXELS);
+            printf("formats: grayscale split png16 r16 r32f obj glb tiles\n");
+            return tokens[i] == "-h" || tokens[i] == "--help" ? 0 : 1;
+        }
+        
+        steps.back().push_back(tokens[i]);
+    }
+    
+    BatchCanvas canvas;
+    canvas.tileResolution = TILE_RESOLUTION_DEFAULT;
+    
+    InitTaskPool(threadCount);
+    InitUploadRing(false); // no context, so uploads are only counted
+    
+    auto batchStart = std::chrono::steady_clock::now();
+    
+    for (int i = 0; i < steps.size(); i++)
+    {
+        auto stepStart = std::chrono::steady_clock::now();
+        
+        if (!RunBatchStep(canvas, steps[i]))
+        {
+            ShutdownTaskPool();
+            return 1;
+        }
+        
+        std::chrono::duration<double, std::milli> stepTime = std::chrono::steady_clock::now() - stepStart;
+        printf("%-12s %10.1f ms\n", steps[i][0].c_str(), stepTime.count());
+    }
+    
+    std::chrono::duration<double, std::milli> batchTime = std::chrono::steady_clock::now() - batchStart;
+    printf("%-12s %10.1f ms on %i threads\n", "total", batchTime.count(), (int)taskPool.threads.size() + 1);
+    
+    ShutdownTaskPool();
+    
+    return 0;
+}
+
+
+bool RunBatchStep(BatchCanvas& canvas, const std::vector<std::string>& step)
+{
+    const std::string& name = step[0];
+    int argumentCount = step.size() - 1;
+    
+    if (name != "import" && name != "resolution" && name != "replay" && name != "selftest" && name != "bench" && canvas.heights.empty())
+    {
+        printf("%s: nothing has been imported\n", name.c_str());
+        return false;
+    }
+    
+    if (name == "import")
+    {
+        HeightmapFormat format;
+        
+        if (argumentCount < 2 || !ParseHeightmapFormat(step[2].c_str(), format) || argumentCount != (format == HeightmapFormat::R32F ? 2 : 3)) // r32f files hold the heights themselves, there is nothing to scale
+        {
+            printf("import: expected <file> <format> <height>, or <file> r32f\n");
+            return false;
+        }
+        
+        int width = 0;
+        int height = 0;
+        float* heights = LoadHeightGrid(step[1].c_str(), format, width, height);
+        
+        if (!heights)
+        {
+            printf("import: couldnt read %s\n", step[1].c_str());
+            return false;
+        }
+        
+        float heightRef = format == HeightmapFormat::R32F ? 1 : atof(step[3].c_str());
+        
+        canvas.heights.resize(width * height);
+        canvas.width = width;
+        canvas.height = height;
+        
+        ParallelFor(height, [&](int z) // scale to the pure white height, as the editor does on import. r32f is copied as it is
+        {
+            for (int x = 0; x < width; x++)
+                canvas.heights[z * width + x] = heights[z * width + x] * heightRef;
+        });
+        
+        RL_FREE(heights);
+    }
+    else if (name == "resolution")
+    {
+        int resolution = argumentCount == 1 ? atoi(step[1].c_str()) : 0;
+        
+        if (resolution < 2 || resolution > TILE_RESOLUTION_MAX)
+        {
+            printf("resolution: expected <vertices> from 2 to %i\n", TILE_RESOLUTION_MAX);
+            return false;
+        }
+        
+        canvas.tileResolution = resolution;
+    }
+    else if (name == "resize")
+    {
+        int width = argumentCount == 2 ? atoi(step[1].c_str()) : 0;
+        int height = argumentCount == 2 ? atoi(step[2].c_str()) : 0;
+        
+        if (width < 2 || height < 2)
+        {
+            printf("resize: expected <width> <height> of at least 2\n");
+            return false;
+        }
+        
+        std::vector<float> resized(width * height);
+        
+        ParallelFor(height, [&](int z) // bilinear, corners stay on corners
+        {
+            float sourceZ = z * (canvas.height - 1) / (float)(height - 1);
+            int z0 = std::min((int)sourceZ, canvas.height - 1);
+            int z1 = std::min(z0 + 1, canvas.height - 1);
+            float fz = sourceZ - z0;
+            
+            for (int x = 0; x < width; x++)
+            {
+                float sourceX = x * (canvas.width - 1) / (float)(width - 1);
+                int x0 = std::min((int)sourceX, canvas.width - 1);
+                int x1 = std::min(x0 + 1, canvas.width - 1);
+                float fx = sourceX - x0;
+                
+                float top = canvas.heights[z0 * canvas.width + x0] * (1 - fx) + canvas.heights[z0 * canvas.width + x1] * fx;
+                float bottom = canvas.heights[z1 * canvas.width + x0] * (1 - fx) + canvas.heights[z1 * canvas.width + x1] * fx;
+                
+                resized[z * width + x] = top * (1 - fz) + bottom * fz;
+            }
+        });
+        
+        canvas.heights.swap(resized);
+        canvas.width = width;
+        canvas.height = height;
+    }
+    else if (name == "smooth")
+    {
+        int passes = argumentCount >= 1 ? atoi(step[1].c_str()) : 1;
+        
+        if (argumentCount > 1 || passes < 1)
+        {
+            printf("smooth: expected [passes] of at least 1\n");
+            return false;
+        }
+        
+        std::vector<float> smoothed(canvas.heights.size());
+        
+        for (int pass = 0; pass < passes; pass++)
+        {
+            ParallelFor(canvas.height, [&](int z) // the rule Smooth uses, each vertex moves to the average of the neighbors on either side of it
+            {
+                for (int x = 0; x < canvas.width; x++)
+                {
+                    float sum = 0;
+                    int count = 0;
+                    
+                    if (x > 0) { sum += canvas.heights[z * canvas.width + x - 1]; count++; }
+                    if (x < canvas.width - 1) { sum += canvas.heights[z * canvas.width + x + 1]; count++; }
+                    if (z > 0) { sum += canvas.heights[(z - 1) * canvas.width + x]; count++; }
+                    if (z < canvas.height - 1) { sum += canvas.heights[(z + 1) * canvas.width + x]; count++; }
+                    
+                    smoothed[z * canvas.width + x] = sum / count;
+                }
+            });
+            
+            canvas.heights.swap(smoothed);
+        }
+    }
+    else if (name == "stamp")
+    {
+        if (argumentCount < 4 || argumentCount > 6)
+        {
+            printf("stamp: expected <x> <z> <radius> <angle> [inner] [offset]\n");
+            return false;
+        }
+        
+        float centerX = atof(step[1].c_str());
+        float centerZ = atof(step[2].c_str());
+        float radius = atof(step[3].c_str());
+        float angle = atof(step[4].c_str());
+        float inner = argumentCount >= 5 ? atof(step[5].c_str()) : 0;
+        float spacing = MODEL_WORLD_SIZE / (float)canvas.tileResolution; // world distance between two vertices, so the angle gives the slopes it does in the editor
+        
+        StampParams stamp = { 0 }; // the same settings the editor fills in from its stamp panel
+        stamp.influenceRadius = (radius + inner) * spacing;
+        stamp.innerRadius = inner * spacing;
+        stamp.slopeRatio = sinf(angle*DEG2RAD)/sinf((180 - (90 + angle))*DEG2RAD);
+        stamp.heightCap = radius * spacing * stamp.slopeRatio;
+        stamp.offset = argumentCount >= 6 ? atof(step[6].c_str()) : 0;
+        
+        int firstRow = std::max(0, (int)floor(centerZ - radius - inner));
+        int lastRow = std::min(canvas.height - 1, (int)ceil(centerZ + radius + inner));
+        int firstColumn = std::max(0, (int)floor(centerX - radius - inner));
+        int lastColumn = std::min(canvas.width - 1, (int)ceil(centerX + radius + inner));
+        
+        if (firstRow <= lastRow)
+        {
+            ParallelFor(lastRow - firstRow + 1, [&](int row)
+            {
+                int z = firstRow + row;
+                
+                for (int x = firstColumn; x <= lastColumn; x++)
+                {
+                    float dist = sqrtf((x - centerX) * (x - centerX) + (z - centerZ) * (z - centerZ)) * spacing;
+                    
+                    if (dist <= stamp.influenceRadius)
+                        canvas.heights[z * canvas.width + x] = StampVertexHeight(dist, canvas.heights[z * canvas.width + x], stamp);
+                }
+            });
+        }
+    }
+    else if (name == "preview")
+    {
+        HeightMapMode mode;
+        
+        if (argumentCount != 1 || !ParseHeightMapMode(step[1].c_str(), mode))
+        {
+            printf("preview: expected <grayscale|slope|rainbow>\n");
+            return false;
+        }
+        
+        std::vector<std::vector<Model>> models;
+        BuildBatchModels(canvas, models);
+        
+        std::vector<const Model*> tiles;
+        std::vector<Texture2D> textures;
+        
+        for (int i = 0; i < models.size(); i++)
+        {
+            for (int j = 0; j < models[i].size(); j++)
+            {
+                tiles.push_back(&models[i][j]);
+                textures.push_back((Texture2D){ 0, canvas.tileResolution - 1, canvas.tileResolution - 1, 1, UNCOMPRESSED_R8G8B8A8 }); // nothing to upload to, it is only the size
+            }
+        }
+        
+        float highestY = -FLT_MAX;
+        float lowestY = FLT_MAX;
+        
+        ColorTiles(tiles, textures, canvas.tileResolution, canvas.tileResolution, highestY, lowestY, mode);
+        
+        UploadStats stats = AdvanceUploadRing();
+        printf("preview: %i uploads, %i kb, %i staging stalls\n", stats.uploads, (int)(stats.bytes / 1024), stats.stalls);
+        
+        UnloadBatchModels(models);
+    }
+    else if (name == "replay")
+    {
+        if (argumentCount != 1)
+        {
+            printf("replay: expected <journal>\n");
+            return false;
+        }
+        
+        JournalHeader header;
+        std::vector<JournalCommand> commands;
+        
+        if (!LoadJournal(step[1].c_str(), header, commands))
+        {
+            printf("replay: couldnt read journal %s\n", step[1].c_str());
+            return false;
+        }
+        
+        if (header.modelVertexWidth != header.modelVertexHeight) // batch canvases only have square models
+        {
+            printf("replay: the journal was recorded on %ix%i models, a batch can only replay square ones\n", header.modelVertexWidth, header.modelVertexHeight);
+            return false;
+        }
+        
+        int resolution = header.modelVertexWidth; // edits land on the same vertices they did in the editor
+        
+        if (canvas.heights.empty()) // nothing imported, so start from a flat canvas the size of the one it was recorded on
+        {
+            canvas.width = header.canvasWidth * (resolution - 1) + 1;
+            canvas.height = header.canvasHeight * (resolution - 1) + 1;
+            canvas.heights.assign(canvas.width * canvas.height, 0);
+        }
+        
+        canvas.tileResolution = resolution;
+        
+        std::vector<std::vector<Model>> models;
+        BuildBatchModels(canvas, models);
+        
+        if (models.size() != header.canvasWidth || models[0].size() != header.canvasHeight)
+        {
+            printf("replay: the journal was recorded on a %ix%i canvas, this one is %ix%i\n", header.canvasWidth, header.canvasHeight, (int)models.size(), (int)models[0].size());
+            UnloadBatchModels(models);
+            return false;
+        }
+        
+        if (header.checksum != CanvasChecksum(models, resolution, resolution))
+        {
+            printf("replay: the journal was started on a canvas with different heights. import the map it was started on, an r32f export of it keeps them exact\n");
+            UnloadBatchModels(models);
+            return false;
+        }
+        
+        std::vector<VertexState> vertexSelection;
+        std::vector<HistoryStep> history;
+        int stepIndex = 0;
+        
+        int applied = ReplayJournal(commands, models, vertexSelection, history, stepIndex, header.maxSteps, resolution, resolution, MODEL_WORLD_SIZE, MODEL_WORLD_SIZE);
+        
+        std::vector<float> heights(resolution * resolution);
+        
+        for (int i = 0; i < models.size(); i++) // back into the height grid, leaving out the part of the last models past the edge of the map
+        {
+            for (int j = 0; j < models[i].size(); j++)
+            {
+                GetModelHeights(models[i][j], heights.data(), resolution, resolution);
+                
+                for (int z = 0; z < resolution && j * (resolution - 1) + z < canvas.height; z++)
+                {
+                    for (int x = 0; x < resolution && i * (resolution - 1) + x < canvas.width; x++)
+                        canvas.heights[(j * (resolution - 1) + z) * canvas.width + i * (resolution - 1) + x] = heights[z * resolution + x];
+                }
+            }
+        }
+        
+        UnloadBatchModels(models);
+        
+        printf("replay: %i of %i commands did something\n", applied, (int)commands.size());
+    }
+    else if (name == "selftest")
+    {
+        if (!TestSplitRows())
+            return false;
+    }
+    else if (name == "bench")
+    {
+        int count = argumentCount == 1 ? atoi(step[1].c_str()) : BATCH_BENCH_PIXELS;
+        
+        if (count <= 0)
+        {
+            printf("bench: expected [pixels]\n");
+            return false;
+        }
+        
+        BenchSplitRows(count);
+    }
+    else if (name == "export")
+    {
+        HeightmapFormat format;
+        
+        if (argumentCount < 2 || argumentCount > 3 || !ParseHeightmapFormat(step[2].c_str(), format))
+        {
+            printf("export: expected <file> <format> [height]\n");
+            return false;
+        }
+        
+        float lowestY = FLT_MAX;
+        float highestY = -FLT_MAX;
+        
+        for (int i = 0; i < canvas.heights.size(); i++)
+        {
+            lowestY = std::min(lowestY, canvas.heights[i]);
+            highestY = std::max(highestY, canvas.heights[i]);
+        }
+        
+        float maxHeight = argumentCount == 3 ? atof(step[3].c_str()) : highestY;
+        int resolution = canvas.tileResolution;
+        
+        std::vector<std::vector<Model>> models;
+        BuildBatchModels(canvas, models);
+        
+        bool written;
+        
+        // the models are padded out flat past the edge of the map. images are cropped back to it, meshes are made of whole models so they keep the padding
+        if (format == HeightmapFormat::OBJ || format == HeightmapFormat::GLB)
+        {
+            if ((canvas.width - 1) % (resolution - 1) != 0 || (canvas.height - 1) % (resolution - 1) != 0)
+                printf("export: %ix%i isnt a whole number of %i vertex models, the mesh is padded flat to %ix%i\n", canvas.width, canvas.height, resolution, (int)models.size() * (resolution - 1) + 1, (int)models[0].size() * (resolution - 1) + 1);
+            
+            written = ExportMesh(step[1].c_str(), models, std::vector<Vector2>(), resolution, resolution, MODEL_WORLD_SIZE, argumentCount == 3 ? atoi(step[3].c_str()) : MESH_EXPORT_TRIANGLE_BUDGET, 0, format);
+        }
+        else if (format == HeightmapFormat::TILES)
+            written = ExportTiles(step[1].c_str(), models, resolution, resolution, MODEL_WORLD_SIZE, maxHeight, lowestY, TILE_EXPORT_CHUNK_SIZE, canvas.width, canvas.height);
+        else
+            written = ExportHeightmap(step[1].c_str(), models, resolution, resolution, maxHeight, lowestY, format, canvas.width, canvas.height);
+        
+        UnloadBatchModels(models);
+        
+        if (!written)
+        {
+            printf("export: couldnt write %s\n", step[1].c_str());
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+
+bool IsBatchArgument(const char* argument)
+{
+    const char* options[] = { "--batch", "-j", "-f", "-h", "--help" };
+    
+    for (int i = 0; i < sizeof(options) / sizeof(options[0]); i++)
+    {
+        if (strcmp(argument, options[i]) == 0)
+            return true;
+    }
+    
+    return BatchOperationIndex(argument) >= 0;
+}
+
+
+int BatchOperationIndex(const std::string& name)
+{
+    for (int i = 0; i < sizeof(batchOperations) / sizeof(batchOperations[0]); i++)
+    {
+        if (name == batchOperations[i])
+            return i;
+    }
+    
+    return -1;
+}
+
+
+bool ParseHeightMapMode(const char* name, HeightMapMode& mode)
+{
+    const char* names[] = { "grayscale", "slope", "rainbow" };
+    const HeightMapMode modes[] = { HeightMapMode::GRAYSCALE, HeightMapMode::SLOPE, HeightMapMode::RAINBOW };
+    
+    for (int i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            mode = modes[i];
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+
+bool ParseHeightmapFormat(const char* name, HeightmapFormat& format)
+{
+    const char* names[] = { "grayscale", "split", "png16", "r16", "r32f", "obj", "glb", "tiles" };
+    const HeightmapFormat formats[] = { HeightmapFormat::GRAYSCALE, HeightmapFormat::SPLIT, HeightmapFormat::PNG16, HeightmapFormat::R16, HeightmapFormat::R32F, HeightmapFormat::OBJ, HeightmapFormat::GLB, HeightmapFormat::TILES };
+    
+    for (int i = 0; i < sizeof(names) / sizeof(names[0]); i++)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            format = formats[i];
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+
+void BuildBatchModels(const BatchCanvas& canvas, std::vector<std::vector<Model>>& models)
+{
+    int resolution = canvas.tileResolution;
+    
+    // rounded up like an import in the editor. the part of the last models past the edge of the map is flat at 0
+    int canvasWidth = canvas.width <= resolution ? 1 : ceil((float)(canvas.width - resolution) / (float)(resolution - 1) + 1);
+    int canvasHeight = canvas.height <= resolution ? 1 : ceil((float)(canvas.height - resolution) / (float)(resolution - 1) + 1);
+    
+    float realModelWidth = MODEL_WORLD_SIZE - (1 / (float)resolution) * MODEL_WORLD_SIZE; // model width minus the width of one polygon
+    
+    models.assign(canvasWidth, std::vector<Model>(canvasHeight));
+    
+    ParallelFor(canvasWidth * canvasHeight, [&](int k)
+    {
+        int i = k / canvasHeight;
+        int j = k % canvasHeight;
+        
+        Model model = { 0 }; // no materials, nothing here is drawn
+        model.transform = MatrixIdentity();
+        model.meshCount = 1;
+        model.meshes = (Mesh*)RL_CALLOC(1, sizeof(Mesh));
+        model.meshes[0] = GenMeshHeightGrid(canvas.heights.data(), canvas.width, canvas.height, i * (resolution - 1), j * (resolution - 1), resolution, resolution, (Vector3){ MODEL_WORLD_SIZE, 1, MODEL_WORLD_SIZE }, Vector2{i * realModelWidth, j * realModelWidth}, false);
+        
+        models[i][j] = model;
+    });
+}
+
+
+void UnloadBatchModels(std::vector<std::vector<Model>>& models)
+{
+    for (int i = 0; i < models.size(); i++)
+    {
+        for (int j = 0; j < models[i].size(); j++)
+        {
+            UnloadMesh(models[i][j].meshes[0]); // never uploaded, so this only frees it
+            RL_FREE(models[i][j].meshes);
+        }
+    }
+    
+    models.clear();
+}
+
+
+bool TestSplitRows()
+{
+    unsigned int seed = 1; // the same rows every run
+    
+    auto random = [&seed]() -> unsigned int
+    {
+        seed = seed * 1664525 + 1013904223;
+        return seed;
+    };
+    
+    // out of range and edge values, each bit of the height on its own, then a long random row so the whole row loops are covered
+    std::vector<float> values = { 0, 1, 0.5f, -1, 2, -0.f, FLT_MIN, 1 / 2147483647.f, 1 - FLT_EPSILON };
+    
+    for (int bit = 0; bit < 31; bit++)
+        values.push_back((1u << bit) / 2147483647.f);
+    
+    for (int i = 0; i < 4096; i++)
+        values.push_back((random() >> 8) / 16777215.f);
+    
+    int count = values.size();
+    std::vector<unsigned char> pixels(count * 4);
+    std::vector<float> decoded(count);
+    int failures = 0;
+    
+    EncodeSplitRow(values.data(), count, pixels.data());
+    
+    for (int i = 0; i < count; i++) // the same bytes the export wrote before, laid out by the reference
+    {
+        float value = values[i] < 0 ? 0 : (values[i] > 1 ? 1 : values[i]);
+        Color reference = HeightToPixel((unsigned int)(value * 2147483647));
+        const unsigned char* pixel = &pixels[i * 4];
+        
+        if (pixel[0] != reference.r || pixel[1] != reference.g || pixel[2] != reference.b || pixel[3] != reference.a)
+        {
+            if (failures++ < 8)
+                printf("selftest: %.9g encodes to %02x%02x%02x%02x, the reference to %02x%02x%02x%02x\n", values[i], pixel[0], pixel[1], pixel[2], pixel[3], reference.r, reference.g, reference.b, reference.a);
+        }
+    }
+    
+    DecodeSplitRow(pixels.data(), count, decoded.data());
+    
+    for (int i = 0; i < count; i++) // back to within float precision of what went in
+    {
+        float value = values[i] < 0 ? 0 : (values[i] > 1 ? 1 : values[i]);
+        
+        if (fabsf(decoded[i] - value) > 0.000001f)
+        {
+            if (failures++ < 8)
+                printf("selftest: %.9g comes back as %.9g\n", value, decoded[i]);
+        }
+    }
+    
+    for (int i = 0; i < count * 4; i++) // any pixel at all, including ones the encoder never writes with the top bit of alpha set
+        pixels[i] = random() >> 24;
+    
+    DecodeSplitRow(pixels.data(), count, decoded.data());
+    
+    for (int i = 0; i < count; i++)
+    {
+        const unsigned char* pixel = &pixels[i * 4];
+        float reference = PixelToHeight((Color){ pixel[0], pixel[1], pixel[2], pixel[3] }) / 2147483647.f;
+        
+        if (decoded[i] != reference)
+        {
+            if (failures++ < 8)
+                printf("selftest: %02x%02x%02x%02x decodes to %.9g, the reference to %.9g\n", pixel[0], pixel[1], pixel[2], pixel[3], decoded[i], reference);
+        }
+    }
+    
+    if (failures > 0)
+    {
+        printf("selftest: split rows, %i mismatches\n", failures);
+        return false;
+    }
+    
+    printf("selftest: split rows, %i values and %i pixels match the bitset reference\n", count, count);
+    
+    return true;
+}
+
+
+void BenchSplitRows(int count)
+{
+    std::vector<float> values(count);
+    std::vector<unsigned char> pixels(count * 4);
+    std::vector<unsigned char> referencePixels(count * 4);
+    std::vector<float> decoded(count);
+    std::vector<float> referenceDecoded(count);
+    
+    for (int i = 0; i < count; i++)
+        values[i] = (i * 2654435761u >> 8) / 16777215.f; // spread over 0 to 1 without a pattern the branch predictor could learn
+    
+    auto time = [](const std::function<void()>& run) -> double // milliseconds
+    {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        
+        return elapsed.count();
+    };
+    
+    double encodeTime = time([&]{ EncodeSplitRow(values.data(), count, pixels.data()); });
+    
+    double referenceEncodeTime = time([&]
+    {
+        for (int i = 0; i < count; i++)
+        {
+            float value = values[i] < 0 ? 0 : (values[i] > 1 ? 1 : values[i]);
+            Color pixel = HeightToPixel((unsigned int)(value * 2147483647));
+            
+            referencePixels[i * 4] = pixel.r;
+            referencePixels[i * 4 + 1] = pixel.g;
+            referencePixels[i * 4 + 2] = pixel.b;
+            referencePixels[i * 4 + 3] = pixel.a;
+        }
+    });
+    
+    double decodeTime = time([&]{ DecodeSplitRow(pixels.data(), count, decoded.data()); });
+    
+    double referenceDecodeTime = time([&]
+    {
+        for (int i = 0; i < count; i++)
+            referenceDecoded[i] = PixelToHeight((Color){ referencePixels[i * 4], referencePixels[i * 4 + 1], referencePixels[i * 4 + 2], referencePixels[i * 4 + 3] }) / 2147483647.f;
+    });
+    
+    bool same = pixels == referencePixels && decoded == referenceDecoded; // also keeps the compiler from dropping any of the loops
+    
+    printf("bench: split rows, %i pixels%s\n", count, same ? "" : ", DIFFERENT from the reference");
+    printf("  encode %10.2f ms, bitset %10.2f ms, %.1fx\n", encodeTime, referenceEncodeTime, referenceEncodeTime / std::max(encodeTime, 0.001));
+    printf("  decode %10.2f ms, bitset %10.2f ms, %.1fx\n", decodeTime, referenceDecodeTime, referenceDecodeTime / std::max(decodeTime, 0.001));
+}
+
+
+void FindDabSelection(const JournalCommand& dab, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, int modelWidth, ModelSelection& editSelection, FrameVector<VertexState>& vertexIndices)
+{
+    int canvasWidth = models.size();
+    int canvasHeight = models.empty() ? 0 : models[0].size();
+    
+    float realModelWidth = modelWidth - (1 / (float)modelVertexWidth) * modelWidth; // modelWidth minus the width of one polygon
+    
+    Vector2 modelCoords; // the model under the dab
+    modelCoords.x = std::min(std::max((int)(dab.position.x / realModelWidth), 0), canvasWidth - 1); // convert to int to truncate decimal
+    modelCoords.y = std::min(std::max((int)(dab.position.z / realModelWidth), 0), canvasHeight - 1);
+    
+    FindModelSelection(editSelection, canvasWidth, canvasHeight, modelWidth, modelVertexWidth, modelCoords, dab.modelRadius);
+    SetExSelection(editSelection, canvasWidth, canvasHeight); // smooth reads the models around the selection too
+    
+    RequireModels(editSelection.expandedSelection); // everything the brush can touch
+    
+    RayHitInfo hit = { 0 };
+    hit.hit = true;
+    hit.position = dab.position;
+    
+    vertexIndices = FindVertexSelection(models, editSelection, hit, dab.vertexRadius, modelVertexWidth, modelVertexHeight);
+}
+
+
+bool ApplyJournalCommand(const JournalCommand& command, std::vector<std::vector<Model>>& models, std::vector<VertexState>& vertexSelection, std::vector<HistoryStep>& history, int& stepIndex, int maxSteps, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, const ModelSelection& editSelection, const FrameVector<VertexState>& vertexIndices)
+{
+    int canvasWidth = models.size();
+    int canvasHeight = models.empty() ? 0 : models[0].size();
+    
+    switch (command.type)
+    {
+        case JournalCommandType::DAB:
+        {
+            BrushTool brush = (BrushTool)command.brush;
+            
+            if (brush == BrushTool::SELECT)
+            {
+                if (command.flags & JOURNAL_INVERT) // if left ctrl was down, do the deselect
+                {
+                    for (int i = 0; i < vertexIndices.size(); i++)
+                    {
+                        for (int j = 0; j < vertexSelection.size(); j++)
+                        {
+                            if(vertexIndices[i] == vertexSelection[j])
+                            {
+                                vertexSelection.erase(vertexSelection.begin() + j);
+                                break;
+                            }
+                        }
+                    }   
+                }
+                else
+                {
+                    int selectionStep = vertexSelection.empty() ? 0 : vertexSelection[vertexSelection.size() - 1].y; // y is used here to represent when a vertex was selected
+                    
+                    for (int i = 0; i < vertexIndices.size(); i++) // TODO sort selection, with timer
+                    {
+                        bool add = true;
+                        
+                        for (int j = 0; j < vertexSelection.size(); j++)
+                        {
+                            if(vertexIndices[i] == vertexSelection[j])
+                            {
+                                add = false;
+                                break;
+                            }
+                        }
+                        
+                        if (add) // adding to vector seems to have a big performance cost at larger sizes
+                        {
+                            VertexState temp;
+                            temp.coords = vertexIndices[i].coords;
+                            temp.index = vertexIndices[i].index;
+                            temp.y = selectionStep + 1;
+                            vertexSelection.push_back(temp);
+                        }
+                    }
+                }
+                
+                return true;
+            }
+            
+            if ((command.flags & JOURNAL_STROKE_START) || stepIndex == 0) // update the history before editing if this is the first tick of the operation
+                NewHistoryStep(history, models, editSelection.selection, stepIndex, maxSteps);
+            else
+                ExtendHistoryStep(history[stepIndex - 1], models, editSelection); // does nothing if the models were already recorded
+            
+            FrameVector<VertexState> unselected; // vertexIndices less the selected vertices, when the selection mask is on
+            
+            if (command.flags & JOURNAL_MASK)
+            {
+                unselected.reserve(vertexIndices.size());
+                
+                for (int i = 0; i < vertexIndices.size(); ++i) // TODO change to a better search once vertexSelection is sorted
+                {
+                    bool selected = false;
+                    
+                    for (int j = 0; j < vertexSelection.size(); j++)
+                    {
+                        if (vertexIndices[i] == vertexSelection[j])
+                        {
+                            selected = true;
+                            break;
+                        }
+                    }
+                    
+                    if (!selected)
+                        unselected.push_back(vertexIndices[i]);
+                }
+            }
+            
+            const FrameVector<VertexState>& vertices = command.flags & JOURNAL_MASK ? unselected : vertexIndices;
+            
+            if (brush == BrushTool::ELEVATION)
+            {
+                float strength = command.flags & JOURNAL_INVERT ? -command.strength : command.strength; // the inverse if left ctrl was held
+                
+                for (int i = 0; i < vertices.size(); ++i)
+                    SetVertexHeight(models, vertices[i], models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[vertices[i].index+1] + strength, modelVertexWidth, modelVertexHeight);
+            }
+            else if (brush == BrushTool::FLATTEN)
+            {
+                for (int i = 0; i < vertices.size(); ++i)
+                    SetVertexHeight(models, vertices[i], command.position.y, modelVertexWidth, modelVertexHeight);
+            }
+            else if (brush == BrushTool::SMOOTH) // smooth by moving each vertex closer to the average y of its neighbors
+            {
+                Smooth(models, vertices, modelVertexWidth, modelVertexHeight, canvasWidth, canvasHeight);
+            }
+            else if (brush == BrushTool::STAMP && (command.flags & JOURNAL_STRETCH))
+            {
+                StampCapsule(models, editSelection, command.stampPoints[0], command.stampPoints[1], command.stamp, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight);
+            }
+            else if (brush == BrushTool::STAMP)
+            {
+                for (int i = 0; i < vertices.size(); i++)
+                {
+                    float vertexY = models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[vertices[i].index + 1];
+                    
+                    Vector2 vertexPos = {models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[vertices[i].index], models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[vertices[i].index + 2]};
+                    
+                    SetVertexHeight(models, vertices[i], StampVertexHeight(xzDistance(Vector2{command.position.x, command.position.z}, vertexPos), vertexY, command.stamp), modelVertexWidth, modelVertexHeight);
+                }
+            }
+            
+            return true;
+        }
+        
+        case JournalCommandType::STROKE_END:
+        {
+            if (stepIndex == 0)
+                return false;
+            
+            HistoryStep& step = history[stepIndex - 1];
+            
+            RequireModels(step.modelCoords);
+            
+            FinalizeHistoryStep(step, models);
+            
+            for (int i = 0; i < step.modelCoords.size(); i++)
+                ScheduleTileJob(step.modelCoords[i].x, step.modelCoords[i].y, TILE_JOB_NORMALS);
+            
+            return true;
+        }
+        
+        case JournalCommandType::UNDO:
+        {
+            if (stepIndex == 0 || history.empty())
+                return false;
+            
+            HistoryStep& step = history[stepIndex - 1];
+            
+            RequireModels(step.modelCoords);
+            
+            for (int i = 0; i < step.startingVertices.size(); i++) // reinstate the previous state of the mesh as recorded by the startingVertices at stepIndex - 1
+                models[step.startingVertices[i].coords.x][step.startingVertices[i].coords.y].meshes[0].vertices[step.startingVertices[i].index + 1] = step.startingVertices[i].y; 
+            
+            for (int i = 0; i < step.modelCoords.size(); i++)
+                ScheduleTileJob(step.modelCoords[i].x, step.modelCoords[i].y, TILE_JOB_NORMALS);
+            
+            stepIndex--;
+            
+            return true;
+        }
+        
+        case JournalCommandType::REDO:
+        {
+            if (history.empty() || stepIndex >= (int)history.size())
+                return false;
+            
+            HistoryStep& step = history[stepIndex];
+            
+            RequireModels(step.modelCoords);
+            
+            for (int i = 0; i < step.endingVertices.size(); i++) // reinstate the later state of the mesh as recorded by the endingVertices at stepIndex
+                models[step.endingVertices[i].coords.x][step.endingVertices[i].coords.y].meshes[0].vertices[step.endingVertices[i].index + 1] = step.endingVertices[i].y;
+            
+            for (int i = 0; i < step.modelCoords.size(); i++)
+                ScheduleTileJob(step.modelCoords[i].x, step.modelCoords[i].y, TILE_JOB_NORMALS);
+            
+            stepIndex++;
+            
+            return true;
+        }
+        
+        case JournalCommandType::DESELECT:
+        {
+            if (vertexSelection.empty())
+                return false;
+            
+            vertexSelection.clear();
+            
+            return true;
+        }
+        
+        case JournalCommandType::TRAIL: // a slope down the vertex selection, in the order it was selected
+        {
+            if (vertexSelection.empty() || vertexSelection[vertexSelection.size() - 1].y <= 1)
+                return false;
+            
+            ModelSelection ms; // list of the models found in vertexSelection
+            
+            for (int i = 0; i < vertexSelection.size(); i++) // fill ms with all unique model coords
+            {
+                int index; // insertion index
+                
+                Vector2 coords = GetVertexCoords(vertexSelection[i].index, modelVertexWidth);
+                
+                LatticeCopy copies[4]; // models sharing the vertex are written too
+                int copyCount = GetLatticeCopies(vertexSelection[i].coords.x, vertexSelection[i].coords.y, coords.x, coords.y, modelVertexWidth, modelVertexHeight, canvasWidth, canvasHeight, copies);
+                
+                for (int j = 0; j < copyCount; j++)
+                {
+                    Vector2 modelCoords = {(float)copies[j].modelX, (float)copies[j].modelY};
+                    
+                    if (BinarySearchVec2(modelCoords, ms.selection, index) == -1) // if these coords arent found, add them
+                    {
+                        ms.selection.insert(ms.selection.begin() + index, modelCoords);
+                    }
+                }
+            }
+            
+            RequireModels(ms.selection);
+            
+            NewHistoryStep(history, models, ms.selection, stepIndex, maxSteps);
+            
+            float top = models[vertexSelection[0].coords.x][vertexSelection[0].coords.y].meshes[0].vertices[vertexSelection[0].index + 1];
+            float bottom = models[vertexSelection[(int)vertexSelection.size() - 1].coords.x][vertexSelection[(int)vertexSelection.size() - 1].coords.y].meshes[0].vertices[vertexSelection[(int)vertexSelection.size() - 1].index + 1];
+            
+            if (top < bottom) // swap values if selection was made bottom to top
+            {
+                float temp = top;
+                top = bottom;
+                bottom = temp;
+            }
+            
+            float increment = (top - bottom) / (vertexSelection[vertexSelection.size() - 1].y); // difference in height between layers on the slope
+            
+            for (int i = 0; i < vertexSelection.size(); i++)
+            {
+                if (vertexSelection[i].y == 1) // flatten out the highest portion with the highest value
+                    SetVertexHeight(models, vertexSelection[i], top, modelVertexWidth, modelVertexHeight);
+                
+                SetVertexHeight(models, vertexSelection[i], top - (increment * (vertexSelection[i].y - 1)), modelVertexWidth, modelVertexHeight);
+            } 
+            
+            FinalizeHistoryStep(history[stepIndex - 1], models);
+            
+            return true;
+        }
+        
+        case JournalCommandType::SMOOTH_MODELS:
+        {
+            ModelSelection modelSelection;
+            modelSelection.topLeft = command.topLeft;
+            modelSelection.bottomRight = command.bottomRight;
+            modelSelection.width = command.bottomRight.x - command.topLeft.x + 1;
+            modelSelection.height = command.bottomRight.y - command.topLeft.y + 1;
+            
+            if (modelSelection.width <= 0 || modelSelection.height <= 0 || command.topLeft.x < 0 || command.topLeft.y < 0 || command.bottomRight.x >= canvasWidth || command.bottomRight.y >= canvasHeight)
+                return false;
+            
+            for (int i = 0; i < modelSelection.width; i++) // in the order FindModelSelection lists them
+            {
+                for (int j = 0; j < modelSelection.height; j++)
+                    modelSelection.selection.push_back(Vector2{i + modelSelection.topLeft.x, j + modelSelection.topLeft.y});
+            }
+            
+            SetExSelection(modelSelection, canvasWidth, canvasHeight);
+            
+            RequireModels(modelSelection.expandedSelection);
+            
+            NewHistoryStep(history, models, modelSelection.expandedSelection, stepIndex, maxSteps);
+            
+            FrameVector<VertexState> vertices; // vertices to pass to smooth
+            vertices.reserve(modelSelection.selection.size() * modelVertexWidth * modelVertexHeight); // every lattice point of every selected model
+            
+            for (int i = 0; i < modelSelection.selection.size(); i++) // loop through all selected models
+            {
+                for (int z = 0; z < modelVertexHeight; z++) // loop through lattice points
+                {
+                    for (int x = 0; x < modelVertexWidth; x++)
+                    {
+                        if ((x == modelVertexWidth - 1 && modelSelection.selection[i].x < modelSelection.bottomRight.x) || (z == modelVertexHeight - 1 && modelSelection.selection[i].y < modelSelection.bottomRight.y)) // already added from the selected model that has it on its left or top edge
+                            continue;
+                        
+                        VertexState vs;
+                        
+                        vs.coords = modelSelection.selection[i];
+                        vs.index = GetVertexIndices(x, z, modelVertexWidth)[0];
+                        
+                        vertices.push_back(vs); // add this vertex's info 
+                    }
+                }
+            }
+            
+            Smooth(models, vertices, modelVertexWidth, modelVertexHeight, canvasWidth, canvasHeight); // writes the models sharing the selection's edges as well
+            
+            FinalizeHistoryStep(history[stepIndex - 1], models);
+            
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+
+int ReplayJournal(const std::vector<JournalCommand>& commands, std::vector<std::vector<Model>>& models, std::vector<VertexState>& vertexSelection, std::vector<HistoryStep>& history, int& stepIndex, int maxSteps, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight)
+{
+    int applied = 0;
+    ModelSelection editSelection; // reused by every dab so its lists keep their memory
+    
+    for (int i = 0; i < commands.size(); i++)
+    {
+        size_t used = frameArena.used; // each command's vertices are given back before the next, so a long replay doesnt fill the arena
+        int overflowCount = frameArena.overflow.size();
+        
+        {
+            FrameVector<VertexState> vertexIndices;
+            
+            if (commands[i].type == JournalCommandType::DAB)
+                FindDabSelection(commands[i], models, modelVertexWidth, modelVertexHeight, modelWidth, editSelection, vertexIndices);
+            
+            if (ApplyJournalCommand(commands[i], models, vertexSelection, history, stepIndex, maxSteps, modelVertexWidth, modelVertexHeight, modelWidth, modelHeight, editSelection, vertexIndices))
+                applied++;
+        }
+        
+        RewindFrameArena(frameArena, used, overflowCount);
+    }
+    
+    return applied;
+}
+
+
+unsigned long long CanvasChecksum(const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    std::vector<float> heights(modelVertexWidth * modelVertexHeight);
+    
+    for (int i = 0; i < models.size(); i++)
+    {
+        for (int j = 0; j < models[i].size(); j++)
+        {
+            if (!ReadModelHeights(models, i, j, heights.data(), modelVertexWidth, modelVertexHeight))
+                std::fill(heights.begin(), heights.end(), 0.f);
+            
+            for (int k = 0; k < heights.size(); k++)
+            {
+                unsigned int bits;
+                memcpy(&bits, &heights[k], 4);
+                
+                for (int byte = 0; byte < 4; byte++) // low byte first, so it is the same on any machine
+                {
+                    hash ^= (bits >> (byte * 8)) & 0xFF;
+                    hash *= 1099511628211ull;
+                }
+            }
+        }
+    }
+    
+    return hash;
+}
+
+
+std::vector<unsigned char> PackJournalHeader(const JournalHeader& header)
+{
+    std::vector<unsigned char> out(header.magic, header.magic + 8);
+    
+    PutLittleEndian(out, (unsigned int)header.version, 4);
+    PutLittleEndian(out, (unsigned int)header.canvasWidth, 4);
+    PutLittleEndian(out, (unsigned int)header.canvasHeight, 4);
+    PutLittleEndian(out, (unsigned int)header.modelVertexWidth, 4);
+    PutLittleEndian(out, (unsigned int)header.modelVertexHeight, 4);
+    PutLittleEndian(out, (unsigned int)header.maxSteps, 4);
+    PutLittleEndian(out, header.checksum, 8);
+    
+    return out;
+}
+
+
+JournalHeader UnpackJournalHeader(const unsigned char* data)
+{
+    JournalHeader header;
+    
+    memcpy(header.magic, data, 8);
+    header.version = (int)GetLittleEndian(data + 8, 4);
+    header.canvasWidth = (int)GetLittleEndian(data + 12, 4);
+    header.canvasHeight = (int)GetLittleEndian(data + 16, 4);
+    header.modelVertexWidth = (int)GetLittleEndian(data + 20, 4);
+    header.modelVertexHeight = (int)GetLittleEndian(data + 24, 4);
+    header.maxSteps = (int)GetLittleEndian(data + 28, 4);
+    header.checksum = GetLittleEndian(data + 32, 8);
+    
+    return header;
+}
+
+
+void PackJournalCommand(std::vector<unsigned char>& out, const JournalCommand& command)
+{
+    const float floats[] = { command.position.x, command.position.y, command.position.z, command.modelRadius, command.vertexRadius, command.strength,
+                             command.stamp.influenceRadius, command.stamp.innerRadius, command.stamp.slopeRatio, command.stamp.heightCap, command.stamp.offset, command.stamp.baseY, command.stamp.cutOff };
+    const bool bools[] = { command.stamp.flip, command.stamp.invert, command.stamp.raiseOnly, command.stamp.lowerOnly };
+    const Vector2 points[] = { command.stampPoints[0], command.stampPoints[1], command.topLeft, command.bottomRight };
+    
+    PutFloat(out, command.time);
+    PutLittleEndian(out, (unsigned char)command.type, 1);
+    PutLittleEndian(out, command.brush, 1);
+    PutLittleEndian(out, command.flags, 1);
+    
+    for (int i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+        PutFloat(out, floats[i]);
+    
+    for (int i = 0; i < sizeof(bools) / sizeof(bools[0]); i++)
+        PutLittleEndian(out, bools[i], 1);
+    
+    for (int i = 0; i < sizeof(points) / sizeof(points[0]); i++)
+    {
+        PutFloat(out, points[i].x);
+        PutFloat(out, points[i].y);
+    }
+}
+
+
+bool UnpackJournalCommand(const unsigned char* data, JournalCommand& command)
+{
+    float* floats[] = { &command.position.x, &command.position.y, &command.position.z, &command.modelRadius, &command.vertexRadius, &command.strength,
+                        &command.stamp.influenceRadius, &command.stamp.innerRadius, &command.stamp.slopeRatio, &command.stamp.heightCap, &command.stamp.offset, &command.stamp.baseY, &command.stamp.cutOff };
+    bool* bools[] = { &command.stamp.flip, &command.stamp.invert, &command.stamp.raiseOnly, &command.stamp.lowerOnly };
+    Vector2* points[] = { &command.stampPoints[0], &command.stampPoints[1], &command.topLeft, &command.bottomRight };
+    
+    bool valid = true;
+    
+    command.time = GetFloat(data);
+    command.type = (JournalCommandType)data[4]; // checked by ValidJournalCommand
+    command.brush = data[5];
+    command.flags = data[6];
+    data += 7;
+    
+    for (int i = 0; i < sizeof(floats) / sizeof(floats[0]); i++, data += 4)
+        *floats[i] = GetFloat(data);
+    
+    for (int i = 0; i < sizeof(bools) / sizeof(bools[0]); i++, data++)
+    {
+        valid = valid && data[0] <= 1;
+        *bools[i] = data[0] != 0;
+    }
+    
+    for (int i = 0; i < sizeof(points) / sizeof(points[0]); i++, data += 8)
+    {
+        points[i]->x = GetFloat(data);
+        points[i]->y = GetFloat(data + 4);
+    }
+    
+    return valid;
+}
+
+
+bool StartJournal(Journal& journal, const char* fileName, int canvasWidth, int canvasHeight, int modelVertexWidth, int modelVertexHeight, int maxSteps, unsigned long long checksum)
+{
+    StopJournal(journal);
+    
+    journal.file = fopen(fileName, "wb");
+    
+    if (!journal.file)
+        return false;
+    
+    JournalHeader header = { 0 };
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.canvasWidth = canvasWidth;
+    header.canvasHeight = canvasHeight;
+    header.modelVertexWidth = modelVertexWidth;
+    header.modelVertexHeight = modelVertexHeight;
+    header.maxSteps = maxSteps;
+    header.checksum = checksum;
+    
+    std::vector<unsigned char> packed = PackJournalHeader(header);
+    
+    if (fwrite(packed.data(), 1, packed.size(), journal.file) != packed.size() || fflush(journal.file) != 0)
+    {
+        StopJournal(journal);
+        return false;
+    }
+    
+    journal.start = std::chrono::steady_clock::now();
+    journal.commandCount = 0;
+    
+    return true;
+}
+
+
+void RecordJournalCommand(Journal& journal, JournalCommand command)
+{
+    if (!journal.file)
+        return;
+    
+    std::chrono::duration<float> time = std::chrono::steady_clock::now() - journal.start;
+    command.time = time.count();
+    
+    std::vector<unsigned char> packed;
+    packed.reserve(JOURNAL_COMMAND_SIZE);
+    PackJournalCommand(packed, command);
+    
+    bool written = fwrite(packed.data(), 1, packed.size(), journal.file) == packed.size();
+    
+    if (written && command.type != JournalCommandType::DAB) // flushed between strokes, so a crash loses at most the stroke it happened in
+        written = fflush(journal.file) == 0;
+    
+    if (!written) // a journal missing a command would replay into something else, so it ends at the last one written
+    {
+        TraceLog(LOG_WARNING, "JOURNAL: couldnt write command %i, recording stopped", journal.commandCount);
+        StopJournal(journal);
+        return;
+    }
+    
+    journal.commandCount++;
+}
+
+
+void StopJournal(Journal& journal)
+{
+    if (journal.file)
+        fclose(journal.file);
+    
+    journal.file = NULL;
+}
+
+
+bool LoadJournal(const char* fileName, JournalHeader& header, std::vector<JournalCommand>& commands)
+{
+    FILE* file = fopen(fileName, "rb");
+    
+    if (!file)
+        return false;
+    
+    unsigned char packedHeader[JOURNAL_HEADER_SIZE];
+    bool valid = fread(packedHeader, 1, JOURNAL_HEADER_SIZE, file) == JOURNAL_HEADER_SIZE;
+    
+    if (valid)
+    {
+        header = UnpackJournalHeader(packedHeader);
+        
+        valid = memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) == 0 && header.version == JOURNAL_VERSION &&
+                header.modelVertexWidth >= 2 && header.modelVertexHeight >= 2 && header.modelVertexWidth <= TILE_RESOLUTION_MAX && header.modelVertexHeight <= TILE_RESOLUTION_MAX &&
+                header.canvasWidth > 0 && header.canvasHeight > 0 && header.maxSteps > 0;
+    }
+    
+    commands.clear();
+    unsigned char packed[JOURNAL_COMMAND_SIZE];
+    
+    while (valid && fread(packed, 1, JOURNAL_COMMAND_SIZE, file) == JOURNAL_COMMAND_SIZE) // a command cut short by a crash is left off
+    {
+        JournalCommand command;
+        
+        if (!UnpackJournalCommand(packed, command) || !ValidJournalCommand(command, header))
+        {
+            TraceLog(LOG_WARNING, "JOURNAL: [%s] command %i is corrupt", fileName, (int)commands.size());
+            valid = false;
+        }
+        
+        commands.push_back(command);
+    }
+    
+    fclose(file);
+    
+    if (!valid)
+        commands.clear();
+    
+    return valid;
+}
+
+
+bool ValidJournalCommand(const JournalCommand& command, const JournalHeader& header)
+{
+    const float floats[] = { command.position.x, command.position.y, command.position.z, command.modelRadius, command.vertexRadius, command.strength,
+                             command.stamp.influenceRadius, command.stamp.innerRadius, command.stamp.slopeRatio, command.stamp.heightCap, command.stamp.offset, command.stamp.baseY, command.stamp.cutOff,
+                             command.stampPoints[0].x, command.stampPoints[0].y, command.stampPoints[1].x, command.stampPoints[1].y, command.topLeft.x, command.topLeft.y, command.bottomRight.x, command.bottomRight.y };
+    
+    for (int i = 0; i < sizeof(floats) / sizeof(floats[0]); i++) // every command is written whole, so even the fields it doesnt use are as recorded
+    {
+        if (!std::isfinite(floats[i]))
+            return false;
+    }
+    
+    if (!std::isfinite(command.time) || command.time < 0 || (command.flags & ~(JOURNAL_STROKE_START | JOURNAL_INVERT | JOURNAL_MASK | JOURNAL_STRETCH)) != 0)
+        return false;
+    
+    switch (command.type)
+    {
+        case JournalCommandType::DAB:
+            return command.brush >= (unsigned char)BrushTool::ELEVATION && command.brush <= (unsigned char)BrushTool::SELECT;
+        
+        case JournalCommandType::STROKE_END:
+        case JournalCommandType::UNDO:
+        case JournalCommandType::REDO:
+        case JournalCommandType::DESELECT:
+        case JournalCommandType::TRAIL:
+            return true;
+        
+        case JournalCommandType::SMOOTH_MODELS:
+            return command.topLeft.x >= 0 && command.topLeft.y >= 0 && command.topLeft.x <= command.bottomRight.x && command.topLeft.y <= command.bottomRight.y &&
+                   command.bottomRight.x < header.canvasWidth && command.bottomRight.y < header.canvasHeight &&
+                   command.topLeft.x == (int)command.topLeft.x && command.topLeft.y == (int)command.topLeft.y && command.bottomRight.x == (int)command.bottomRight.x && command.bottomRight.y == (int)command.bottomRight.y;
+    }
+    
+    return false; // not a command type
+}
+
+
+void BindSimulation(std::vector<std::vector<Model>>& models, std::vector<VertexState>& vertexSelection, std::vector<HistoryStep>& history, int& stepIndex)
+{
+    simulation.models = &models;
+    simulation.vertexSelection = &vertexSelection;
+    simulation.history = &history;
+    simulation.stepIndex = &stepIndex;
+    
+    simulation.thread = std::thread(SimulationWorker);
+}
+
+
+void ShutdownSimulation()
+{
+    HoldCanvas(true);
+    ReleaseCanvas();
+    
+    {
+        std::lock_guard<std::mutex> lock(simulation.mutex);
+        simulation.quit = true;
+    }
+    
+    simulation.wake.notify_all();
+    simulation.thread.join();
+}
+
+
+void SubmitEdit(const JournalCommand& command, const ModelSelection& editSelection, const FrameVector<VertexState>& vertexIndices, int maxSteps, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, bool findSelection)
+{
+    RecordJournalCommand(journal, command);
+    
+    SimulationCommand edit;
+    edit.command = command;
+    edit.editSelection = editSelection;
+    edit.vertexIndices.assign(vertexIndices.begin(), vertexIndices.end()); // off the frame arena, it is reset before the edit is done
+    edit.maxSteps = maxSteps;
+    edit.modelVertexWidth = modelVertexWidth;
+    edit.modelVertexHeight = modelVertexHeight;
+    edit.modelWidth = modelWidth;
+    edit.modelHeight = modelHeight;
+    edit.findSelection = findSelection;
+    
+    {
+        std::lock_guard<std::mutex> lock(simulation.mutex);
+        simulation.commands.push_back(std::move(edit));
+    }
+    
+    simulation.wake.notify_one();
+}
+
+
+bool HoldCanvas(bool wait)
+{
+    while (true)
+    {
+        ServeSimulationLoads(); // the simulation thread may be waiting on one before it can finish
+        
+        {
+            std::lock_guard<std::mutex> lock(simulation.mutex);
+            
+            if (simulation.commands.empty()) // commands are popped after the canvas is let go, so it is free
+                break;
+        }
+        
+        if (!wait)
+            return false;
+        
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    
+    simulation.canvasLock.lock();
+    
+    return true;
+}
+
+
+void ReleaseCanvas()
+{
+    if (simulation.canvasLock.owns_lock())
+        simulation.canvasLock.unlock();
+}
+
+
+bool TakeSimulationCommits(std::vector<std::vector<unsigned int>>& modelRevisions)
+{
+    std::vector<TileCommit> commits;
+    
+    {
+        std::lock_guard<std::mutex> lock(simulation.mutex);
+        commits.swap(simulation.committed);
+    }
+    
+    for (int i = 0; i < commits.size(); i++)
+    {
+        if (commits[i].work & TILE_JOB_UPLOAD) // the heights changed, a new revision for the project and autosave
+            MarkModelChanged(modelRevisions, commits[i].x, commits[i].y);
+        
+        ScheduleTileJob(commits[i].x, commits[i].y, commits[i].work);
+    }
+    
+    return !commits.empty();
+}
+
+
+void ServeSimulationLoads()
+{
+    std::vector<Vector2> loads;
+    
+    {
+        std::lock_guard<std::mutex> lock(simulation.mutex);
+        
+        if (simulation.loads.empty())
+            return;
+        
+        loads = simulation.loads;
+    }
+    
+    RequireModels(loads); // the simulation thread is waiting, the canvas is safe to touch
+    
+    {
+        std::lock_guard<std::mutex> lock(simulation.mutex);
+        simulation.loads.clear();
+    }
+    
+    simulation.loaded.notify_all();
+}
+
+
+void LoadForSimulation(int x, int y)
+{
+    std::unique_lock<std::mutex> lock(simulation.mutex);
+    
+    simulation.loads.push_back(Vector2{(float)x, (float)y});
+    simulation.loaded.wait(lock, []() { return simulation.loads.empty(); });
+}
+
+
+void SimulationWorker()
+{
+    while (true)
+    {
+        SimulationCommand* edit;
+        
+        {
+            std::unique_lock<std::mutex> lock(simulation.mutex);
+            simulation.wake.wait(lock, []() { return simulation.quit || !simulation.commands.empty(); });
+            
+            if (simulation.commands.empty()) // quitting, with nothing left to apply
+                break;
+            
+            edit = &simulation.commands.front();
+        }
+        
+        std::vector<TileCommit> commits;
+        
+        {
+            std::lock_guard<std::mutex> canvasLock(simulation.canvasMutex); // until the main thread lets go at the end of the tick the edit was queued on
+            
+            FrameVector<VertexState> vertexIndices(edit->vertexIndices.begin(), edit->vertexIndices.end());
+            
+            if (edit->findSelection) // against the heights the edits before it left
+                FindDabSelection(edit->command, *simulation.models, edit->modelVertexWidth, edit->modelVertexHeight, edit->modelWidth, edit->editSelection, vertexIndices);
+            
+            if (ApplyJournalCommand(edit->command, *simulation.models, *simulation.vertexSelection, *simulation.history, *simulation.stepIndex, edit->maxSteps, edit->modelVertexWidth, edit->modelVertexHeight, edit->modelWidth, edit->modelHeight, edit->editSelection, vertexIndices))
+                CollectTileCommits(edit->command, edit->editSelection, *simulation.models, *simulation.history, *simulation.stepIndex, commits);
+        }
+        
+        ResetFrameArena(frameArena);
+        
+        {
+            std::lock_guard<std::mutex> lock(simulation.mutex);
+            
+            simulation.committed.insert(simulation.committed.end(), commits.begin(), commits.end());
+            simulation.commands.pop_front();
+        }
+    }
+    
+    RL_FREE(frameArena.memory);
+}
+
+
+void CollectTileCommits(const JournalCommand& command, const ModelSelection& editSelection, const std::vector<std::vector<Model>>& models, const std::vector<HistoryStep>& history, int stepIndex, std::vector<TileCommit>& commits)
+{
+    const std::vector<Vector2>* modelCoords = NULL;
+    unsigned char work = TILE_JOB_UPLOAD | TILE_JOB_HEIGHTMAP;
+    
+    switch (command.type)
+    {
+        case JournalCommandType::DAB:
+        {
+            if ((BrushTool)command.brush == BrushTool::SELECT) // selecting doesnt change the mesh
+                return;
+            
+            modelCoords = &editSelection.selection;
+            break;
+        }
+        
+        case JournalCommandType::STROKE_END: // the heights are already up, the heightmaps follow the normals ApplyJournalCommand scheduled
+        {
+            modelCoords = &history[stepIndex - 1].modelCoords;
+            work = TILE_JOB_HEIGHTMAP;
+            break;
+        }
+        
+        case JournalCommandType::UNDO: // the step that was just undone
+        {
+            modelCoords = &history[stepIndex].modelCoords;
+            break;
+        }
+        
+        case JournalCommandType::REDO: // the step that was just redone
+        {
+            modelCoords = &history[stepIndex - 1].modelCoords;
+            break;
+        }
+        
+        case JournalCommandType::TRAIL:
+        case JournalCommandType::SMOOTH_MODELS: // the models the step it made recorded
+        {
+            modelCoords = &history[stepIndex - 1].modelCoords;
+            break;
+        }
+        
+        default:
+            return;
+    }
+    
+    for (int i = 0; i < modelCoords->size(); i++)
+        commits.push_back(TileCommit{(int)(*modelCoords)[i].x, (int)(*modelCoords)[i].y, work});
+}
+
+
+float DecimateCell(const float* heights, int modelVertexWidth, int x, int z, int width, int height, float threshold, std::vector<DecimatedCell>& cells, std::vector<std::pair<float, int>>* splits)
+{
+    int firstCell = cells.size();
+    int children = 0;
+    float error = 0;
+    
+    if (width > 1 || height > 1) // always split all the way down, the saturated error needs every cell's error
+    {
+        int xStarts[3] = { x, x + (width > 1 ? width / 2 : width), x + width }; // a cell one quad wide is only split the other way
+        int zStarts[3] = { z, z + (height > 1 ? height / 2 : height), z + height };
+        
+        for (int i = 0; i < 2; i++)
+        {
+            for (int j = 0; j < 2; j++)
+            {
+                int childWidth = xStarts[i + 1] - xStarts[i];
+                int childHeight = zStarts[j + 1] - zStarts[j];
+                
+                if (childWidth == 0 || childHeight == 0)
+                    continue;
+                
+                error = std::max(error, DecimateCell(heights, modelVertexWidth, xStarts[i], zStarts[j], childWidth, childHeight, threshold, cells, splits));
+                children++;
+            }
+        }
+    }
+    
+    float h00 = heights[z * modelVertexWidth + x];
+    float h10 = heights[z * modelVertexWidth + x + width];
+    float h01 = heights[(z + height) * modelVertexWidth + x];
+    float h11 = heights[(z + height) * modelVertexWidth + x + width];
+    
+    for (int k = 0; k <= height; k++) // how far the heights under the cell are from the corners interpolated across it
+    {
+        float v = k / (float)height;
+        
+        for (int l = 0; l <= width; l++)
+        {
+            float u = l / (float)width;
+            float approximate = (h00 * (1 - u) + h10 * u) * (1 - v) + (h01 * (1 - u) + h11 * u) * v;
+            
+            error = std::max(error, fabsf(heights[(z + k) * modelVertexWidth + x + l] - approximate));
+        }
+    }
+    
+    if (error <= threshold) // close enough, drop the children and keep this cell whole
+    {
+        cells.resize(firstCell);
+        cells.push_back(DecimatedCell{x, z, width, height});
+    }
+    
+    if (splits && children > 0)
+        splits->push_back(std::make_pair(error, children - 1));
+    
+    return error;
+}
+
+
+void TriangulateDecimatedModel(DecimatedModel& model, int modelVertexWidth, int modelVertexHeight, float spacing)
+{
+    std::vector<int> vertexIndices(modelVertexWidth * modelVertexHeight, -1); // output vertex of each grid vertex that has been used
+    
+    float xOffset = model.x * (modelVertexWidth - 1) * spacing;
+    float zOffset = model.y * (modelVertexHeight - 1) * spacing;
+    
+    auto gridVertex = [&](int x, int z) -> unsigned int
+    {
+        int gridIndex = z * modelVertexWidth + x;
+        
+        if (vertexIndices[gridIndex] < 0)
+        {
+            vertexIndices[gridIndex] = model.vertexGrid.size();
+            model.vertexGrid.push_back(gridIndex);
+            model.vertices.push_back(xOffset + x * spacing);
+            model.vertices.push_back(model.heights[gridIndex]);
+            model.vertices.push_back(zOffset + z * spacing);
+        }
+        
+        return vertexIndices[gridIndex];
+    };
+    
+    std::vector<unsigned int> border; // one cell's used vertices, counter clockwise from its top left when looking down
+    
+    for (int i = 0; i < model.cells.size(); i++)
+    {
+        const DecimatedCell& cell = model.cells[i];
+        
+        border.clear();
+        
+        // walk the cell's edges picking up every used vertex, including the corners of smaller neighbouring cells, so no edge is left with a t junction
+        for (int z = cell.z; z < cell.z + cell.height; z++)
+        {
+            if (z == cell.z || model.used[z * modelVertexWidth + cell.x])
+                border.push_back(gridVertex(cell.x, z));
+        }
+        
+        for (int x = cell.x; x < cell.x + cell.width; x++)
+        {
+            if (x == cell.x || model.used[(cell.z + cell.height) * modelVertexWidth + x])
+                border.push_back(gridVertex(x, cell.z + cell.height));
+        }
+        
+        for (int z = cell.z + cell.height; z > cell.z; z--)
+        {
+            if (z == cell.z + cell.height || model.used[z * modelVertexWidth + cell.x + cell.width])
+                border.push_back(gridVertex(cell.x + cell.width, z));
+        }
+        
+        for (int x = cell.x + cell.width; x > cell.x; x--)
+        {
+            if (x == cell.x + cell.width || model.used[cell.z * modelVertexWidth + x])
+                border.push_back(gridVertex(x, cell.z));
+        }
+        
+        if (border.size() == 4) // just the corners, two triangles the same way GenMeshHeightmap makes them
+        {
+            model.indices.insert(model.indices.end(), { border[0], border[1], border[3], border[3], border[1], border[2] });
+            continue;
+        }
+        
+        // otherwise fan out from the middle of the cell, at the height of the corners interpolated to it
+        unsigned int center = model.vertexGrid.size();
+        
+        model.vertexGrid.push_back(-1);
+        model.vertices.push_back(xOffset + (cell.x + cell.width / 2.f) * spacing);
+        model.vertices.push_back((model.heights[cell.z * modelVertexWidth + cell.x] + model.heights[cell.z * modelVertexWidth + cell.x + cell.width] + model.heights[(cell.z + cell.height) * modelVertexWidth + cell.x] + model.heights[(cell.z + cell.height) * modelVertexWidth + cell.x + cell.width]) / 4);
+        model.vertices.push_back(zOffset + (cell.z + cell.height / 2.f) * spacing);
+        
+        for (int j = 0; j < border.size(); j++)
+            model.indices.insert(model.indices.end(), { center, border[j], border[(j + 1) % border.size()] });
+    }
+}
+
+
+bool ExportMesh(const char* fileName, const std::vector<std::vector<Model>>& models, const std::vector<Vector2>& modelCoords, int modelVertexWidth, int modelVertexHeight, int modelWidth, int triangleBudget, float maxError, HeightmapFormat format)
+{
+    if (models.empty())
+        return false;
+    
+    int canvasWidth = models.size();
+    int canvasHeight = models[0].size();
+    
+    std::vector<DecimatedModel> decimated;
+    std::vector<std::vector<int>> decimatedIndex(canvasWidth, std::vector<int>(canvasHeight, -1)); // where each exported model is in decimated
+    
+    auto addModel = [&](int x, int y)
+    {
+        if (x >= 0 && y >= 0 && x < canvasWidth && y < canvasHeight && decimatedIndex[x][y] < 0)
+        {
+            decimatedIndex[x][y] = decimated.size();
+            decimated.push_back(DecimatedModel{x, y});
+        }
+    };
+    
+    if (modelCoords.empty()) // no selection, the whole canvas
+    {
+        for (int i = 0; i < canvasWidth; i++)
+        {
+            for (int j = 0; j < canvasHeight; j++)
+                addModel(i, j);
+        }
+    }
+    else
+    {
+        for (int i = 0; i < modelCoords.size(); i++)
+            addModel(modelCoords[i].x, modelCoords[i].y);
+    }
+    
+    int modelVertexCount = modelVertexWidth * modelVertexHeight;
+    
+    for (int i = 0; i < decimated.size(); i++) // read on this thread, the page file isnt shared between threads
+    {
+        decimated[i].heights.resize(modelVertexCount);
+        
+        if (!ReadModelHeights(models, decimated[i].x, decimated[i].y, decimated[i].heights.data(), modelVertexWidth, modelVertexHeight))
+            std::fill(decimated[i].heights.begin(), decimated[i].heights.end(), 0.f);
+    }
+    
+    // shared model borders take their heights from the model left of or above them, so both sides end up with the same vertices
+    for (int i = 0; i < decimated.size(); i++)
+    {
+        DecimatedModel& model = decimated[i];
+        
+        if (model.x > 0 && decimatedIndex[model.x - 1][model.y] >= 0)
+        {
+            const DecimatedModel& left = decimated[decimatedIndex[model.x - 1][model.y]];
+            
+            for (int z = 0; z < modelVertexHeight; z++)
+                model.heights[z * modelVertexWidth] = left.heights[z * modelVertexWidth + modelVertexWidth - 1];
+        }
+        
+        if (model.y > 0 && decimatedIndex[model.x][model.y - 1] >= 0)
+        {
+            const DecimatedModel& above = decimated[decimatedIndex[model.x][model.y - 1]];
+            
+            for (int x = 0; x < modelVertexWidth; x++)
+                model.heights[x] = above.heights[(modelVertexHeight - 1) * modelVertexWidth + x];
+        }
+    }
+    
+    float threshold = maxError;
+    
+    if (triangleBudget > 0) // find the error that splits cells until about triangleBudget triangles. about 3 per cell once the fans next to smaller cells are counted
+    {
+        std::vector<std::vector<std::pair<float, int>>> splits(decimated.size());
+        
+        ParallelFor(decimated.size(), [&](int i)
+        {
+            std::vector<DecimatedCell> cells;
+            DecimateCell(decimated[i].heights.data(), modelVertexWidth, 0, 0, modelVertexWidth - 1, modelVertexHeight - 1, FLT_MAX, cells, &splits[i]);
+        });
+        
+        std::vector<std::pair<float, int>> allSplits;
+        
+        for (int i = 0; i < splits.size(); i++)
+            allSplits.insert(allSplits.end(), splits[i].begin(), splits[i].end());
+        
+        std::sort(allSplits.begin(), allSplits.end(), [](const std::pair<float, int>& a, const std::pair<float, int>& b) { return a.first > b.first; });
+        
+        // a cell is split when its saturated error is above the threshold, and those errors never grow going down the tree, so the worst splits can be taken in order
+        long long cellCount = decimated.size();
+        threshold = 0;
+        
+        for (int i = 0; i < allSplits.size(); i++)
+        {
+            if ((cellCount + allSplits[i].second) * 3 > triangleBudget)
+            {
+                threshold = allSplits[i].first;
+                break;
+            }
+            
+            cellCount += allSplits[i].second;
+        }
+    }
+    
+    ParallelFor(decimated.size(), [&](int i)
+    {
+        DecimatedModel& model = decimated[i];
+        
+        DecimateCell(model.heights.data(), modelVertexWidth, 0, 0, modelVertexWidth - 1, modelVertexHeight - 1, threshold, model.cells, NULL);
+        
+        model.used.assign(modelVertexCount, 0);
+        
+        for (int j = 0; j < model.cells.size(); j++)
+        {
+            const DecimatedCell& cell = model.cells[j];
+            
+            model.used[cell.z * modelVertexWidth + cell.x] = 1;
+            model.used[cell.z * modelVertexWidth + cell.x + cell.width] = 1;
+            model.used[(cell.z + cell.height) * modelVertexWidth + cell.x] = 1;
+            model.used[(cell.z + cell.height) * modelVertexWidth + cell.x + cell.width] = 1;
+        }
+    });
+    
+    // a vertex used on either side of a shared border is used on both, so neighbouring models meet at the same vertices and there are no cracks
+    for (int i = 0; i < decimated.size(); i++)
+    {
+        DecimatedModel& model = decimated[i];
+        
+        if (model.x > 0 && decimatedIndex[model.x - 1][model.y] >= 0)
+        {
+            DecimatedModel& left = decimated[decimatedIndex[model.x - 1][model.y]];
+            
+            for (int z = 0; z < modelVertexHeight; z++)
+            {
+                unsigned char used = model.used[z * modelVertexWidth] | left.used[z * modelVertexWidth + modelVertexWidth - 1];
+                model.used[z * modelVertexWidth] = used;
+                left.used[z * modelVertexWidth + modelVertexWidth - 1] = used;
+            }
+        }
+        
+        if (model.y > 0 && decimatedIndex[model.x][model.y - 1] >= 0)
+        {
+            DecimatedModel& above = decimated[decimatedIndex[model.x][model.y - 1]];
+            
+            for (int x = 0; x < modelVertexWidth; x++)
+            {
+                unsigned char used = model.used[x] | above.used[(modelVertexHeight - 1) * modelVertexWidth + x];
+                model.used[x] = used;
+                above.used[(modelVertexHeight - 1) * modelVertexWidth + x] = used;
+            }
+        }
+    }
+    
+    float spacing = modelWidth / (float)modelVertexWidth; // same spacing GenMeshHeightGrid uses
+    
+    ParallelFor(decimated.size(), [&](int i)
+    {
+        TriangulateDecimatedModel(decimated[i], modelVertexWidth, modelVertexHeight, spacing);
+    });
+    
+    // join the models into one mesh. border vertices are welded to the neighbour's copy
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    std::unordered_map<long long, unsigned int> borderVertices; // canvas vertex index to output vertex
+    long long canvasVertexWidth = canvasWidth * (modelVertexWidth - 1) + 1;
+    
+    for (int i = 0; i < decimated.size(); i++)
+    {
+        DecimatedModel& model = decimated[i];
+        std::vector<unsigned int> remap(model.vertexGrid.size());
+        
+        for (int j = 0; j < model.vertexGrid.size(); j++)
+        {
+            int gridIndex = model.vertexGrid[j];
+            int x = gridIndex % modelVertexWidth;
+            int z = gridIndex / modelVertexWidth;
+            
+            if (gridIndex >= 0 && (x == 0 || z == 0 || x == modelVertexWidth - 1 || z == modelVertexHeight - 1))
+            {
+                long long canvasIndex = (long long)(model.y * (modelVertexHeight - 1) + z) * canvasVertexWidth + model.x * (modelVertexWidth - 1) + x;
+                auto found = borderVertices.find(canvasIndex);
+                
+                if (found != borderVertices.end())
+                {
+                    remap[j] = found->second;
+                    continue;
+                }
+                
+                borderVertices[canvasIndex] = vertices.size() / 3;
+            }
+            
+            remap[j] = vertices.size() / 3;
+            vertices.insert(vertices.end(), model.vertices.begin() + j * 3, model.vertices.begin() + j * 3 + 3);
+        }
+        
+        for (int j = 0; j < model.indices.size(); j++)
+            indices.push_back(remap[model.indices[j]]);
+        
+        model = DecimatedModel(); // done with it, free its memory before the next one is added
+    }
+    
+    std::vector<float> normals(vertices.size(), 0.f);
+    
+    for (int i = 0; i < indices.size(); i += 3) // area weighted face normals, summed at each vertex
+    {
+        Vector3 a = {vertices[indices[i] * 3], vertices[indices[i] * 3 + 1], vertices[indices[i] * 3 + 2]};
+        Vector3 b = {vertices[indices[i + 1] * 3], vertices[indices[i + 1] * 3 + 1], vertices[indices[i + 1] * 3 + 2]};
+        Vector3 c = {vertices[indices[i + 2] * 3], vertices[indices[i + 2] * 3 + 1], vertices[indices[i + 2] * 3 + 2]};
+        Vector3 normal = Vector3CrossProduct(Vector3Subtract(b, a), Vector3Subtract(c, a));
+        
+        for (int j = 0; j < 3; j++)
+        {
+            normals[indices[i + j] * 3] += normal.x;
+            normals[indices[i + j] * 3 + 1] += normal.y;
+            normals[indices[i + j] * 3 + 2] += normal.z;
+        }
+    }
+    
+    for (int i = 0; i < normals.size(); i += 3)
+    {
+        Vector3 normal = Vector3Normalize(Vector3{normals[i], normals[i + 1], normals[i + 2]});
+        normals[i] = normal.x;
+        normals[i + 1] = normal.y;
+        normals[i + 2] = normal.z;
+    }
+    
+    if (format == HeightmapFormat::GLB)
+        return WriteGlb(fileName, vertices, normals, indices);
+    
+    return WriteObj(fileName, vertices, normals, indices);
+}
+
+
+bool WriteObj(const char* fileName, const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<unsigned int>& indices)
+{
+    FILE* file = fopen(fileName, "wb");
+    
+    if (!file)
+        return false;
+    
+    fprintf(file, "# pangea terrain, %d vertices, %d triangles\n", (int)(vertices.size() / 3), (int)(indices.size() / 3));
+    
+    for (int i = 0; i < vertices.size(); i += 3)
+        fprintf(file, "v %f %f %f\n", vertices[i], vertices[i + 1], vertices[i + 2]);
+    
+    for (int i = 0; i < normals.size(); i += 3)
+        fprintf(file, "vn %f %f %f\n", normals[i], normals[i + 1], normals[i + 2]);
+    
+    for (int i = 0; i < indices.size(); i += 3) // obj indices start at 1
+        fprintf(file, "f %u//%u %u//%u %u//%u\n", indices[i] + 1, indices[i] + 1, indices[i + 1] + 1, indices[i + 1] + 1, indices[i + 2] + 1, indices[i + 2] + 1);
+    
+    bool success = !ferror(file);
+    fclose(file);
+    
+    return success;
+}
+
+
+bool WriteGlb(const char* fileName, const std::vector<float>& vertices, const std::vector<float>& normals, const std::vector<unsigned int>& indices)
+{
+    unsigned int vertexCount = vertices.size() / 3;
+    unsigned int vertexBytes = vertices.size() * sizeof(float);
+    unsigned int indexBytes = indices.size() * sizeof(unsigned int);
+    unsigned int binaryLength = vertexBytes * 2 + indexBytes; // positions, normals, indices. all already 4 byte aligned
+    
+    Vector3 minimum = {FLT_MAX, FLT_MAX, FLT_MAX}; // gltf wants the position bounds
+    Vector3 maximum = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    
+    for (int i = 0; i < vertices.size(); i += 3)
+    {
+        minimum = Vector3{fminf(minimum.x, vertices[i]), fminf(minimum.y, vertices[i + 1]), fminf(minimum.z, vertices[i + 2])};
+        maximum = Vector3{fmaxf(maximum.x, vertices[i]), fmaxf(maximum.y, vertices[i + 1]), fmaxf(maximum.z, vertices[i + 2])};
+    }
+    
+    char bounds[256];
+    snprintf(bounds, sizeof(bounds), "\"min\":[%.9g,%.9g,%.9g],\"max\":[%.9g,%.9g,%.9g]", minimum.x, minimum.y, minimum.z, maximum.x, maximum.y, maximum.z);
+    
+    std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"Pangea\"},\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}],"
+        "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,\"NORMAL\":1},\"indices\":2}]}],"
+        "\"buffers\":[{\"byteLength\":" + std::to_string(binaryLength) + "}],"
+        "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":" + std::to_string(vertexBytes) + ",\"target\":34962},"
+        "{\"buffer\":0,\"byteOffset\":" + std::to_string(vertexBytes) + ",\"byteLength\":" + std::to_string(vertexBytes) + ",\"target\":34962},"
+        "{\"buffer\":0,\"byteOffset\":" + std::to_string(vertexBytes * 2) + ",\"byteLength\":" + std::to_string(indexBytes) + ",\"target\":34963}],"
+        "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":" + std::to_string(vertexCount) + ",\"type\":\"VEC3\"," + bounds + "},"
+        "{\"bufferView\":1,\"componentType\":5126,\"count\":" + std::to_string(vertexCount) + ",\"type\":\"VEC3\"},"
+        "{\"bufferView\":2,\"componentType\":5125,\"count\":" + std::to_string(indices.size()) + ",\"type\":\"SCALAR\"}]}";
+    
+    while (json.size() % 4 != 0) // chunks are 4 byte aligned, the json chunk is padded with spaces
+        json.push_back(' ');
+    
+    FILE* file = fopen(fileName, "wb");
+    
+    if (!file)
+        return false;
+    
+    unsigned int header[3] = { 0x46546C67, 2, (unsigned int)(12 + 8 + json.size() + 8 + binaryLength) }; // "glTF", version 2, total length
+    unsigned int jsonChunk[2] = { (unsigned int)json.size(), 0x4E4F534A }; // "JSON"
+    unsigned int binaryChunk[2] = { binaryLength, 0x004E4942 }; // "BIN"
+    
+    fwrite(header, sizeof(header), 1, file);
+    fwrite(jsonChunk, sizeof(jsonChunk), 1, file);
+    fwrite(json.data(), 1, json.size(), file);
+    fwrite(binaryChunk, sizeof(binaryChunk), 1, file);
+    fwrite(vertices.data(), sizeof(float), vertices.size(), file);
+    fwrite(normals.data(), sizeof(float), normals.size(), file);
+    fwrite(indices.data(), sizeof(unsigned int), indices.size(), file);
+    
+    bool success = !ferror(file);
+    fclose(file);
+    
+    return success;
+}
+
+
+float* LoadHeightGrid(const char* fileName, HeightmapFormat format, int& width, int& height)
+{
+    if (format == HeightmapFormat::GRAYSCALE || format == HeightmapFormat::SPLIT) // left to raylib to decode, then converted in one pass
+    {
+        Image image = LoadImage(fileName);
+        
+        if (!image.data)
+            return NULL;
+        
+        Color* pixels = GetImageData(image);
+        
+        width = image.width;
+        height = image.height;
+        UnloadImage(image);
+        
+        if (!pixels)
+            return NULL;
+        
+        float* heights = (float*)RL_MALLOC(width*height*sizeof(float));
+        
+        if (format == HeightmapFormat::SPLIT)
+        {
+            DecodeSplitRow((const unsigned char*)pixels, width * height, heights); // the rows are back to back, so the whole image is one long row
+        }
+        else
+        {
+            for (int i = 0; i < width * height; i++)
+                heights[i] = ((pixels[i].r + pixels[i].g + pixels[i].b) / 3) / 255.f; // same gray value GenMeshHeightmap uses
+        }
+        
+        RL_FREE(pixels);
+        
+        return heights;
+    }
+    
+    unsigned int fileSize = 0;
+    unsigned char* fileData = LoadFileData(fileName, &fileSize);
+    
+    if (!fileData)
+        return NULL;
+    
+    float* heights = NULL;
+    
+    if (format == HeightmapFormat::R16 || format == HeightmapFormat::R32F) // raw files have no header, they are assumed to be square
+    {
+        int sampleSize = format == HeightmapFormat::R32F ? 4 : 2;
+        int sampleCount = fileSize / sampleSize;
+        int side = (int)(sqrt((double)sampleCount) + 0.5);
+        
+        if (side > 1 && side * side == sampleCount && fileSize % sampleSize == 0)
+        {
+            width = side;
+            height = side;
+            heights = (float*)RL_MALLOC(sampleCount*sizeof(float));
+            
+            for (int i = 0; i < sampleCount; i++)
+            {
+                const unsigned char* sample = &fileData[i * sampleSize];
+                
+                if (format == HeightmapFormat::R32F)
+                {
+                    unsigned int bits = sample[0] | (sample[1] << 8) | (sample[2] << 16) | ((unsigned int)sample[3] << 24);
+                    memcpy(&heights[i], &bits, 4);
+                }
+                else
+                    heights[i] = (sample[0] | (sample[1] << 8)) / 65535.f;
+            }
+        }
+    }
+    else if (format == HeightmapFormat::PNG16)
+    {
+        heights = DecodePng16(fileData, fileSize, width, height);
+    }
+    
+    RL_FREE(fileData);
+    
+    return heights;
+}
+
+
+float* DecodePng16(const unsigned char* fileData, unsigned int fileSize, int& width, int& height)
+{
+    const unsigned char signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    
+    if (fileSize < 8 || memcmp(fileData, signature, 8) != 0)
+        return NULL;
+    
+    int channels = 0; // channels per pixel, only the first is used
+    std::vector<unsigned char> compressed; // all IDAT chunks joined
+    
+    unsigned int position = 8;
+    
+    while (position + 12 <= fileSize)
+    {
+        unsigned int length = (fileData[position] << 24) | (fileData[position + 1] << 16) | (fileData[position + 2] << 8) | fileData[position + 3];
+        const unsigned char* type = &fileData[position + 4];
+        const unsigned char* data = &fileData[position + 8];
+        
+        if (length > fileSize - position - 12)
+            return NULL;
+        
+        if (memcmp(type, "IHDR", 4) == 0)
+        {
+            if (length < 13)
+                return NULL;
+            
+            width = (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+            height = (data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+            
+            int bitDepth = data[8];
+            int colorType = data[9];
+            int interlace = data[12];
+            
+            if (bitDepth != 16 || interlace != 0) // only 16 bit non interlaced images
+                return NULL;
+            
+            if (colorType == 0) channels = 1; // gray
+            else if (colorType == 4) channels = 2; // gray, alpha
+            else if (colorType == 2) channels = 3; // rgb
+            else if (colorType == 6) channels = 4; // rgba
+            else return NULL;
+        }
+        else if (memcmp(type, "IDAT", 4) == 0)
+        {
+            compressed.insert(compressed.end(), data, data + length);
+        }
+        else if (memcmp(type, "IEND", 4) == 0)
+            break;
+        
+        position += length + 12;
+    }
+    
+    if (!channels || compressed.empty() || width <= 0 || height <= 0)
+        return NULL;
+    
+    int dataLength = 0;
+    unsigned char* raw = DecompressData(compressed.data(), compressed.size(), &dataLength);
+    
+    int pixelSize = channels * 2;
+    int stride = width * pixelSize;
+    
+    if (!raw || dataLength < (stride + 1) * height)
+    {
+        if (raw) RL_FREE(raw);
+        return NULL;
+    }
+    
+    float* heights = (float*)RL_MALLOC(width*height*sizeof(float));
+    
+    // undo the filter on each row in place. every row starts with its filter type
+    for (int z = 0; z < height; z++)
+    {
+        unsigned char* line = &raw[z * (stride + 1) + 1];
+        unsigned char* previous = z > 0 ? &raw[(z - 1) * (stride + 1) + 1] : NULL;
+        int filter = line[-1];
+        
+        for (int i = 0; i < stride; i++)
+        {
+            int left = i >= pixelSize ? line[i - pixelSize] : 0;
+            int up = previous ? previous[i] : 0;
+            int upLeft = previous && i >= pixelSize ? previous[i - pixelSize] : 0;
+            
+            if (filter == 1) // sub
+                line[i] += left;
+            else if (filter == 2) // up
+                line[i] += up;
+            else if (filter == 3) // average
+                line[i] += (left + up) / 2;
+            else if (filter == 4) // paeth
+            {
+                int p = left + up - upLeft;
+                int pa = abs(p - left);
+                int pb = abs(p - up);
+                int pc = abs(p - upLeft);
+                
+                if (pa <= pb && pa <= pc) line[i] += left;
+                else if (pb <= pc) line[i] += up;
+                else line[i] += upLeft;
+            }
+        }
+        
+        for (int x = 0; x < width; x++)
+            heights[z * width + x] = ((line[x * pixelSize] << 8) | line[x * pixelSize + 1]) / 65535.f;
+    }
+    
+    RL_FREE(raw);
+    
+    return heights;
+}
+
+
+Mesh GenMeshHeightGrid(const float* heights, int gridWidth, int gridHeight, int startX, int startZ, int mapX, int mapZ, Vector3 size, Vector2 offset, bool upload)
+{
+    Mesh mesh = { 0 };
+    mesh.vboId = (unsigned int *)RL_CALLOC(7, sizeof(unsigned int));
+
+    // NOTE: One vertex per grid point
+    mesh.triangleCount = (mapX-1)*(mapZ-1)*2;    // One quad every four grid points
+
+    mesh.vertexCount = mesh.triangleCount*3;
+
+    mesh.vertices = (float *)RL_MALLOC(mesh.vertexCount*3*sizeof(float));
+    mesh.normals = (float *)RL_MALLOC(mesh.vertexCount*3*sizeof(float));
+    mesh.texcoords = (float *)RL_MALLOC(mesh.vertexCount*2*sizeof(float));
+    mesh.colors = NULL;
+
+    int vCounter = 0;       // Used to count vertices float by float
+    int tcCounter = 0;      // Used to count texcoords float by float
+    int nCounter = 0;       // Used to count normals float by float
+
+    Vector3 scaleFactor = { size.x/mapX, size.y, size.z/mapZ };
+
+    Vector3 vA;
+    Vector3 vB;
+    Vector3 vC;
+    Vector3 vN;
+    
+    // since the size of the canvas is in multiples of model width and height, it may have more vertices than the grid has points. those are at height 0
+    auto gridValue = [&](int x, int z) -> float
+    {
+        x += startX;
+        z += startZ;
+        
+        if (x >= gridWidth || z >= gridHeight)
+            return 0;
+        
+        return heights[z * gridWidth + x];
+    };
+
+    for (int z = 0; z < mapZ-1; z++)
+    {
+        for (int x = 0; x < mapX-1; x++)
+        {
+            // Fill vertices array with data
+            //----------------------------------------------------------
+
+            // one triangle - 3 vertex
+            mesh.vertices[vCounter] = offset.x + (float)x*scaleFactor.x;
+            mesh.vertices[vCounter + 1] = gridValue(x, z)*scaleFactor.y;
+            mesh.vertices[vCounter + 2] = offset.y + (float)z*scaleFactor.z;
+
+            mesh.vertices[vCounter + 3] = offset.x + (float)x*scaleFactor.x;
+            mesh.vertices[vCounter + 4] = gridValue(x, z + 1)*scaleFactor.y;
+            mesh.vertices[vCounter + 5] = offset.y + (float)(z + 1)*scaleFactor.z;
+
+            mesh.vertices[vCounter + 6] = offset.x + (float)(x + 1)*scaleFactor.x;
+            mesh.vertices[vCounter + 7] = gridValue(x + 1, z)*scaleFactor.y;
+            mesh.vertices[vCounter + 8] = offset.y + (float)z*scaleFactor.z;
+
+            // another triangle - 3 vertex
+            mesh.vertices[vCounter + 9] = mesh.vertices[vCounter + 6];
+            mesh.vertices[vCounter + 10] = mesh.vertices[vCounter + 7];
+            mesh.vertices[vCounter + 11] = mesh.vertices[vCounter + 8];
+
+            mesh.vertices[vCounter + 12] = mesh.vertices[vCounter + 3];
+            mesh.vertices[vCounter + 13] = mesh.vertices[vCounter + 4];
+            mesh.vertices[vCounter + 14] = mesh.vertices[vCounter + 5];
+
+            mesh.vertices[vCounter + 15] = offset.x + (float)(x + 1)*scaleFactor.x;
+            mesh.vertices[vCounter + 16] = gridValue(x + 1, z + 1)*scaleFactor.y;
+            mesh.vertices[vCounter + 17] = offset.y + (float)(z + 1)*scaleFactor.z;
+            vCounter += 18;     // 6 vertex, 18 floats
+
+            // Fill texcoords array with data
+            //--------------------------------------------------------------
+            mesh.texcoords[tcCounter] = (float)x/(mapX - 1);
+            mesh.texcoords[tcCounter + 1] = (float)z/(mapZ - 1);
+
+            mesh.texcoords[tcCounter + 2] = (float)x/(mapX - 1);
+            mesh.texcoords[tcCounter + 3] = (float)(z + 1)/(mapZ - 1);
+
+            mesh.texcoords[tcCounter + 4] = (float)(x + 1)/(mapX - 1);
+            mesh.texcoords[tcCounter + 5] = (float)z/(mapZ - 1);
+
+            mesh.texcoords[tcCounter + 6] = mesh.texcoords[tcCounter + 4];
+            mesh.texcoords[tcCounter + 7] = mesh.texcoords[tcCounter + 5];
+
+            mesh.texcoords[tcCounter + 8] = mesh.texcoords[tcCounter + 2];
+            mesh.texcoords[tcCounter + 9] = mesh.texcoords[tcCounter + 3];
+
+            mesh.texcoords[tcCounter + 10] = (float)(x + 1)/(mapX - 1);
+            mesh.texcoords[tcCounter + 11] = (float)(z + 1)/(mapZ - 1);
+            tcCounter += 12;    // 6 texcoords, 12 floats
+
+            // Fill normals array with data
+            //--------------------------------------------------------------
+            for (int i = 0; i < 18; i += 9)
+            {
+                vA.x = mesh.vertices[nCounter + i];
+                vA.y = mesh.vertices[nCounter + i + 1];
+                vA.z = mesh.vertices[nCounter + i + 2];
+
+                vB.x = mesh.vertices[nCounter + i + 3];
+                vB.y = mesh.vertices[nCounter + i + 4];
+                vB.z = mesh.vertices[nCounter + i + 5];
+
+                vC.x = mesh.vertices[nCounter + i + 6];
+                vC.y = mesh.vertices[nCounter + i + 7];
+                vC.z = mesh.vertices[nCounter + i + 8];
+
+                vN = Vector3Normalize(Vector3CrossProduct(Vector3Subtract(vB, vA), Vector3Subtract(vC, vA)));
+
+                mesh.normals[nCounter + i] = vN.x;
+                mesh.normals[nCounter + i + 1] = vN.y;
+                mesh.normals[nCounter + i + 2] = vN.z;
+
+                mesh.normals[nCounter + i + 3] = vN.x;
+                mesh.normals[nCounter + i + 4] = vN.y;
+                mesh.normals[nCounter + i + 5] = vN.z;
+
+                mesh.normals[nCounter + i + 6] = vN.x;
+                mesh.normals[nCounter + i + 7] = vN.y;
+                mesh.normals[nCounter + i + 8] = vN.z;
+            }
+
+            nCounter += 18;     // 6 vertex, 18 floats
+        }
+    }
+
+    // Upload vertex data to GPU (static mesh)
+    if (upload)
+        rlLoadMesh(&mesh, false);
+
+    return mesh;
+}
+
+
+void MarkModelChanged(std::vector<std::vector<unsigned int>>& modelRevisions, int x, int y)
+{
+    if (modelRevisions.size() < x + 1)
+        modelRevisions.resize(x + 1);
+    
+    if (modelRevisions[x].size() < y + 1)
+        modelRevisions[x].resize(y + 1, 0);
+    
+    modelRevisions[x][y]++;
+}
+
+
+unsigned int GetModelRevision(const std::vector<std::vector<unsigned int>>& modelRevisions, int x, int y)
+{
+    if (x >= modelRevisions.size() || y >= modelRevisions[x].size())
+        return 0;
+    
+    return modelRevisions[x][y];
+}
+
+
+bool MapFile(MappedFile& map, const char* fileName)
+{
+    map.data = NULL;
+    map.size = 0;
+    
+#if defined(_WIN32)
+    map.fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    
+    if (map.fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+    
+    LARGE_INTEGER fileSize;
+    
+    if (!GetFileSizeEx(map.fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        CloseHandle(map.fileHandle);
+        return false;
+    }
+    
+    map.mappingHandle = CreateFileMappingA(map.fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    
+    if (!map.mappingHandle)
+    {
+        CloseHandle(map.fileHandle);
+        return false;
+    }
+    
+    map.data = (unsigned char*)MapViewOfFile(map.mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    
+    if (!map.data)
+    {
+        CloseHandle(map.mappingHandle);
+        CloseHandle(map.fileHandle);
+        return false;
+    }
+    
+    map.size = fileSize.QuadPart;
+#else
+    int file = open(fileName, O_RDONLY);
+    
+    if (file < 0)
+        return false;
+    
+    struct stat fileInfo;
+    
+    if (fstat(file, &fileInfo) != 0 || fileInfo.st_size == 0)
+    {
+        close(file);
+        return false;
+    }
+    
+    void* data = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file); // the mapping stays valid after the file is closed
+    
+    if (data == MAP_FAILED)
+        return false;
+    
+    map.data = (unsigned char*)data;
+    map.size = fileInfo.st_size;
+#endif
+    
+    return true;
+}
+
+
+void UnmapFile(MappedFile& map)
+{
+    if (!map.data)
+        return;
+    
+#if defined(_WIN32)
+    UnmapViewOfFile(map.data);
+    CloseHandle(map.mappingHandle);
+    CloseHandle(map.fileHandle);
+#else
+    munmap(map.data, map.size);
+#endif
+    
+    map.data = NULL;
+    map.size = 0;
+}
+
+
+bool SeekFile(FILE* file, unsigned long long offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(file, (long long)offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+
+void GetModelHeights(const Model& model, float* heights, int modelVertexWidth, int modelVertexHeight)
+{
+    DispatchTileGeometry(modelVertexWidth, modelVertexHeight, [&](const auto& geometry) { GetModelHeights(model, heights, geometry); });
+}
+
+
+template<class Geometry>
+void GetModelHeights(const Model& model, float* heights, const Geometry& geometry)
+{
+    const float* vertices = model.meshes[0].vertices;
+    
+    for (int z = 0; z < geometry.height - 1; z++) // every point but the last row and column is the first vertex of its quad, 18 floats apart
+    {
+        for (int x = 0; x < geometry.width - 1; x++)
+            heights[z * geometry.width + x] = vertices[(z * (geometry.width - 1) + x) * 18 + 1];
+        
+        heights[z * geometry.width + geometry.width - 1] = vertices[LatticeVertexIndex(geometry.width - 1, z, geometry) + 1];
+    }
+    
+    for (int x = 0; x < geometry.width; x++)
+        heights[(geometry.height - 1) * geometry.width + x] = vertices[LatticeVertexIndex(x, geometry.height - 1, geometry) + 1];
+}
+
+
+void PutLittleEndian(std::vector<unsigned char>& out, unsigned long long value, int size)
+{
+    for (int i = 0; i < size; i++)
+        out.push_back((value >> (i * 8)) & 0xFF);
+}
+
+
+void PutFloat(std::vector<unsigned char>& out, float value)
+{
+    unsigned int bits;
+    memcpy(&bits, &value, 4);
+    
+    PutLittleEndian(out, bits, 4);
+}
+
+
+unsigned long long GetLittleEndian(const unsigned char* data, int size)
+{
+    unsigned long long value = 0;
+    
+    for (int i = 0; i < size; i++)
+        value |= (unsigned long long)data[i] << (i * 8);
+    
+    return value;
+}
+
+
+float GetFloat(const unsigned char* data)
+{
+    unsigned int bits = GetLittleEndian(data, 4);
+    float value;
+    memcpy(&value, &bits, 4);
+    
+    return value;
+}
+
+
+std::vector<unsigned char> PackProjectHeader(const ProjectHeader& header)
+{
+    std::vector<unsigned char> out(header.magic, header.magic + 8);
+    
+    PutLittleEndian(out, header.version, 4);
+    PutLittleEndian(out, (unsigned int)header.canvasWidth, 4);
+    PutLittleEndian(out, (unsigned int)header.canvasHeight, 4);
+    PutLittleEndian(out, (unsigned int)header.modelVertexWidth, 4);
+    PutLittleEndian(out, (unsigned int)header.modelVertexHeight, 4);
+    PutLittleEndian(out, header.tileBlockSize, 4);
+    PutLittleEndian(out, header.tileIndexOffset, 8);
+    PutLittleEndian(out, header.trailerOffset, 8);
+    PutLittleEndian(out, header.trailerSize, 8);
+    
+    return out;
+}
+
+
+ProjectHeader UnpackProjectHeader(const unsigned char* data)
+{
+    ProjectHeader header;
+    
+    memcpy(header.magic, data, 8);
+    header.version = GetLittleEndian(data + 8, 4);
+    header.canvasWidth = (int)GetLittleEndian(data + 12, 4);
+    header.canvasHeight = (int)GetLittleEndian(data + 16, 4);
+    header.modelVertexWidth = (int)GetLittleEndian(data + 20, 4);
+    header.modelVertexHeight = (int)GetLittleEndian(data + 24, 4);
+    header.tileBlockSize = GetLittleEndian(data + 28, 4);
+    header.tileIndexOffset = GetLittleEndian(data + 32, 8);
+    header.trailerOffset = GetLittleEndian(data + 40, 8);
+    header.trailerSize = GetLittleEndian(data + 48, 8);
+    
+    return header;
+}
 
-void FindStampPoints(float stampRotationAngle, float stampStretchLength, Vector2& outVec1, Vector2& outVec2, Vector2 stampAnchor)
+
+void PackProjectTileEntry(std::vector<unsigned char>& out, const ProjectTileEntry& entry)
 {
-    float offsetX;
-    float offsetY;
-    // find the locations of stamp1 and stamp2 given the stretch length and rotation angle
-    if (stampRotationAngle == 0)
+    PutLittleEndian(out, entry.offset, 8);
+    PutLittleEndian(out, entry.size, 4);
+    PutFloat(out, entry.minY);
+    PutFloat(out, entry.maxY);
+    PutLittleEndian(out, entry.compressed, 4);
+}
+
+
+ProjectTileEntry UnpackProjectTileEntry(const unsigned char* data)
+{
+    ProjectTileEntry entry;
+    
+    entry.offset = GetLittleEndian(data, 8);
+    entry.size = GetLittleEndian(data + 8, 4);
+    entry.minY = GetFloat(data + 12);
+    entry.maxY = GetFloat(data + 16);
+    entry.compressed = GetLittleEndian(data + 20, 4);
+    
+    return entry;
+}
+
+
+bool MoveFileOver(const char* fromName, const char* toName)
+{
+#if defined(_WIN32)
+    return MoveFileExA(fromName, toName, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return rename(fromName, toName) == 0;
+#endif
+}
+
+
+FILE* OpenSharedFile(const char* fileName)
+{
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL); // fopen doesnt share delete, which MoveFileOver needs
+    
+    if (handle == INVALID_HANDLE_VALUE)
+        return NULL;
+    
+    int descriptor = _open_osfhandle((intptr_t)handle, _O_RDONLY | _O_BINARY);
+    
+    if (descriptor < 0)
+    {
+        CloseHandle(handle);
+        return NULL;
+    }
+    
+    FILE* file = _fdopen(descriptor, "rb");
+    
+    if (!file)
+        _close(descriptor);
+    
+    return file;
+#else
+    return fopen(fileName, "rb"); // a rename over it leaves this reading the old file
+#endif
+}
+
+
+std::vector<unsigned char> PackProjectTrailer(const ProjectSettings& settings, const ModelSelection& modelSelection, const std::vector<HistoryStep>& history, int stepIndex)
+{
+    std::vector<unsigned char> trailer;
+    
+    auto putVector2 = [&trailer](Vector2 v)
+    {
+        PutFloat(trailer, v.x);
+        PutFloat(trailer, v.y);
+    };
+    
+    auto putCoords = [&](const std::vector<Vector2>& coords)
+    {
+        PutLittleEndian(trailer, coords.size(), 4);
+        
+        for (int i = 0; i < coords.size(); i++)
+            putVector2(coords[i]);
+    };
+    
+    auto putVertices = [&](const std::vector<VertexState>& vertices)
+    {
+        PutLittleEndian(trailer, vertices.size(), 4);
+        
+        for (int i = 0; i < vertices.size(); i++)
+        {
+            putVector2(vertices[i].coords);
+            PutLittleEndian(trailer, (unsigned int)vertices[i].index, 4);
+            PutFloat(trailer, vertices[i].y);
+        }
+    };
+    
+    const float settingsFloats[] = { settings.selectRadius, settings.toolStrength, settings.stampAngle, settings.stampHeight, settings.innerRadius, settings.stampStretchLength, settings.stampRotationAngle, settings.stampSlope, settings.stampOffset };
+    const bool settingsBools[] = { settings.raiseOnly, settings.lowerOnly, settings.stampFlip, settings.stampInvert, settings.stampStretch, settings.rayCollision2d };
+    
+    for (int i = 0; i < sizeof(settingsFloats) / sizeof(settingsFloats[0]); i++)
+        PutFloat(trailer, settingsFloats[i]);
+    
+    PutLittleEndian(trailer, (unsigned int)settings.brush, 4);
+    PutLittleEndian(trailer, (unsigned int)settings.heightMapMode, 4);
+    
+    for (int i = 0; i < sizeof(settingsBools) / sizeof(settingsBools[0]); i++)
+        PutLittleEndian(trailer, settingsBools[i], 1);
+    
+    PutLittleEndian(trailer, 0, 2); // padding
+    
+    const Vector3 cameraVectors[] = { settings.cameraPosition, settings.cameraTarget };
+    
+    for (int i = 0; i < 2; i++)
+    {
+        PutFloat(trailer, cameraVectors[i].x);
+        PutFloat(trailer, cameraVectors[i].y);
+        PutFloat(trailer, cameraVectors[i].z);
+    }
+    
+    putVector2(modelSelection.topLeft);
+    putVector2(modelSelection.bottomRight);
+    PutLittleEndian(trailer, (unsigned int)modelSelection.width, 4);
+    PutLittleEndian(trailer, (unsigned int)modelSelection.height, 4);
+    putCoords(modelSelection.selection);
+    putCoords(modelSelection.expandedSelection);
+    
+    PutLittleEndian(trailer, history.size(), 4);
+    PutLittleEndian(trailer, (unsigned int)stepIndex, 4);
+    
+    for (int i = 0; i < history.size(); i++)
+    {
+        putVertices(history[i].startingVertices);
+        putVertices(history[i].endingVertices);
+        putCoords(history[i].modelCoords);
+    }
+    
+    return trailer;
+}
+
+
+bool WriteProject(Project& project, const char* fileName, const std::vector<std::vector<unsigned int>>& revisions, const std::vector<unsigned char>& trailer, const std::function<bool(int, int, float*)>& readHeights, int modelVertexWidth, int modelVertexHeight, bool compress)
+{
+    int canvasWidth = revisions.size();
+    int canvasHeight = canvasWidth ? revisions[0].size() : 0;
+    int tileCount = canvasWidth * canvasHeight;
+    
+    // only the changed models are written if this is the file that was last saved or opened and the canvas hasnt changed size since
+    bool incremental = project.fileName == fileName && project.canvasWidth == canvasWidth && project.canvasHeight == canvasHeight && project.modelVertexWidth == modelVertexWidth && project.modelVertexHeight == modelVertexHeight && FileExists(fileName);
+    
+    ProjectHeader header = { 0 };
+    memcpy(header.magic, PROJECT_MAGIC, 8);
+    header.version = PROJECT_VERSION;
+    header.canvasWidth = canvasWidth;
+    header.canvasHeight = canvasHeight;
+    header.modelVertexWidth = modelVertexWidth;
+    header.modelVertexHeight = modelVertexHeight;
+    header.tileBlockSize = (modelVertexWidth * modelVertexHeight * sizeof(float) + PROJECT_ALIGNMENT - 1) / PROJECT_ALIGNMENT * PROJECT_ALIGNMENT; // each model starts on a page so it can be mapped on its own
+    header.tileIndexOffset = PROJECT_HEADER_SIZE;
+    
+    unsigned long long firstTileOffset = (header.tileIndexOffset + tileCount * PROJECT_TILE_ENTRY_SIZE + PROJECT_ALIGNMENT - 1) / PROJECT_ALIGNMENT * PROJECT_ALIGNMENT;
+    
+    header.trailerOffset = firstTileOffset + (unsigned long long)tileCount * header.tileBlockSize;
+    header.trailerSize = trailer.size();
+    
+    FILE* previous = incremental ? fopen(fileName, "r+b") : NULL;
+    std::vector<ProjectTileEntry> index(tileCount);
+    unsigned long long previousEnd = 0; // where the last write's blocks and trailer end
+    
+    if (previous) // keep the entries of the models that arent written
+    {
+        unsigned char packedHeader[PROJECT_HEADER_SIZE];
+        std::vector<unsigned char> packed(tileCount * PROJECT_TILE_ENTRY_SIZE);
+        ProjectHeader last;
+        
+        bool read = fread(packedHeader, 1, PROJECT_HEADER_SIZE, previous) == PROJECT_HEADER_SIZE;
+        
+        if (read)
+        {
+            last = UnpackProjectHeader(packedHeader);
+            read = memcmp(last.magic, PROJECT_MAGIC, 8) == 0 && last.tileBlockSize == header.tileBlockSize && last.tileIndexOffset == header.tileIndexOffset;
+        }
+        
+        if (read && SeekFile(previous, header.tileIndexOffset) && fread(packed.data(), 1, packed.size(), previous) == packed.size())
+        {
+            previousEnd = last.trailerOffset + last.trailerSize;
+            
+            for (int i = 0; i < tileCount; i++)
+            {
+                index[i] = UnpackProjectTileEntry(&packed[i * PROJECT_TILE_ENTRY_SIZE]);
+                
+                if (index[i].offset + index[i].size > previousEnd)
+                    previousEnd = index[i].offset + index[i].size;
+            }
+        }
+        else
+        {
+            fclose(previous);
+            previous = NULL;
+        }
+    }
+    
+    incremental = previous != NULL;
+    
+    std::vector<float> heights(modelVertexWidth * modelVertexHeight); // one model at a time
+    unsigned char* compressed = NULL;
+    
+    auto readBlock = [&](int x, int y, ProjectTileEntry& entry) -> const unsigned char* // a changed model's heights as they are written, compressed if that makes them smaller. fills in all of entry but the offset. NULL if readHeights couldnt read them
+    {
+        if (compressed)
+            RL_FREE(compressed);
+        
+        compressed = NULL;
+        entry.size = heights.size() * sizeof(float);
+        entry.compressed = 0;
+        
+        if (!readHeights(x, y, heights.data()))
+            return NULL;
+        
+        entry.minY = FLT_MAX;
+        entry.maxY = -FLT_MAX;
+        
+        for (int k = 0; k < heights.size(); k++)
+        {
+            if (heights[k] < entry.minY) entry.minY = heights[k];
+            if (heights[k] > entry.maxY) entry.maxY = heights[k];
+        }
+        
+        int compressedSize = 0;
+        compressed = compress ? CompressData((unsigned char*)heights.data(), entry.size, &compressedSize) : NULL;
+        
+        if (compressed && compressedSize > 0 && compressedSize < entry.size) // still fits the model's block, so a rewrite can copy it as it is
+        {
+            entry.size = compressedSize;
+            entry.compressed = 1;
+            
+            return compressed;
+        }
+        
+        return (const unsigned char*)heights.data();
+    };
+    
+    auto writeIndex = [&](FILE* file) -> bool // the index and then the header, each flushed before the next
+    {
+        std::vector<unsigned char> packedIndex;
+        packedIndex.reserve(tileCount * PROJECT_TILE_ENTRY_SIZE);
+        
+        for (int i = 0; i < tileCount; i++)
+            PackProjectTileEntry(packedIndex, index[i]);
+        
+        std::vector<unsigned char> packedHeader = PackProjectHeader(header);
+        
+        return SeekFile(file, header.tileIndexOffset) && fwrite(packedIndex.data(), 1, packedIndex.size(), file) == packedIndex.size() && fflush(file) == 0 &&
+               SeekFile(file, 0) && fwrite(packedHeader.data(), 1, packedHeader.size(), file) == packedHeader.size() && fflush(file) == 0;
+    };
+    
+    int changedCount = 0;
+    
+    for (int i = 0; i < canvasWidth; i++)
+    {
+        for (int j = 0; j < canvasHeight; j++)
+        {
+            if (!incremental || revisions[i][j] != project.savedRevisions[i][j])
+                changedCount++;
+        }
+    }
+    
+    unsigned long long appendOffset = (previousEnd + PROJECT_ALIGNMENT - 1) / PROJECT_ALIGNMENT * PROJECT_ALIGNMENT;
+    bool success;
+    
+    // the changed models go on the end of the file, past anything the last write points at, so the blocks the pager reads from never change under it. the index and then the header are written over last
+    // a save that fails before then leaves the file as the last one. one that fails in the index leaves entries from one save or the other, each still a whole block
+    // once the blocks left behind would make the file more than twice the size of a fresh one, it is rewritten instead
+    if (incremental && appendOffset + (unsigned long long)changedCount * header.tileBlockSize + trailer.size() <= 2 * (header.trailerOffset + trailer.size()))
+    {
+        success = true;
+        
+        for (int i = 0; i < canvasWidth; i++)
+        {
+            for (int j = 0; j < canvasHeight; j++)
+            {
+                if (revisions[i][j] == project.savedRevisions[i][j])
+                    continue;
+                
+                ProjectTileEntry& entry = index[i * canvasHeight + j];
+                const unsigned char* data = readBlock(i, j, entry);
+                
+                entry.offset = appendOffset;
+                appendOffset += header.tileBlockSize;
+                
+                success = success && data && SeekFile(previous, entry.offset) && fwrite(data, 1, entry.size, previous) == entry.size;
+            }
+        }
+        
+        header.trailerOffset = appendOffset;
+        
+        success = success && SeekFile(previous, header.trailerOffset) && fwrite(trailer.data(), 1, trailer.size(), previous) == trailer.size() && fflush(previous) == 0;
+        success = success && writeIndex(previous);
+        success = fclose(previous) == 0 && success;
+    }
+    else
+    {
+        // the unchanged models are copied across from the last write, to a temporary file so a rewrite that fails partway leaves the last save whole
+        std::string temporaryName = std::string(fileName) + ".tmp";
+        FILE* file = fopen(temporaryName.c_str(), "wb");
+        
+        if (!file)
+        {
+            if (previous)
+                fclose(previous);
+            
+            return false;
+        }
+        
+        std::vector<unsigned char> block; // an unchanged model's heights on their way across
+        success = true;
+        
+        for (int i = 0; i < canvasWidth; i++)
+        {
+            for (int j = 0; j < canvasHeight; j++)
+            {
+                ProjectTileEntry& entry = index[i * canvasHeight + j];
+                unsigned long long offset = firstTileOffset + (unsigned long long)(i * canvasHeight + j) * header.tileBlockSize;
+                const unsigned char* data;
+                
+                if (incremental && revisions[i][j] == project.savedRevisions[i][j])
+                {
+                    block.resize(entry.size);
+                    
+                    if (entry.size > header.tileBlockSize || !SeekFile(previous, entry.offset) || fread(block.data(), 1, entry.size, previous) != entry.size)
+                        success = false;
+                    
+                    data = block.data();
+                }
+                else
+                    data = readBlock(i, j, entry);
+                
+                entry.offset = offset;
+                
+                success = success && data && SeekFile(file, entry.offset) && fwrite(data, 1, entry.size, file) == entry.size;
+            }
+        }
+        
+        if (previous)
+            fclose(previous);
+        
+        // the trailer holds everything but the heights. it is small so it is always rewritten
+        success = success && SeekFile(file, header.trailerOffset) && fwrite(trailer.data(), 1, trailer.size(), file) == trailer.size();
+        success = success && writeIndex(file);
+        success = fclose(file) == 0 && success;
+        success = success && MoveFileOver(temporaryName.c_str(), fileName);
+        
+        if (!success) // the last save is left as it was
+            remove(temporaryName.c_str());
+    }
+    
+    if (compressed)
+        RL_FREE(compressed);
+    
+    if (success)
+    {
+        project.fileName = fileName;
+        project.canvasWidth = canvasWidth;
+        project.modelVertexWidth = modelVertexWidth;
+        project.modelVertexHeight = modelVertexHeight;
+        project.canvasHeight = canvasHeight;
+        project.savedRevisions = revisions;
+    }
+    
+    return success;
+}
+
+
+bool SaveProject(Project& project, const char* fileName, const std::vector<std::vector<Model>>& models, const std::vector<std::vector<unsigned int>>& modelRevisions, const ProjectSettings& settings, const ModelSelection& modelSelection, const std::vector<HistoryStep>& history, int stepIndex, int modelVertexWidth, int modelVertexHeight)
+{
+    int canvasWidth = models.size();
+    int canvasHeight = canvasWidth ? models[0].size() : 0;
+    
+    std::vector<std::vector<unsigned int>> revisions(canvasWidth, std::vector<unsigned int>(canvasHeight));
+    
+    for (int i = 0; i < canvasWidth; i++)
+    {
+        for (int j = 0; j < canvasHeight; j++)
+            revisions[i][j] = GetModelRevision(modelRevisions, i, j);
+    }
+    
+    auto readHeights = [&](int x, int y, float* heights) -> bool
+    {
+        return ReadModelHeights(models, x, y, heights, modelVertexWidth, modelVertexHeight); // paged out models are read from the page file rather than loaded
+    };
+    
+    return WriteProject(project, fileName, revisions, PackProjectTrailer(settings, modelSelection, history, stepIndex), readHeights, modelVertexWidth, modelVertexHeight, false); // left uncompressed so the pager can read its models straight into their heights
+}
+
+
+bool OpenProject(Project& project, const char* fileName, std::vector<std::vector<Model>>& models, std::vector<std::vector<unsigned int>>& modelRevisions, ProjectSettings& settings, ModelSelection& modelSelection, std::vector<HistoryStep>& history, int& stepIndex, int& modelVertexWidth, int& modelVertexHeight, int modelWidth, int modelHeight, float& highestY, float& lowestY)
+{
+    MappedFile map;
+    
+    if (!MapFile(map, fileName)) // only the header, index and trailer are read out of the mapping. the heights are left to the pager
+        return false;
+    
+    ProjectHeader header;
+    
+    bool valid = map.size >= PROJECT_HEADER_SIZE;
+    
+    if (valid)
+    {
+        header = UnpackProjectHeader(map.data);
+        
+        unsigned long long tileCount = (unsigned long long)header.canvasWidth * header.canvasHeight;
+        
+        valid = memcmp(header.magic, PROJECT_MAGIC, 8) == 0 && header.version >= 1 && header.version <= PROJECT_VERSION &&
+                header.modelVertexWidth >= 2 && header.modelVertexHeight >= 2 && header.modelVertexWidth <= TILE_RESOLUTION_MAX && header.modelVertexHeight <= TILE_RESOLUTION_MAX &&
+                header.canvasWidth > 0 && header.canvasHeight > 0 &&
+                header.tileIndexOffset <= map.size && tileCount * PROJECT_TILE_ENTRY_SIZE <= map.size - header.tileIndexOffset &&
+                header.trailerOffset <= map.size && header.trailerSize <= map.size - header.trailerOffset;
+    }
+    
+    std::vector<ProjectTileEntry> index(valid ? header.canvasWidth * header.canvasHeight : 0);
+    
+    for (int i = 0; i < index.size(); i++)
+    {
+        index[i] = UnpackProjectTileEntry(map.data + header.tileIndexOffset + (unsigned long long)i * PROJECT_TILE_ENTRY_SIZE);
+        
+        if (header.version < 2)
+            index[i].compressed = 0;
+    }
+    
+    unsigned int heightsSize = valid ? header.modelVertexWidth * header.modelVertexHeight * sizeof(float) : 0;
+    
+    for (int i = 0; valid && i < index.size(); i++)
+    {
+        if (index[i].offset % sizeof(float) != 0 || (index[i].compressed ? index[i].size == 0 || index[i].size > heightsSize : index[i].size != heightsSize) || index[i].offset + index[i].size > map.size || !(index[i].minY <= index[i].maxY))
+            valid = false;
+    }
+    
+    // read the trailer into temporaries first so a bad file leaves the current canvas alone
+    ProjectSettings newSettings;
+    ModelSelection newSelection;
+    std::vector<HistoryStep> newHistory;
+    int newStepIndex = 0;
+    
+    if (valid)
+    {
+        const unsigned char* trailer = map.data + header.trailerOffset;
+        unsigned long long position = 0;
+        
+        auto readBytes = [&](int size) -> unsigned long long // 0 once the trailer has run out
+        {
+            if (!valid || position + size > header.trailerSize)
+                return valid = false;
+            
+            unsigned long long value = GetLittleEndian(trailer + position, size);
+            position += size;
+            
+            return value;
+        };
+        
+        auto readFloat = [&]() -> float
+        {
+            if (!valid || position + 4 > header.trailerSize)
+                return valid = false;
+            
+            float value = GetFloat(trailer + position);
+            position += 4;
+            
+            return value;
+        };
+        
+        auto readVector2 = [&]() -> Vector2
+        {
+            float x = readFloat();
+            
+            return Vector2{x, readFloat()};
+        };
+        
+        auto validCoords = [&](Vector2 coords) -> bool // a model on the project's canvas
+        {
+            return coords.x >= 0 && coords.y >= 0 && coords.x < header.canvasWidth && coords.y < header.canvasHeight && coords.x == (int)coords.x && coords.y == (int)coords.y;
+        };
+        
+        auto readCoords = [&](std::vector<Vector2>& coords)
+        {
+            unsigned int count = readBytes(4);
+            
+            if (count * 8ull > header.trailerSize - position)
+                valid = false;
+            
+            for (int i = 0; valid && i < count; i++)
+            {
+                coords.push_back(readVector2());
+                valid = valid && validCoords(coords.back());
+            }
+        };
+        
+        int vertexCount = (header.modelVertexWidth - 1) * (header.modelVertexHeight - 1) * 6; // of each model's mesh, the vertex indices index its floats
+        
+        auto readVertices = [&](std::vector<VertexState>& vertices)
+        {
+            unsigned int count = readBytes(4);
+            
+            if (count * 16ull > header.trailerSize - position)
+                valid = false;
+            
+            for (int i = 0; valid && i < count; i++)
+            {
+                VertexState vertex;
+                vertex.coords = readVector2();
+                vertex.index = (int)readBytes(4);
+                vertex.y = readFloat();
+                
+                valid = valid && validCoords(vertex.coords) && vertex.index >= 0 && vertex.index < vertexCount * 3 && vertex.index % 3 == 0;
+                vertices.push_back(vertex);
+            }
+        };
+        
+        float* settingsFloats[] = { &newSettings.selectRadius, &newSettings.toolStrength, &newSettings.stampAngle, &newSettings.stampHeight, &newSettings.innerRadius, &newSettings.stampStretchLength, &newSettings.stampRotationAngle, &newSettings.stampSlope, &newSettings.stampOffset };
+        bool* settingsBools[] = { &newSettings.raiseOnly, &newSettings.lowerOnly, &newSettings.stampFlip, &newSettings.stampInvert, &newSettings.stampStretch, &newSettings.rayCollision2d };
+        
+        for (int i = 0; i < sizeof(settingsFloats) / sizeof(settingsFloats[0]); i++)
+            *settingsFloats[i] = readFloat();
+        
+        newSettings.brush = (int)readBytes(4);
+        newSettings.heightMapMode = (int)readBytes(4);
+        
+        for (int i = 0; i < sizeof(settingsBools) / sizeof(settingsBools[0]); i++)
+            *settingsBools[i] = readBytes(1) != 0;
+        
+        readBytes(2); // padding
+        
+        Vector3* cameraVectors[] = { &newSettings.cameraPosition, &newSettings.cameraTarget };
+        
+        for (int i = 0; i < 2; i++)
+        {
+            cameraVectors[i]->x = readFloat();
+            cameraVectors[i]->y = readFloat();
+            cameraVectors[i]->z = readFloat();
+        }
+        
+        if (newSettings.brush < (int)BrushTool::NONE || newSettings.brush > (int)BrushTool::SELECT || newSettings.heightMapMode < (int)HeightMapMode::GRAYSCALE || newSettings.heightMapMode > (int)HeightMapMode::RAINBOW)
+            valid = false;
+        
+        newSelection.topLeft = readVector2();
+        newSelection.bottomRight = readVector2();
+        newSelection.width = (int)readBytes(4);
+        newSelection.height = (int)readBytes(4);
+        readCoords(newSelection.selection);
+        readCoords(newSelection.expandedSelection);
+        
+        unsigned int stepCount = readBytes(4);
+        newStepIndex = (int)readBytes(4);
+        
+        for (int i = 0; valid && i < stepCount; i++)
+        {
+            HistoryStep step;
+            
+            readVertices(step.startingVertices);
+            readVertices(step.endingVertices);
+            readCoords(step.modelCoords);
+            
+            newHistory.push_back(step);
+        }
+        
+        if (newStepIndex < 0 || newStepIndex > newHistory.size())
+            valid = false;
+    }
+    
+    FILE* source = valid ? OpenSharedFile(fileName) : NULL; // the pager reads the heights from here as their models are needed
+    
+    UnmapFile(map);
+    
+    if (!source)
+        return false;
+    
+    for (int i = 0; i < models.size(); i++)
+    {
+        for (int j = 0; j < models[i].size(); j++)
+            UnloadModel(models[i][j]);
+    }
+    
+    models.clear();
+    models.assign(header.canvasWidth, std::vector<Model>(header.canvasHeight, (Model){ 0 })); // every model starts out paged out
+    
+    modelVertexWidth = header.modelVertexWidth; // the canvas takes on the project's model size
+    modelVertexHeight = header.modelVertexHeight;
+    
+    ResetPager(modelVertexWidth, modelVertexHeight);
+    BindPagerProject(source, index);
+    
+    highestY = -FLT_MAX; // the canvas' range is known from the index without reading any heights
+    lowestY = FLT_MAX;
+    
+    for (int i = 0; i < header.canvasWidth; i++)
+    {
+        for (int j = 0; j < header.canvasHeight; j++)
+        {
+            const ProjectTileEntry& entry = index[i * header.canvasHeight + j];
+            
+            PagedModel& page = GetPagedModel(i, j);
+            page.block = i * header.canvasHeight + j;
+            page.minY = entry.minY;
+            page.maxY = entry.maxY;
+            
+            if (entry.maxY > highestY) highestY = entry.maxY;
+            if (entry.minY < lowestY) lowestY = entry.minY;
+        }
+    }
+    
+    // only the models around the saved camera are loaded before the project is shown. UpdatePager brings in the rest near the camera in the background
+    float cameraX = floorf(newSettings.cameraPosition.x / (modelWidth - (1 / (float)modelVertexWidth) * modelWidth)); // model the camera is over
+    float cameraY = floorf(newSettings.cameraPosition.z / (modelHeight - (1 / (float)modelVertexHeight) * modelHeight));
+    
+    for (int i = 0; i < header.canvasWidth; i++)
     {
-        offsetX = 0;
-        offsetY = stampStretchLength/2;
+        for (int j = 0; j < header.canvasHeight; j++)
+        {
+            if (fabsf(i - cameraX) <= PAGER_OPEN_RADIUS && fabsf(j - cameraY) <= PAGER_OPEN_RADIUS)
+                RequireModel(i, j);
+        }
     }
-    else if (stampRotationAngle > 0 && stampRotationAngle < 90)
+    
+    settings = newSettings;
+    modelSelection = newSelection;
+    history = newHistory;
+    stepIndex = newStepIndex;
+    
+    for (int i = 0; i < header.canvasWidth; i++)
     {
-        float a = 90 - stampRotationAngle;
-        
-        offsetX = ((stampStretchLength / 2) * sinf(stampRotationAngle*DEG2RAD));
-        offsetY = ((stampStretchLength / 2) * sinf(a*DEG2RAD));
+        for (int j = 0; j < header.canvasHeight; j++)
+            MarkModelChanged(modelRevisions, i, j); // every model is new to the autosave
     }
-    else if (stampRotationAngle == 90)
+    
+    project.fileName = fileName;
+    project.canvasWidth = header.canvasWidth;
+    project.modelVertexWidth = header.modelVertexWidth;
+    project.modelVertexHeight = header.modelVertexHeight;
+    project.canvasHeight = header.canvasHeight;
+    project.savedRevisions.assign(header.canvasWidth, std::vector<unsigned int>(header.canvasHeight));
+    
+    for (int i = 0; i < header.canvasWidth; i++)
     {
-        offsetX = stampStretchLength/2;
-        offsetY = 0;
+        for (int j = 0; j < header.canvasHeight; j++)
+            project.savedRevisions[i][j] = modelRevisions[i][j]; // everything on the canvas now matches the file
     }
-    else if (stampRotationAngle > 90 && stampRotationAngle < 180)
+    
+    return true;
+}
+
+
+void BindPager(std::vector<std::vector<Model>>& models, float& highestY, float& lowestY, HeightMapMode& heightMapMode, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight)
+{
+    pager.models = &models;
+    pager.highestY = &highestY;
+    pager.lowestY = &lowestY;
+    pager.heightMapMode = &heightMapMode;
+    pager.modelVertexWidth = modelVertexWidth;
+    pager.modelVertexHeight = modelVertexHeight;
+    pager.modelWidth = modelWidth;
+    pager.modelHeight = modelHeight;
+    
+    pager.fileName = std::string(GetWorkingDirectory()) + "/" + PAGER_FILE_NAME; // full path, the working directory can be changed later
+    pager.file = fopen(pager.fileName.c_str(), "w+b");
+    
+    if (!pager.file)
+        TraceLog(LOG_WARNING, "PAGER: couldnt create %s, every model will stay loaded", pager.fileName.c_str());
+    
+    pager.worker = std::thread(PagerWorker);
+}
+
+
+void ShutdownPager()
+{
     {
-        float b = stampRotationAngle - 90;
-        float a = 90 - b;
-        
-        offsetX = ((stampStretchLength / 2) * sinf(a*DEG2RAD));
-        offsetY = -((stampStretchLength / 2) * sinf(b*DEG2RAD));
+        std::lock_guard<std::mutex> lock(pager.mutex);
+        pager.quit = true;
     }
-    else if (stampRotationAngle == 180)
+    
+    pager.wake.notify_one();
+    
+    if (pager.worker.joinable())
+        pager.worker.join();
+    
+    for (int i = 0; i < pager.results.size(); i++)
     {
-        offsetX = 0;
-        offsetY = -stampStretchLength/2;
+        if (pager.results[i].mesh.vertices)
+            UnloadMesh(pager.results[i].mesh);
     }
-    else if (stampRotationAngle > 180 && stampRotationAngle < 270)
+    
+    pager.results.clear();
+    pager.requests.clear();
+    
+    if (pager.file)
     {
-        float b = stampRotationAngle - 180;
-        float a = 90 - b;
-        
-        offsetX = -((stampStretchLength / 2) * sinf(b*DEG2RAD));
-        offsetY = -((stampStretchLength / 2) * sinf(a*DEG2RAD));
+        fclose(pager.file);
+        remove(pager.fileName.c_str());
+        pager.file = NULL;
     }
-    else if (stampRotationAngle == 270)
+    
+    if (pager.projectFile)
     {
-        offsetX = -stampStretchLength/2;
-        offsetY = 0;
+        fclose(pager.projectFile);
+        pager.projectFile = NULL;
     }
-    else if (stampRotationAngle > 270)
+}
+
+
+void ResetPager(int modelVertexWidth, int modelVertexHeight)
+{
+    std::unique_lock<std::mutex> lock(pager.mutex);
+    
+    pager.requests.clear();
+    
+    if (modelVertexWidth != pager.modelVertexWidth || modelVertexHeight != pager.modelVertexHeight)
     {
-        float b = stampRotationAngle - 270;
-        float a = 90 - b;
+        pager.done.wait(lock, []{ return !pager.busy; }); // the load in flight was sized for the old models
         
-        offsetX = -((stampStretchLength / 2) * sinf(a*DEG2RAD));
-        offsetY = ((stampStretchLength / 2) * sinf(b*DEG2RAD));
+        pager.modelVertexWidth = modelVertexWidth;
+        pager.modelVertexHeight = modelVertexHeight;
     }
     
-    outVec1 = Vector2{stampAnchor.x + offsetX, stampAnchor.y + offsetY};
-    outVec2 = Vector2{stampAnchor.x - offsetX, stampAnchor.y - offsetY};
+    for (int i = 0; i < pager.results.size(); i++)
+    {
+        if (pager.results[i].mesh.vertices)
+            UnloadMesh(pager.results[i].mesh);
+    }
     
-    return;
+    pager.results.clear();
+    pager.generation++; // a load still in flight is thrown away when it finishes
+    pager.pages.clear();
+    pager.slotCount = 0; // old slots get written over
+    
+    std::lock_guard<std::mutex> fileLock(pager.fileMutex);
+    
+    if (pager.projectFile)
+    {
+        fclose(pager.projectFile);
+        pager.projectFile = NULL;
+    }
+    
+    pager.projectIndex.clear();
 }
 
 
-float PointSegmentDistance(Vector2 point, Vector2 segmentPoint1, Vector2 segmentPoint2)
+void BindPagerProject(FILE* file, const std::vector<ProjectTileEntry>& index)
 {
-    float a = point.x - segmentPoint1.x;
-    float b = point.y - segmentPoint1.y;
-    float c = segmentPoint2.x - segmentPoint1.x;
-    float d = segmentPoint2.y - segmentPoint1.y;
+    std::lock_guard<std::mutex> lock(pager.fileMutex);
+    
+    if (pager.projectFile)
+        fclose(pager.projectFile);
+    
+    pager.projectFile = file;
+    pager.projectIndex = index;
+}
 
-    float dot = a * c + b * d;
-    float len_sq = c * c + d * d;
-    float p = -1;
+
+bool ModelLoaded(const Model& model)
+{
+    return model.meshCount > 0;
+}
+
+
+PagedModel& GetPagedModel(int x, int y)
+{
+    if (pager.pages.size() < x + 1)
+        pager.pages.resize(x + 1);
     
-    if (len_sq != 0) 
-      p = dot / len_sq;
+    if (pager.pages[x].size() < y + 1)
+        pager.pages[x].resize(y + 1);
+    
+    return pager.pages[x][y];
+}
 
-    float xx;
-    float yy;
 
-    if (p < 0)
-    {
-        xx = segmentPoint1.x;
-        yy = segmentPoint1.y;
-    }
-    else if (p > 1) 
-    {
-        xx = segmentPoint2.x;
-        yy = segmentPoint2.y;
-    }
-    else 
+void RequireModel(int x, int y)
+{
+    if (!pager.models)
+        return;
+    
+    std::vector<std::vector<Model>>& models = *pager.models;
+    
+    if (x < 0 || y < 0 || x >= models.size() || y >= models[x].size())
+        return;
+    
+    PreserveModel(x, y); // anything about to edit a model comes through here first
+    
+    if (!ModelLoaded(models[x][y]) && std::this_thread::get_id() == simulation.thread.get_id()) // the gl calls are the main thread's, it loads the model while this waits
+        LoadForSimulation(x, y);
+    
+    if (!ModelLoaded(models[x][y]))
     {
-        xx = segmentPoint1.x + p * c;
-        yy = segmentPoint1.y + p * d;
+        if (GetPagedModel(x, y).loading) // already on its way. take it off the queue, or wait for it if the worker has it
+        {
+            std::unique_lock<std::mutex> lock(pager.mutex);
+            
+            for (int i = 0; i < pager.requests.size(); i++)
+            {
+                if (pager.requests[i].x == x && pager.requests[i].y == y)
+                {
+                    pager.requests.erase(pager.requests.begin() + i);
+                    break;
+                }
+            }
+            
+            pager.done.wait(lock, [x, y]{ return !pager.busy || pager.current.x != x || pager.current.y != y; });
+        }
+        
+        FinishPageLoads(INT_MAX); // it may be sitting in the results
+        
+        if (!ModelLoaded(models[x][y])) // load it here and now
+        {
+            PagedModel& page = GetPagedModel(x, y);
+            page.loading = false;
+            
+            std::vector<float> heights(pager.modelVertexWidth * pager.modelVertexHeight);
+            
+            if (!ReadPage(page.slot, page.block, heights.data()))
+                return;
+            
+            float xOffset = (float)x * (pager.modelWidth - (1 / (float)pager.modelVertexWidth) * pager.modelWidth);
+            float zOffset = (float)y * (pager.modelHeight - (1 / (float)pager.modelVertexHeight) * pager.modelHeight);
+            
+            FinishPageLoad(x, y, GenMeshHeightGrid(heights.data(), pager.modelVertexWidth, pager.modelVertexHeight, 0, 0, pager.modelVertexWidth, pager.modelVertexHeight, (Vector3){ (float)pager.modelWidth, 1, (float)pager.modelHeight }, Vector2{xOffset, zOffset}, !displacementGrid.enabled)); // displaced, it stays on the cpu
+        }
     }
-
-    float dx = point.x - xx;
-    float dy = point.y - yy;
     
-    return sqrt(dx * dx + dy * dy);    
+    GetPagedModel(x, y).lastUsed = pager.tick;
 }
 
 
-Mesh CopyMesh(const Mesh& mesh)
+void RequireModels(const std::vector<Vector2>& modelCoords)
 {
-    // (doesnt copy animation data)
-    Mesh newMesh = { 0 };
-    newMesh.vboId = (unsigned int *)RL_CALLOC(7, sizeof(unsigned int)); // (MAX_MESH_VBO = 7)
+    for (int i = 0; i < modelCoords.size(); i++)
+        RequireModel(modelCoords[i].x, modelCoords[i].y);
+}
+
+
+bool ReadPage(long long slot, long long block, float* heights)
+{
+    int count = pager.modelVertexWidth * pager.modelVertexHeight;
     
-    newMesh.vertexCount = mesh.vertexCount;
-    newMesh.triangleCount = mesh.triangleCount;
+    std::lock_guard<std::mutex> lock(pager.fileMutex);
     
-    newMesh.vertices = (float *)RL_MALLOC(mesh.vertexCount*3*sizeof(float));
-    newMesh.normals = (float *)RL_MALLOC(mesh.vertexCount*3*sizeof(float));
-    newMesh.texcoords = (float *)RL_MALLOC(mesh.vertexCount*2*sizeof(float));
-    newMesh.colors = NULL;
+    if (slot >= 0)
+        return SeekFile(pager.file, (unsigned long long)slot * count * sizeof(float)) && fread(heights, sizeof(float), count, pager.file) == count;
     
-    for (int i = 0; i < mesh.vertexCount*3; i++)
+    if (block < 0 || block >= pager.projectIndex.size() || !pager.projectFile)
+        return false;
+    
+    const ProjectTileEntry& entry = pager.projectIndex[block];
+    
+    if (!entry.compressed)
+        return SeekFile(pager.projectFile, entry.offset) && fread(heights, sizeof(float), count, pager.projectFile) == count;
+    
+    std::vector<unsigned char> data(entry.size);
+    
+    if (!SeekFile(pager.projectFile, entry.offset) || fread(data.data(), 1, entry.size, pager.projectFile) != entry.size)
+        return false;
+    
+    int inflatedSize = 0;
+    unsigned char* inflated = DecompressData(data.data(), entry.size, &inflatedSize);
+    
+    if (inflated && inflatedSize == count * sizeof(float))
+        memcpy(heights, inflated, inflatedSize);
+    else // leave this model flat rather than have it requested again every frame
     {
-        newMesh.vertices[i] = mesh.vertices[i];
+        TraceLog(LOG_WARNING, "PROJECT: block %lli couldnt be decompressed", block);
+        memset(heights, 0, count * sizeof(float));
     }
     
-    for (int i = 0; i < mesh.vertexCount*3; i++)
+    if (inflated)
+        RL_FREE(inflated);
+    
+    return true;
+}
+
+
+void PageOutModel(int x, int y)
+{
+    PreserveModel(x, y);
+    
+    Model& model = (*pager.models)[x][y];
+    PagedModel& page = GetPagedModel(x, y);
+    
+    int count = pager.modelVertexWidth * pager.modelVertexHeight;
+    std::vector<float> heights(count);
+    
+    GetModelHeights(model, heights.data(), pager.modelVertexWidth, pager.modelVertexHeight);
+    
+    if (page.slot < 0)
+        page.slot = pager.slotCount++;
+    
+    bool written;
+    
     {
-        newMesh.normals[i] = mesh.normals[i];
+        std::lock_guard<std::mutex> lock(pager.fileMutex);
+        
+        written = SeekFile(pager.file, (unsigned long long)page.slot * count * sizeof(float)) && fwrite(heights.data(), sizeof(float), count, pager.file) == count && fflush(pager.file) == 0;
     }
     
-    for (int i = 0; i < mesh.vertexCount*2; i++)
+    if (!written) // keep it loaded rather than lose its heights
+        return;
+    
+    page.minY = FLT_MAX;
+    page.maxY = -FLT_MAX;
+    
+    for (int i = 0; i < count; i++)
     {
-        newMesh.texcoords[i] = mesh.texcoords[i];
+        if (heights[i] < page.minY) page.minY = heights[i];
+        if (heights[i] > page.maxY) page.maxY = heights[i];
     }
     
-    rlLoadMesh(&newMesh, false);
+    UnloadModel(model);
+    model = (Model){ 0 };
+}
+
+
+void FinishPageLoad(int x, int y, Mesh mesh)
+{
+    Model model = LoadModelFromMesh(mesh);
     
-    return newMesh;
+    TextureTile(model, pager.modelVertexWidth, pager.modelVertexHeight, *pager.highestY, *pager.lowestY, *pager.heightMapMode);
+    (*pager.models)[x][y] = model;
+    
+    PagedModel& page = GetPagedModel(x, y);
+    page.loading = false;
+    page.lastUsed = pager.tick;
 }
 
 
-void Smooth(std::vector<std::vector<Model>>& models, const std::vector<VertexState>& vertices, int modelVertexWidth, int modelVertexHeight, int canvasWidth, int canvasHeight)
+int FinishPageLoads(int maxLoads)
 {
-    std::vector<VertexState> changes; //  calculate and then make changes all at once rather than one at a time
+    std::vector<PageLoad> finished;
+    int uploaded = 0;
     
-    for (int i = 0; i < vertices.size(); ++i)
     {
-        Vector2 coords = GetVertexCoords(vertices[i].index, modelVertexWidth);
+        std::lock_guard<std::mutex> lock(pager.mutex);
         
-        std::vector<float> yValues;
+        int count = maxLoads < pager.results.size() ? maxLoads : pager.results.size();
         
-        if (coords.x != 0) // dont attempt x = -1
-        {
-            int index = GetVertexIndices(coords.x - 1, coords.y, modelVertexWidth)[0];
-            
-            yValues.push_back(models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[index + 1]);   
-        }
-        else if (coords.x == 0 && (vertices[i].coords.x > 0)) // if the vertex x coord is 0, check if there is another model to the left
+        finished.assign(pager.results.begin(), pager.results.begin() + count);
+        pager.results.erase(pager.results.begin(), pager.results.begin() + count);
+    }
+    
+    std::vector<std::vector<Model>>& models = *pager.models;
+    
+    for (int i = 0; i < finished.size(); i++)
+    {
+        PageLoad& load = finished[i];
+        
+        // the canvas may have been replaced, resized or the model loaded some other way since it was requested
+        bool stale = load.generation != pager.generation || load.x >= models.size() || load.y >= models[load.x].size() || ModelLoaded(models[load.x][load.y]);
+        
+        if (!stale)
+            GetPagedModel(load.x, load.y).loading = false;
+        
+        if (!load.mesh.vertices) // the page couldnt be read. it will be requested again
+            continue;
+        
+        if (stale)
         {
-            int index = GetVertexIndices(modelVertexWidth - 2, coords.y, modelVertexWidth)[0]; // get the index of the vertex in the other model
-            
-            yValues.push_back(models[vertices[i].coords.x - 1][vertices[i].coords.y].meshes[0].vertices[index + 1]);
+            UnloadMesh(load.mesh);
+            continue;
         }
         
-        if (coords.x != modelVertexWidth - 1) // dont attempt out of bounds x
+        if (!displacementGrid.enabled)
+            rlLoadMesh(&load.mesh, false);
+        
+        FinishPageLoad(load.x, load.y, load.mesh);
+        uploaded++;
+    }
+    
+    return uploaded;
+}
+
+
+void PagerWorker()
+{
+    std::vector<float> heights;
+    
+    while (true)
+    {
+        PageLoad load;
+        
         {
-            int index = GetVertexIndices(coords.x + 1, coords.y, modelVertexWidth)[0];
+            std::unique_lock<std::mutex> lock(pager.mutex);
             
-            yValues.push_back(models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[index + 1]);
-        }
-        else if (coords.x == modelVertexWidth - 1 && (vertices[i].coords.x < canvasWidth - 1)) // if the vertex x coord is at max width, check if there is another model to the right
-        {
-            int index = GetVertexIndices(1, coords.y, modelVertexWidth)[0]; // get the index of the vertex in the other model
+            pager.wake.wait(lock, []{ return pager.quit || !pager.requests.empty(); });
             
-            yValues.push_back(models[vertices[i].coords.x + 1][vertices[i].coords.y].meshes[0].vertices[index + 1]);                                   
-        }
-        
-        if (coords.y != 0) // dont attempt y = -1
-        {
-            int index = GetVertexIndices(coords.x, coords.y - 1, modelVertexWidth)[0];
+            if (pager.quit)
+                return;
             
-            yValues.push_back(models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[index + 1]);    
-        }
-        else if (coords.y == 0 && (vertices[i].coords.y > 0)) // if the vertex y coord is at the top, check if there is a model above
-        {
-            int index = GetVertexIndices(coords.x, modelVertexHeight - 2, modelVertexWidth)[0]; // get the index of the vertex in the other model
+            load = pager.requests.front();
+            pager.requests.pop_front();
             
-            yValues.push_back(models[vertices[i].coords.x][vertices[i].coords.y - 1].meshes[0].vertices[index + 1]);
+            pager.current = load;
+            pager.busy = true;
         }
         
-        if (coords.y != modelVertexHeight - 1) // dont attempt out of bounds y
-        {
-            int index = GetVertexIndices(coords.x, coords.y + 1, modelVertexWidth)[0];
-            
-            yValues.push_back(models[vertices[i].coords.x][vertices[i].coords.y].meshes[0].vertices[index + 1]);
-        }
-        else if (coords.y == modelVertexHeight - 1 && (vertices[i].coords.y < canvasHeight - 1)) // if the vertex y coord is at the bottom, check if there is a model below
+        load.mesh = (Mesh){ 0 };
+        heights.resize(pager.modelVertexWidth * pager.modelVertexHeight); // only changes while nothing is being loaded
+        
+        if (ReadPage(load.slot, load.block, heights.data())) // the mesh is built here, only the upload is left to the main thread since it owns the gl context
         {
-            int index = GetVertexIndices(coords.x, 1, modelVertexWidth)[0]; // get the index of the vertex in the other model
+            float xOffset = (float)load.x * (pager.modelWidth - (1 / (float)pager.modelVertexWidth) * pager.modelWidth);
+            float zOffset = (float)load.y * (pager.modelHeight - (1 / (float)pager.modelVertexHeight) * pager.modelHeight);
             
-            yValues.push_back(models[vertices[i].coords.x][vertices[i].coords.y + 1].meshes[0].vertices[index + 1]);
+            load.mesh = GenMeshHeightGrid(heights.data(), pager.modelVertexWidth, pager.modelVertexHeight, 0, 0, pager.modelVertexWidth, pager.modelVertexHeight, (Vector3){ (float)pager.modelWidth, 1, (float)pager.modelHeight }, Vector2{xOffset, zOffset}, false);
         }
         
-        float average = 0;
-        
-        for (int i = 0; i < yValues.size(); i++)
         {
-            average += yValues[i];
+            std::lock_guard<std::mutex> lock(pager.mutex);
+            
+            pager.results.push_back(load);
+            pager.busy = false;
         }
-        
-        average = average / (float)yValues.size();
-        
-        VertexState temp;
-        temp.coords = vertices[i].coords;
-        temp.index = vertices[i].index;
-        temp.y = average;
-        
-        changes.push_back(temp);
-    }
-
-    for (int i = 0; i < changes.size(); i++) // enact all changes 
-    {
-        models[changes[i].coords.x][changes[i].coords.y].meshes[0].vertices[changes[i].index + 1] = changes[i].y;   
+        
+        pager.done.notify_all();
     }
-    
-    return;
 }
 
 
-unsigned long PixelToHeight(Color pixel)
+int TrimPager()
 {
-    std::bitset<32> heightValueBits;
-    int heightValueIndex = 0;
+    if (!pager.models || !pager.file)
+        return 0;
     
-    std::bitset<8> redPixels(pixel.r);
+    std::vector<std::vector<Model>>& models = *pager.models;
+    std::vector<Vector2> candidates; // loaded models that werent used this frame
+    int loaded = 0;
     
-    for (int i = 0; i < 8; i++)
+    for (int i = 0; i < models.size(); i++)
     {
-        heightValueBits[heightValueIndex] = redPixels[i];
-        heightValueIndex++;
+        for (int j = 0; j < models[i].size(); j++)
+        {
+            if (!ModelLoaded(models[i][j]))
+                continue;
+            
+            loaded++;
+            
+            if (GetPagedModel(i, j).lastUsed < pager.tick)
+                candidates.push_back(Vector2{(float)i, (float)j});
+        }
     }
     
-    std::bitset<8> greenPixels(pixel.g);
+    if (loaded <= PAGER_RESIDENT_MODELS)
+        return 0;
     
-    for (int i = 0; i < 8; i++)
+    std::sort(candidates.begin(), candidates.end(), [](const Vector2& a, const Vector2& b){ return pager.pages[a.x][a.y].lastUsed < pager.pages[b.x][b.y].lastUsed; }); // least recently used first
+    
+    int pagedOut = 0;
+    
+    for (int i = 0; i < candidates.size() && loaded > PAGER_RESIDENT_MODELS; i++)
     {
-        heightValueBits[heightValueIndex] = greenPixels[i];
-        heightValueIndex++;
+        PageOutModel(candidates[i].x, candidates[i].y);
+        loaded--;
+        pagedOut++;
     }
     
-    std::bitset<8> bluePixels(pixel.b);
+    return pagedOut;
+}
+
+
+bool UpdatePager(Vector3 cameraPosition)
+{
+    if (!pager.models)
+        return false;
     
-    for (int i = 0; i < 8; i++)
+    pager.tick++;
+    
+    int uploaded = FinishPageLoads(PAGER_UPLOADS_PER_FRAME);
+    
+    std::vector<std::vector<Model>>& models = *pager.models;
+    
+    if (models.empty())
+        return uploaded > 0;
+    
+    float realModelWidth = pager.modelWidth - (1 / (float)pager.modelVertexWidth) * pager.modelWidth; // modelWidth minus the width of one polygon
+    float realModelHeight = pager.modelHeight - (1 / (float)pager.modelVertexHeight) * pager.modelHeight;
+    
+    int cameraX = (int)floorf(cameraPosition.x / realModelWidth); // model the camera is over
+    int cameraY = (int)floorf(cameraPosition.z / realModelHeight);
+    
+    std::vector<PageLoad> requests;
+    
+    for (int ring = 0; ring <= PAGER_PREFETCH_RADIUS; ring++) // nearest models first
     {
-        heightValueBits[heightValueIndex] = bluePixels[i];
-        heightValueIndex++;
+        for (int i = cameraX - ring; i <= cameraX + ring; i++)
+        {
+            for (int j = cameraY - ring; j <= cameraY + ring; j++)
+            {
+                if (abs(i - cameraX) != ring && abs(j - cameraY) != ring) // only the edge of this ring
+                    continue;
+                
+                if (i < 0 || j < 0 || i >= models.size() || j >= models[i].size())
+                    continue;
+                
+                PagedModel& page = GetPagedModel(i, j);
+                page.lastUsed = pager.tick;
+                
+                if (!ModelLoaded(models[i][j]) && !page.loading && (page.slot >= 0 || page.block >= 0))
+                {
+                    page.loading = true;
+                    
+                    PageLoad load = { i, j, page.slot, page.block, pager.generation };
+                    requests.push_back(load);
+                }
+            }
+        }
     }
     
-    std::bitset<8> alphaPixels(pixel.a);
-    
-    for (int i = 0; i < 8; i++)
     {
-        heightValueBits[heightValueIndex] = alphaPixels[i];
-        heightValueIndex++;
+        std::lock_guard<std::mutex> lock(pager.mutex);
+        
+        for (int i = 0; i < pager.requests.size(); i++) // drop requests the camera has moved away from before they started
+        {
+            const PageLoad& load = pager.requests[i];
+            
+            if (abs(load.x - cameraX) > PAGER_PREFETCH_RADIUS || abs(load.y - cameraY) > PAGER_PREFETCH_RADIUS)
+            {
+                if (load.generation == pager.generation)
+                    GetPagedModel(load.x, load.y).loading = false;
+                
+                pager.requests.erase(pager.requests.begin() + i);
+                i--;
+            }
+        }
+        
+        pager.requests.insert(pager.requests.end(), requests.begin(), requests.end());
     }
     
-    return heightValueBits.to_ulong();
+    if (!requests.empty())
+        pager.wake.notify_one();
+    
+    int pagedOut = TrimPager();
+    
+    return uploaded > 0 || pagedOut > 0;
 }
 
 
-Mesh GenMeshHeightmap32bit(Image heightmap, Vector3 size)
+bool FaultInRay(const Ray& ray, float maxDistance)
 {
-    Mesh mesh = { 0 };
-    mesh.vboId = (unsigned int *)RL_CALLOC(7, sizeof(unsigned int));
-
-    int mapX = heightmap.width;
-    int mapZ = heightmap.height;
-
-    Color *pixels = GetImageData(heightmap);
-
-    // NOTE: One vertex per pixel
-    mesh.triangleCount = (mapX-1)*(mapZ-1)*2;    // One quad every four pixels
-
-    mesh.vertexCount = mesh.triangleCount*3;
-
-    mesh.vertices = (float *)RL_MALLOC(mesh.vertexCount*3*sizeof(float));
-    mesh.normals = (float *)RL_MALLOC(mesh.vertexCount*3*sizeof(float));
-    mesh.texcoords = (float *)RL_MALLOC(mesh.vertexCount*2*sizeof(float));
-    mesh.colors = NULL;
-
-    int vCounter = 0;       // Used to count vertices float by float
-    int tcCounter = 0;      // Used to count texcoords float by float
-    int nCounter = 0;       // Used to count normals float by float
-
-    int trisCounter = 0;
-
-    Vector3 scaleFactor = { size.x/mapX, size.y/2147483647.f, size.z/mapZ };
-
-    Vector3 vA;
-    Vector3 vB;
-    Vector3 vC;
-    Vector3 vN;
-
-    for (int z = 0; z < mapZ-1; z++)
+    if (!pager.models)
+        return false;
+    
+    std::vector<std::vector<Model>>& models = *pager.models;
+    
+    float realModelWidth = pager.modelWidth - (1 / (float)pager.modelVertexWidth) * pager.modelWidth;
+    float realModelHeight = pager.modelHeight - (1 / (float)pager.modelVertexHeight) * pager.modelHeight;
+    
+    float origin[3] = { ray.position.x, ray.position.y, ray.position.z };
+    float direction[3] = { ray.direction.x, ray.direction.y, ray.direction.z };
+    
+    std::vector<std::pair<float, Vector2>> hits; // distance to each paged out model whose bounds the ray enters
+    
+    for (int i = 0; i < models.size(); i++)
     {
-        for (int x = 0; x < mapX-1; x++)
+        for (int j = 0; j < models[i].size(); j++)
         {
-            // Fill vertices array with data
-            //----------------------------------------------------------
-
-            // one triangle - 3 vertex
+            if (ModelLoaded(models[i][j]))
+                continue;
             
-            unsigned long heightValue = PixelToHeight(pixels[x + z*mapX]);
+            const PagedModel& page = GetPagedModel(i, j);
             
-            mesh.vertices[vCounter] = (float)x*scaleFactor.x;
-            mesh.vertices[vCounter + 1] = (float)heightValue*scaleFactor.y;
-            mesh.vertices[vCounter + 2] = (float)z*scaleFactor.z;
+            float low[3] = { i * realModelWidth, page.minY, j * realModelHeight };
+            float high[3] = { (i + 1) * realModelWidth, page.maxY, (j + 1) * realModelHeight };
             
-            unsigned long heightValue2 = PixelToHeight(pixels[x + (z + 1)*mapX]);
-
-            mesh.vertices[vCounter + 3] = (float)x*scaleFactor.x;
-            mesh.vertices[vCounter + 4] = (float)heightValue2*scaleFactor.y;
-            mesh.vertices[vCounter + 5] = (float)(z + 1)*scaleFactor.z;
+            float entry = 0;
+            float exit = maxDistance;
+            bool hit = true;
             
-            unsigned long heightValue3 = PixelToHeight(pixels[(x + 1) + z*mapX]);
-
-            mesh.vertices[vCounter + 6] = (float)(x + 1)*scaleFactor.x;
-            mesh.vertices[vCounter + 7] = (float)heightValue3*scaleFactor.y;
-            mesh.vertices[vCounter + 8] = (float)z*scaleFactor.z;
-
-            // another triangle - 3 vertex
-            mesh.vertices[vCounter + 9] = mesh.vertices[vCounter + 6];
-            mesh.vertices[vCounter + 10] = mesh.vertices[vCounter + 7];
-            mesh.vertices[vCounter + 11] = mesh.vertices[vCounter + 8];
-
-            mesh.vertices[vCounter + 12] = mesh.vertices[vCounter + 3];
-            mesh.vertices[vCounter + 13] = mesh.vertices[vCounter + 4];
-            mesh.vertices[vCounter + 14] = mesh.vertices[vCounter + 5];
+            for (int axis = 0; axis < 3 && hit; axis++) // slab test
+            {
+                if (fabsf(direction[axis]) < 0.000001f)
+                {
+                    if (origin[axis] < low[axis] || origin[axis] > high[axis])
+                        hit = false;
+                }
+                else
+                {
+                    float t1 = (low[axis] - origin[axis]) / direction[axis];
+                    float t2 = (high[axis] - origin[axis]) / direction[axis];
+                    
+                    if (t1 > t2)
+                        std::swap(t1, t2);
+                    
+                    if (t1 > entry) entry = t1;
+                    if (t2 < exit) exit = t2;
+                    
+                    if (entry > exit)
+                        hit = false;
+                }
+            }
             
-            unsigned long heightValue4 = PixelToHeight(pixels[(x + 1) + (z + 1)*mapX]);
-
-            mesh.vertices[vCounter + 15] = (float)(x + 1)*scaleFactor.x;
-            mesh.vertices[vCounter + 16] = (float)heightValue4*scaleFactor.y;
-            mesh.vertices[vCounter + 17] = (float)(z + 1)*scaleFactor.z;
-            vCounter += 18;     // 6 vertex, 18 floats
-
-            // Fill texcoords array with data
-            //--------------------------------------------------------------
-            mesh.texcoords[tcCounter] = (float)x/(mapX - 1);
-            mesh.texcoords[tcCounter + 1] = (float)z/(mapZ - 1);
-
-            mesh.texcoords[tcCounter + 2] = (float)x/(mapX - 1);
-            mesh.texcoords[tcCounter + 3] = (float)(z + 1)/(mapZ - 1);
-
-            mesh.texcoords[tcCounter + 4] = (float)(x + 1)/(mapX - 1);
-            mesh.texcoords[tcCounter + 5] = (float)z/(mapZ - 1);
+            if (hit)
+                hits.push_back(std::make_pair(entry, Vector2{(float)i, (float)j}));
+        }
+    }
+    
+    std::sort(hits.begin(), hits.end(), [](const std::pair<float, Vector2>& a, const std::pair<float, Vector2>& b){ return a.first < b.first; });
+    
+    for (int i = 0; i < hits.size() && i < PAGER_RAY_FAULTS; i++)
+        RequireModel(hits[i].second.x, hits[i].second.y);
+    
+    return !hits.empty();
+}
 
-            mesh.texcoords[tcCounter + 6] = mesh.texcoords[tcCounter + 4];
-            mesh.texcoords[tcCounter + 7] = mesh.texcoords[tcCounter + 5];
 
-            mesh.texcoords[tcCounter + 8] = mesh.texcoords[tcCounter + 2];
-            mesh.texcoords[tcCounter + 9] = mesh.texcoords[tcCounter + 3];
+bool ReadModelHeights(const std::vector<std::vector<Model>>& models, int x, int y, float* heights, int modelVertexWidth, int modelVertexHeight)
+{
+    if (ModelLoaded(models[x][y]))
+    {
+        GetModelHeights(models[x][y], heights, modelVertexWidth, modelVertexHeight);
+        return true;
+    }
+    
+    if (&models != pager.models || x >= pager.pages.size() || y >= pager.pages[x].size())
+        return false;
+    
+    return ReadPage(pager.pages[x][y].slot, pager.pages[x][y].block, heights);
+}
 
-            mesh.texcoords[tcCounter + 10] = (float)(x + 1)/(mapX - 1);
-            mesh.texcoords[tcCounter + 11] = (float)(z + 1)/(mapZ - 1);
-            tcCounter += 12;    // 6 texcoords, 12 floats
 
-            // Fill normals array with data
-            //--------------------------------------------------------------
-            for (int i = 0; i < 18; i += 9)
+void GetCanvasHeightRange(const std::vector<std::vector<Model>>& models, float& minY, float& maxY)
+{
+    minY = FLT_MAX;
+    maxY = -FLT_MAX;
+    
+    for (int i = 0; i < models.size(); i++)
+    {
+        for (int j = 0; j < models[i].size(); j++)
+        {
+            if (ModelLoaded(models[i][j]))
             {
-                vA.x = mesh.vertices[nCounter + i];
-                vA.y = mesh.vertices[nCounter + i + 1];
-                vA.z = mesh.vertices[nCounter + i + 2];
-
-                vB.x = mesh.vertices[nCounter + i + 3];
-                vB.y = mesh.vertices[nCounter + i + 4];
-                vB.z = mesh.vertices[nCounter + i + 5];
+                for (int k = 0; k < (models[i][j].meshes[0].vertexCount * 3) - 2; k += 3) // check this models vertices
+                {
+                    if (models[i][j].meshes[0].vertices[k + 1] > maxY)
+                        maxY = models[i][j].meshes[0].vertices[k + 1];
+                    
+                    if (models[i][j].meshes[0].vertices[k + 1] < minY)
+                        minY = models[i][j].meshes[0].vertices[k + 1];
+                }
+            }
+            else if (&models == pager.models && i < pager.pages.size() && j < pager.pages[i].size())
+            {
+                if (pager.pages[i][j].maxY > maxY)
+                    maxY = pager.pages[i][j].maxY;
+                
+                if (pager.pages[i][j].minY < minY)
+                    minY = pager.pages[i][j].minY;
+            }
+        }
+    }
+}
 
-                vC.x = mesh.vertices[nCounter + i + 6];
-                vC.y = mesh.vertices[nCounter + i + 7];
-                vC.z = mesh.vertices[nCounter + i + 8];
 
-                vN = Vector3Normalize(Vector3CrossProduct(Vector3Subtract(vB, vA), Vector3Subtract(vC, vA)));
+void StartAutosave(const std::vector<std::vector<Model>>& models, const std::vector<std::vector<unsigned int>>& modelRevisions, const ProjectSettings& settings, const ModelSelection& modelSelection, const std::vector<HistoryStep>& history, int stepIndex, int modelVertexWidth, int modelVertexHeight)
+{
+    if (autosave.running || models.empty()) // the last one is still being written
+        return;
+    
+    if (autosave.writer.joinable())
+        autosave.writer.join();
+    
+    if (autosave.fileName.empty())
+        autosave.fileName = std::string(GetWorkingDirectory()) + "/" + AUTOSAVE_FILE_NAME;
+    
+    int canvasWidth = models.size();
+    int canvasHeight = models[0].size();
+    
+    // same rule WriteProject uses to decide whether it can append only the changed models. anything it rewrites whole has to be in the snapshot
+    bool incremental = autosave.project.fileName == autosave.fileName && autosave.project.canvasWidth == canvasWidth && autosave.project.canvasHeight == canvasHeight && autosave.project.modelVertexWidth == modelVertexWidth && autosave.project.modelVertexHeight == modelVertexHeight;
+    bool changed = false;
+    
+    autosave.revisions.assign(canvasWidth, std::vector<unsigned int>(canvasHeight));
+    autosave.models.assign(canvasWidth, std::vector<SnapshotModel>(canvasHeight));
+    
+    for (int i = 0; i < canvasWidth; i++)
+    {
+        for (int j = 0; j < canvasHeight; j++)
+        {
+            autosave.revisions[i][j] = GetModelRevision(modelRevisions, i, j);
+            
+            if (incremental && autosave.revisions[i][j] == autosave.project.savedRevisions[i][j])
+                continue;
+            
+            SnapshotModel& snapshot = autosave.models[i][j];
+            snapshot.state = SnapshotState::PENDING; // nothing is copied yet, the model itself is the snapshot until it changes
+            
+            if (!ModelLoaded(models[i][j]))
+            {
+                snapshot.slot = GetPagedModel(i, j).slot;
+                snapshot.block = GetPagedModel(i, j).block;
+            }
+            
+            changed = true;
+        }
+    }
+    
+    if (!changed)
+        return;
+    
+    autosave.trailer = PackProjectTrailer(settings, modelSelection, history, stepIndex);
+    autosave.running = true;
+    autosave.writer = std::thread(AutosaveWriter, modelVertexWidth, modelVertexHeight);
+}
 
-                mesh.normals[nCounter + i] = vN.x;
-                mesh.normals[nCounter + i + 1] = vN.y;
-                mesh.normals[nCounter + i + 2] = vN.z;
 
-                mesh.normals[nCounter + i + 3] = vN.x;
-                mesh.normals[nCounter + i + 4] = vN.y;
-                mesh.normals[nCounter + i + 5] = vN.z;
+void PreserveModel(int x, int y)
+{
+    if (!autosave.running)
+        return;
+    
+    std::lock_guard<std::mutex> lock(autosave.mutex);
+    
+    if (x >= autosave.models.size() || y >= autosave.models[x].size() || autosave.models[x][y].state != SnapshotState::PENDING)
+        return;
+    
+    SnapshotModel& snapshot = autosave.models[x][y];
+    snapshot.heights.resize(pager.modelVertexWidth * pager.modelVertexHeight);
+    
+    if (snapshot.slot >= 0 || snapshot.block >= 0) // the page file doesnt change until the model is paged out again, which comes through here first. project blocks never change
+        ReadPage(snapshot.slot, snapshot.block, snapshot.heights.data());
+    else
+        GetModelHeights((*pager.models)[x][y], snapshot.heights.data(), pager.modelVertexWidth, pager.modelVertexHeight);
+    
+    snapshot.state = SnapshotState::COPIED;
+}
 
-                mesh.normals[nCounter + i + 6] = vN.x;
-                mesh.normals[nCounter + i + 7] = vN.y;
-                mesh.normals[nCounter + i + 8] = vN.z;
-            }
 
-            nCounter += 18;     // 6 vertex, 18 floats
-            trisCounter += 2;
+void AutosaveWriter(int modelVertexWidth, int modelVertexHeight)
+{
+    auto readHeights = [&](int x, int y, float* heights) -> bool
+    {
+        std::lock_guard<std::mutex> lock(autosave.mutex); // the main thread cant start changing the model while it is read
+        
+        SnapshotModel& snapshot = autosave.models[x][y];
+        bool read = true;
+        
+        if (snapshot.state == SnapshotState::NONE) // unchanged since the last autosave, so it was left out of the snapshot. WriteProject only asks for it if it couldnt append to the file after all
+            return false;
+        else if (snapshot.state == SnapshotState::COPIED)
+        {
+            memcpy(heights, snapshot.heights.data(), snapshot.heights.size() * sizeof(float));
+            std::vector<float>().swap(snapshot.heights);
         }
-    }
-
-    RL_FREE(pixels);
+        else if (snapshot.slot >= 0 || snapshot.block >= 0)
+            read = ReadPage(snapshot.slot, snapshot.block, heights);
+        else
+            GetModelHeights((*pager.models)[x][y], heights, modelVertexWidth, modelVertexHeight);
+        
+        snapshot.state = SnapshotState::WRITTEN;
+        
+        return read;
+    };
+    
+    if (!WriteProject(autosave.project, autosave.fileName.c_str(), autosave.revisions, autosave.trailer, readHeights, modelVertexWidth, modelVertexHeight, true))
+        autosave.project = Project(); // write everything again next time
+    
+    std::lock_guard<std::mutex> lock(autosave.mutex);
+    
+    autosave.models.clear();
+    autosave.running = false;
+}
 
-    // Upload vertex data to GPU (static mesh)
-    rlLoadMesh(&mesh, false);
 
-    return mesh;
+void FinishAutosave()
+{
+    if (autosave.writer.joinable())
+        autosave.writer.join();
 }
 
 
@@ -4982,17 +11684,15 @@ void UpdateTopDownCamera(Camera* camera)
 }
 
 
-RayHitInfo FindHit2D(const Ray& ray, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight)
+RayHitInfo FindHit2D(const Ray& ray, const std::vector<std::vector<Model>>& models, int modelVertexWidth, int modelVertexHeight, int modelWidth, int modelHeight, float height)
 {
-    RayHitInfo hitPosition = GetCollisionRayGround(ray, 0);
+    RayHitInfo hitPosition = GetCollisionRayGround(ray, height);
     
-    int index1 = GetVertexIndices(modelVertexWidth - 1, 0, modelVertexWidth)[0]; // index of the top right vertex
-    int index2 = GetVertexIndices(0, modelVertexHeight - 1, modelVertexWidth)[0]; // index of the bottom left vertex
-    
-    float leftX = models[0][0].meshes[0].vertices[0];
-    float rightX = models[models.size() - 1][0].meshes[0].vertices[index1];
-    float topY = models[0][0].meshes[0].vertices[2];
-    float bottomY = models[0][models[0].size() - 1].meshes[0].vertices[index2 + 2];
+    // canvas bounds from the layout rather than the corner models' vertices, which may be paged out
+    float leftX = 0;
+    float rightX = models.size() * (modelWidth - (1 / (float)modelVertexWidth) * modelWidth);
+    float topY = 0;
+    float bottomY = models[0].size() * (modelHeight - (1 / (float)modelVertexHeight) * modelHeight);
     
     if (hitPosition.position.x < leftX || hitPosition.position.x > rightX || hitPosition.position.z < topY || hitPosition.position.z > bottomY) // if the hit position is outside of the model boundary, mark as false
     {
@@ -5148,11 +11848,12 @@ RayHitInfo FindHit3D(const Ray& ray, const std::vector<std::vector<Model>>& mode
 }
 
 
-ModelSelection FindModelSelection(int canvasWidth, int canvasHeight, int modelWidth, Vector2 modelCoords, float selectRadius)
+void FindModelSelection(ModelSelection& modelSelection, int canvasWidth, int canvasHeight, int modelWidth, int modelVertexWidth, Vector2 modelCoords, float selectRadius)
 {
-    ModelSelection modelSelection;
+    modelSelection.selection.clear();
+    modelSelection.expandedSelection.clear();
     
-    float realModelWidth = modelWidth - (1 / 120.f) * modelWidth; // modelWidth minus the width of one polygon. ASSUMES MODELVERTEXWIDTH = 120
+    float realModelWidth = modelWidth - (1 / (float)modelVertexWidth) * modelWidth; // modelWidth minus the width of one polygon
     int modelCheckRadius = ceil((selectRadius * 1.05) / realModelWidth); // how many models out from the model at modelCoords to check for vertices based on selectRadius plus a 5% margin. ASSUMES MODEL WIDTH = HEIGHT
     
     modelSelection.topLeft.y = modelCoords.y - modelCheckRadius; // top most model coordinate to be checked
@@ -5177,8 +11878,6 @@ ModelSelection FindModelSelection(int canvasWidth, int canvasHeight, int modelWi
             modelSelection.selection.push_back(Vector2{i + modelSelection.topLeft.x, j + modelSelection.topLeft.y});
         }
     }
-    
-    return modelSelection;
 }
 
 
@@ -5224,6 +11923,13 @@ void FinalizeHistoryStep(HistoryStep& historyStep, const std::vector<std::vector
 
 
 void UpdateNormals(Model& model, int modelVertexWidth, int modelVertexHeight)
+{
+    DispatchTileGeometry(modelVertexWidth, modelVertexHeight, [&](const auto& geometry) { UpdateNormals(model, geometry); });
+}
+
+
+template<class Geometry>
+void UpdateNormals(Model& model, const Geometry& geometry)
 {
     int nCounter = 0;       // Used to count normals float by float
 
@@ -5232,9 +11938,9 @@ void UpdateNormals(Model& model, int modelVertexWidth, int modelVertexHeight)
     Vector3 vC;
     Vector3 vN;
     
-    for (int z = 0; z < modelVertexHeight-1; z++)
+    for (int z = 0; z < geometry.height-1; z++)
     {
-        for (int x = 0; x < modelVertexWidth-1; x++)
+        for (int x = 0; x < geometry.width-1; x++)
         {
             for (int i = 0; i < 18; i += 9)
             {